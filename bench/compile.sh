@@ -0,0 +1,95 @@
+#!/bin/sh
+#
+# Compile time benchmark of the plugin on synthetic control flow graphs.
+#
+# Usage: compile.sh <mpicc> <plugin> <gencfg> <measure> <work dir> [<size>...]
+#
+# For each shape and size, a source file is generated by gencfg, then compiled
+# without and with the plugin. Wall times in seconds and peak memory in KiB are
+# printed as CSV, followed by the wall time in seconds of each phase of the
+# plugin reported by -ftime-report. A compilation running longer than
+# BENCH_TIMEOUT seconds (300 by default) is stopped and reported as a timeout, a
+# failed one as an error.
+
+if [ $# -lt 5 ]
+then
+    echo "Usage: $0 <mpicc> <plugin> <gencfg> <measure> <work dir> [<size>...]" >&2
+    exit 1
+fi
+
+mpicc="$1"
+plugin="$2"
+gencfg="$3"
+measure="$4"
+dir="$5"
+shift 5
+
+sizes="${*:-8 16 32 64 128}"
+timeout="${BENCH_TIMEOUT:-300}"
+
+# Phase names, as timevar names in include/phases.def
+phases=$(sed -n 's/^DEF_MPICOLL_PHASE([^,]*, "\(.*\)")$/\1/p' \
+             "$(dirname "$0")/../include/phases.def")
+
+# Shapes are gencfg options, the size being the number of diamonds
+shapes="diamonds:-l0 loops:-l4 switch:-l1_-s8 collectives:-l1_-c4"
+
+# Compiles the source file $1 with the remaining options and prints the wall
+# time and peak memory, timeout or error.
+compile()
+{
+    src="$1"
+    shift
+
+    res=$(timeout "${timeout}" "${measure}" ${mpicc} -c -o /dev/null \
+                  "$@" "${src}" 2>"${src}.report")
+
+    case $? in
+        0)   echo "${res}" ;;
+        124) echo "timeout,NA" ;;
+        *)   echo "error,NA" ;;
+    esac
+}
+
+# Prints the wall time of each phase in the -ftime-report output $1.
+report()
+{
+    echo "${phases}" | while read -r phase
+    do
+        awk -v phase="${phase}" -F ':' '
+            { name = $1; gsub(/^ +| +$/, "", name) }
+            name == phase {
+                gsub(/\([^)]*\)/, "", $2)
+                split($2, times, " ")
+                wall = times[3]
+            }
+            END { printf(",%s", wall == "" ? "NA" : wall) }' "$1"
+    done
+}
+
+mkdir -p "${dir}"
+printf "shape,size,baseline_s,baseline_KiB,plugin_s,plugin_KiB"
+echo "${phases}" | while read -r phase
+do
+    printf ",%s_s" "$(echo "${phase}" | tr ' ' '_' | tr -d "'")"
+done
+echo
+
+for shape in ${shapes}
+do
+    name="${shape%%:*}"
+    options=$(echo "${shape#*:}" | tr '_' ' ')
+
+    for size in ${sizes}
+    do
+        src="${dir}/gencfg-${name}-${size}.c"
+        "${gencfg}" -d "${size}" ${options} > "${src}"
+
+        baseline=$(compile "${src}")
+        with=$(compile "${src}" -fplugin="${plugin}" -ftime-report)
+
+        echo "${name},${size},${baseline},${with}$(report "${src}.report")"
+    done
+done
+
+exit 0
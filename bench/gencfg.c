@@ -0,0 +1,188 @@
+/*
+ * Synthetic control flow graph generator for compile time benchmarks.
+ * Copyright (C) 2023-2025 Antoni Blanche
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include <stdlib.h>
+#include <stdio.h>
+#include <unistd.h>
+
+/*
+ * Shape of the generated functions.
+ */
+struct shape {
+        int functions;          /* Number of functions */
+        int diamonds;           /* Rank-dependent diamonds per function */
+        int depth;              /* Depth of the loop nest around diamonds */
+        int fanout;             /* Cases of the switch after each diamond */
+        int collectives;        /* MPI collectives per block */
+};
+
+/*
+ * MPI collectives called in generated blocks, in turn.
+ */
+static const char *const COLLECTIVES[] = {
+        "MPI_Barrier(MPI_COMM_WORLD);",
+        "MPI_Reduce(&v, &s, 1, MPI_DOUBLE, MPI_SUM, 0, MPI_COMM_WORLD);",
+        "MPI_Allreduce(&v, &s, 1, MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD);",
+};
+
+#define NB_COLLECTIVES (int) (sizeof(COLLECTIVES) / sizeof(char *))
+
+/*
+ * Prints indent levels of indentation.
+ */
+static void indent(const int levels)
+{
+        printf("%*s", 8 * levels, "");
+}
+
+/*
+ * Prints a block of shape->collectives MPI collectives. The k-th block of a
+ * function starts with the k-th MPI collective.
+ */
+static void block(const struct shape *const shape, const int k,
+                  const int levels)
+{
+        int i;
+
+        for (i = 0; i < shape->collectives; ++i) {
+                indent(levels);
+                printf("%s\n", COLLECTIVES[(k + i) % NB_COLLECTIVES]);
+        }
+
+        if (shape->collectives == 0) {
+                indent(levels);
+                printf("v = v + %d.0;\n", k);
+        }
+}
+
+/*
+ * Prints function f, made of a loop nest around a sequence of diamonds, each
+ * followed by a switch.
+ */
+static void function(const struct shape *const shape, const int f)
+{
+        int levels = 1;
+        int i, k, c;
+
+        printf("#pragma mpicoll check f%d\n\n", f);
+        printf("double f%d(const int rank, const int n)\n{\n", f);
+        printf("        double v = rank, s = 0.0;\n");
+
+        for (i = 0; i < shape->depth; ++i)
+                printf("        int i%d;\n", i);
+
+        printf("\n");
+
+        for (i = 0; i < shape->depth; ++i, ++levels) {
+                indent(levels);
+                printf("for (i%d = 0; i%d < n; ++i%d) {\n", i, i, i);
+        }
+
+        for (k = 0; k < shape->diamonds; ++k) {
+                indent(levels);
+                printf("if ((rank >> %d) & 1) {\n", k % 16);
+                block(shape, 2 * k, levels + 1);
+                indent(levels);
+                printf("} else {\n");
+                block(shape, 2 * k + 1, levels + 1);
+                indent(levels);
+                printf("}\n");
+
+                if (shape->fanout <= 1)
+                        continue;
+
+                indent(levels);
+                printf("switch ((rank + %d) %% %d) {\n", k, shape->fanout);
+
+                for (c = 0; c < shape->fanout; ++c) {
+                        indent(levels);
+                        printf("case %d:\n", c);
+                        block(shape, k + c, levels + 1);
+                        indent(levels + 1);
+                        printf("break;\n");
+                }
+
+                indent(levels);
+                printf("}\n");
+        }
+
+        for (i = 0; i < shape->depth; ++i) {
+                indent(--levels);
+                printf("}\n");
+        }
+
+        printf("\n        return s;\n}\n\n");
+}
+
+/*
+ * Prints usage.
+ */
+static void usage(const char *const name)
+{
+        fprintf(stderr, "Usage: %s [-f <functions>] [-d <diamonds>] "
+                "[-l <loop depth>] [-s <switch fan-out>] "
+                "[-c <collectives per block>]\n", name);
+}
+
+int main(int argc, char *argv[])
+{
+        struct shape shape = { 1, 16, 1, 0, 1 };
+        int opt;
+        int f;
+
+        while ((opt = getopt(argc, argv, "f:d:l:s:c:h")) != -1) {
+                switch (opt) {
+                case 'f':
+                        shape.functions = atoi(optarg);
+                        break;
+                case 'd':
+                        shape.diamonds = atoi(optarg);
+                        break;
+                case 'l':
+                        shape.depth = atoi(optarg);
+                        break;
+                case 's':
+                        shape.fanout = atoi(optarg);
+                        break;
+                case 'c':
+                        shape.collectives = atoi(optarg);
+                        break;
+                case 'h':
+                        usage(argv[0]);
+                        return EXIT_SUCCESS;
+                default:
+                        usage(argv[0]);
+                        return EXIT_FAILURE;
+                }
+        }
+
+        if (shape.functions < 0 || shape.diamonds < 0 || shape.depth < 0
+            || shape.fanout < 0 || shape.collectives < 0) {
+                usage(argv[0]);
+                return EXIT_FAILURE;
+        }
+
+        printf("/* Generated by %s -f %d -d %d -l %d -s %d -c %d */\n",
+               argv[0], shape.functions, shape.diamonds, shape.depth,
+               shape.fanout, shape.collectives);
+        printf("#include <mpi.h>\n\n");
+
+        for (f = 0; f < shape.functions; ++f)
+                function(&shape, f);
+
+        return EXIT_SUCCESS;
+}
@@ -0,0 +1,67 @@
+/*
+ * Wall time and peak memory measurement of a command and its children.
+ * Copyright (C) 2023-2025 Antoni Blanche
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include <stdlib.h>
+#include <stdio.h>
+#include <time.h>
+
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+
+/*
+ * Runs the command given as arguments and prints its wall time in seconds and
+ * the peak resident set size in KiB of the largest of its processes, separated
+ * by a comma. Exits with the status of the command.
+ */
+int main(int argc, char *argv[])
+{
+        struct timespec start, end;
+        struct rusage usage;
+        pid_t pid;
+        int status;
+
+        if (argc < 2) {
+                fprintf(stderr, "Usage: %s <command> [<argument>...]\n",
+                        argv[0]);
+                return EXIT_FAILURE;
+        }
+
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        pid = fork();
+
+        if (pid == -1) {
+                perror("fork");
+                return EXIT_FAILURE;
+        }
+
+        if (pid == 0) {
+                execvp(argv[1], argv + 1);
+                perror(argv[1]);
+                _exit(127);
+        }
+
+        waitpid(pid, &status, 0);
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        getrusage(RUSAGE_CHILDREN, &usage);
+
+        printf("%.3f,%ld\n", (end.tv_sec - start.tv_sec)
+                             + (end.tv_nsec - start.tv_nsec) / 1e9,
+               usage.ru_maxrss);
+
+        return WIFEXITED(status) ? WEXITSTATUS(status) : EXIT_FAILURE;
+}
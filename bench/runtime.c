@@ -0,0 +1,246 @@
+/*
+ * Runtime overhead benchmark of instrumented MPI collectives.
+ * Copyright (C) 2023-2025 Antoni Blanche
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <mpi.h>
+
+/*
+ * Name of the build variant, printed in the variant column.
+ */
+#ifndef BENCH_VARIANT
+#define BENCH_VARIANT "plain"
+#endif
+
+/*
+ * Number of MPI collectives in the rank-uniform loop pattern.
+ */
+#define BENCH_LOOP 16
+
+/*
+ * Largest message size in bytes.
+ */
+#define BENCH_MAX_BYTES (1 << 20)
+
+/*
+ * Each pattern is a function tagged for the plugin. The never-taken
+ * rank-dependent MPI_Barrier flags the function, so that its MPI collectives
+ * are checked when the plugin instruments the program.
+ */
+#pragma mpicoll check (bench_barrier, bench_reduce, bench_allreduce)
+#pragma mpicoll check (bench_loop, bench_branch)
+
+void bench_barrier(const int iters, const int rank)
+{
+        int i;
+
+        if (iters < 0 && rank == 0)
+                MPI_Barrier(MPI_COMM_WORLD);
+
+        for (i = 0; i < iters; ++i)
+                MPI_Barrier(MPI_COMM_WORLD);
+}
+
+void bench_reduce(double *const in, double *const out, const int count,
+                  const int iters, const int rank)
+{
+        int i;
+
+        if (iters < 0 && rank == 0)
+                MPI_Barrier(MPI_COMM_WORLD);
+
+        for (i = 0; i < iters; ++i)
+                MPI_Reduce(in, out, count, MPI_DOUBLE, MPI_SUM, 0,
+                           MPI_COMM_WORLD);
+}
+
+void bench_allreduce(double *const in, double *const out, const int count,
+                     const int iters, const int rank)
+{
+        int i;
+
+        if (iters < 0 && rank == 0)
+                MPI_Barrier(MPI_COMM_WORLD);
+
+        for (i = 0; i < iters; ++i)
+                MPI_Allreduce(in, out, count, MPI_DOUBLE, MPI_SUM,
+                              MPI_COMM_WORLD);
+}
+
+/*
+ * Rank-uniform loop of MPI collectives, checked once per loop entry.
+ */
+void bench_loop(const int iters, const int rank)
+{
+        int i, j;
+
+        if (iters < 0 && rank == 0)
+                MPI_Barrier(MPI_COMM_WORLD);
+
+        for (i = 0; i < iters; ++i) {
+                for (j = 0; j < BENCH_LOOP; ++j)
+                        MPI_Barrier(MPI_COMM_WORLD);
+        }
+}
+
+/*
+ * The same MPI collective called in both branches of a rank-dependent
+ * condition, which the static analysis flags.
+ */
+void bench_branch(double *const in, double *const out, const int count,
+                  const int iters, const int rank)
+{
+        int i;
+
+        if (iters < 0 && rank == 0)
+                MPI_Barrier(MPI_COMM_WORLD);
+
+        for (i = 0; i < iters; ++i) {
+                if (rank % 2 == 0)
+                        MPI_Reduce(in, out, count, MPI_DOUBLE, MPI_SUM, 0,
+                                   MPI_COMM_WORLD);
+                else
+                        MPI_Reduce(in, out, count, MPI_DOUBLE, MPI_SUM, 0,
+                                   MPI_COMM_WORLD);
+        }
+}
+
+/*
+ * Benchmark state.
+ */
+struct bench {
+        double *in;
+        double *out;
+        int rank;
+        int size;
+        int iters;
+};
+
+/*
+ * Runs pattern with count doubles, iters times, and returns the slowest rank
+ * time in seconds.
+ */
+static double bench_run(const struct bench *const b, const char *const pattern,
+                        const int count, const int iters)
+{
+        double start, time, res;
+
+        MPI_Barrier(MPI_COMM_WORLD);
+        start = MPI_Wtime();
+
+        if (strcmp(pattern, "barrier") == 0)
+                bench_barrier(iters, b->rank);
+        else if (strcmp(pattern, "reduce") == 0)
+                bench_reduce(b->in, b->out, count, iters, b->rank);
+        else if (strcmp(pattern, "allreduce") == 0)
+                bench_allreduce(b->in, b->out, count, iters, b->rank);
+        else if (strcmp(pattern, "loop") == 0)
+                bench_loop(iters, b->rank);
+        else
+                bench_branch(b->in, b->out, count, iters, b->rank);
+
+        time = MPI_Wtime() - start;
+        MPI_Reduce(&time, &res, 1, MPI_DOUBLE, MPI_MAX, 0, MPI_COMM_WORLD);
+
+        return res;
+}
+
+/*
+ * Runs pattern with count doubles and prints a CSV line. The number of MPI
+ * collectives per iteration is calls.
+ */
+static void bench_pattern(const struct bench *const b,
+                          const char *const pattern, const int count,
+                          const int calls)
+{
+        const size_t bytes = count * sizeof(double);
+        int iters = b->iters;
+        double time;
+
+        /* Large messages are run fewer times */
+        if (bytes > 65536)
+                iters = iters * 65536 / bytes + 1;
+
+        bench_run(b, pattern, count, iters / 10 + 1);
+        time = bench_run(b, pattern, count, iters);
+
+        if (b->rank != 0)
+                return;
+
+        printf("%s,%s,%zu,%d,%d,%.3f,%.3f\n", BENCH_VARIANT, pattern, bytes,
+               b->size, iters, time / ((double) iters * calls) * 1e6,
+               bytes != 0 ? (double) bytes * iters * calls / time / 1e6 : 0.0);
+}
+
+int main(int argc, char *argv[])
+{
+        struct bench b;
+        int header = 0;
+        int count, opt;
+
+        MPI_Init(&argc, &argv);
+
+        MPI_Comm_rank(MPI_COMM_WORLD, &b.rank);
+        MPI_Comm_size(MPI_COMM_WORLD, &b.size);
+        b.iters = 10000;
+
+        while ((opt = getopt(argc, argv, "Hn:")) != -1) {
+                switch (opt) {
+                case 'H':
+                        header = 1;
+                        break;
+                case 'n':
+                        b.iters = atoi(optarg);
+                        break;
+                default:
+                        if (b.rank == 0)
+                                fprintf(stderr, "Usage: %s [-H] [-n <iters>]\n",
+                                        argv[0]);
+                        MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+                }
+        }
+
+        b.in = calloc(BENCH_MAX_BYTES / sizeof(double), sizeof(double));
+        b.out = calloc(BENCH_MAX_BYTES / sizeof(double), sizeof(double));
+
+        if (b.in == NULL || b.out == NULL || b.iters <= 0)
+                MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+
+        if (header && b.rank == 0)
+                printf("variant,pattern,bytes,ranks,iterations,latency_us,"
+                       "throughput_MBps\n");
+
+        bench_pattern(&b, "barrier", 0, 1);
+        bench_pattern(&b, "loop", 0, BENCH_LOOP);
+
+        for (count = 1; count * sizeof(double) <= BENCH_MAX_BYTES;
+             count = count * 8) {
+                bench_pattern(&b, "reduce", count, 1);
+                bench_pattern(&b, "allreduce", count, 1);
+                bench_pattern(&b, "branch", count, 1);
+        }
+
+        free(b.out);
+        free(b.in);
+
+        MPI_Finalize();
+
+        return EXIT_SUCCESS;
+}
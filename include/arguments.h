@@ -0,0 +1,67 @@
+/*
+ * Declarations and definitions dealing with plugin arguments.
+ * Copyright (C) 2023-2025 Antoni Blanche
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef ARGUMENTS_H
+#define ARGUMENTS_H
+
+#include <coretypes.h>
+
+/*
+ * Blocks shown in dumps: all of them, all of them with chains of blocks without
+ * MPI collective nor fork contracted, or only those between flagged groups and
+ * their forks, contracted.
+ */
+enum dump_mode {
+        DUMP_FULL,
+        DUMP_COLLAPSED,
+        DUMP_FLAGGED
+};
+
+/*
+ * Plugin arguments, given as -fplugin-arg-libmpiplugin-<key>[=<value>].
+ */
+struct mpicoll_arguments {
+        bool instrument;        /* Insert runtime checks for flagged groups */
+        bool trace;             /* Record executed MPI collectives */
+        bool counters;          /* Print analysis counters per function */
+        bool thread_level;      /* Print the MPI thread level required */
+        const char *stats;      /* Statistics file, or NULL */
+        const char *report;     /* Directory of report files, or NULL */
+        const char *dump;       /* Directory of dump files, or NULL */
+        const char *after;      /* Pass the MPI pass runs after */
+        enum dump_mode dump_mode;
+        int max_blocks;         /* Budgets of the exact analysis per function, */
+        int max_edges;          /* 0 if unlimited */
+        int max_collectives;
+        int max_time;           /* In milliseconds */
+        int max_warnings;       /* Warnings per function and per translation */
+        int max_unit_warnings;  /* unit, 0 if unlimited */
+        int simulate;           /* Ranks simulated, 0 if disabled */
+};
+
+/*
+ * Plugin arguments for the current compilation.
+ */
+extern struct mpicoll_arguments mpicoll_arguments;
+
+/*
+ * Parses plugin arguments in plugin_info. Returns false if at least one
+ * argument is unknown or malformed, true otherwise.
+ */
+bool arguments_parse(const struct plugin_name_args *plugin_info);
+
+#endif /* arguments.h */
@@ -0,0 +1,58 @@
+/*
+ * Declarations and definitions dealing with the analysis complexity budgets.
+ * Copyright (C) 2023-2025 Antoni Blanche
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef BUDGET_H
+#define BUDGET_H
+
+#include <coretypes.h>
+
+/*
+ * Starts the time budget of the analysis of a new function.
+ */
+void budget_start(void);
+
+/*
+ * Returns true if fun has more blocks, edges or MPI collectives than allowed
+ * by the plugin arguments, false otherwise. MPI collective codes must be set
+ * in basic blocks’s aux field before calling this function.
+ *
+ * See mpicoll_mark_code() for details.
+ */
+bool budget_size_exceeded_p(const function *fun);
+
+/*
+ * Returns true if the analysis of the current function has run longer than
+ * allowed by the plugin arguments, false otherwise. Once exceeded, the time
+ * budget stays exceeded until the next call to budget_start(). This function is
+ * cheap enough to be called in the inner loops of the analysis.
+ */
+bool budget_time_exceeded_p(void);
+
+/*
+ * Computes a conservative approximation of the groups and their iterated
+ * post-dominance frontier in fun, used instead of the exact analysis when a
+ * budget is exceeded. Every block ending with a rank-tainted branch from which
+ * a MPI collective is reachable is a fork, and every MPI collective reachable
+ * from a fork is in the only group. A note explains why the approximation is
+ * used. MPI collective codes must be set in basic blocks’s aux field before
+ * calling this function.
+ *
+ * See mpicoll_mark_code() and taint_compute() for details.
+ */
+void budget_approximate(function *fun, bitmap *groups, bitmap *pdf);
+
+#endif /* budget.h */
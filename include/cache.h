@@ -0,0 +1,50 @@
+/*
+ * Declarations and definitions dealing with the cache of analysis verdicts.
+ * Copyright (C) 2023-2025 Antoni Blanche
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef CACHE_H
+#define CACHE_H
+
+#include <coretypes.h>
+
+/*
+ * Looks up the verdict of the exact analysis of a copy of fun, such as an IPA
+ * clone, with the same DECL_ORIGIN and body shape. The body shape is made of
+ * the basic blocks of fun in reverse postorder, with their MPI collective code,
+ * their successors and whether they end with an exit test of a rank-uniform
+ * loop in exits. Returns true and sets groups and their iterated post-dominance
+ * frontiers pdf if found, false otherwise. MPI collective codes must be set in
+ * basic blocks’s aux field before calling this function.
+ *
+ * See mpicoll_mark_code() and loops_compute_exits() for details.
+ */
+bool cache_lookup(function *fun, const_bitmap exits, bitmap *groups,
+                  bitmap *pdf);
+
+/*
+ * Records groups and their iterated post-dominance frontiers pdf as the verdict
+ * of the exact analysis of fun, whose body shape was computed by the last call
+ * to cache_lookup().
+ */
+void cache_store(function *fun, bitmap groups, bitmap pdf);
+
+/*
+ * Releases the cache at the end of a translation unit.
+ */
+void cache_finish_unit(void *event_data ATTRIBUTE_UNUSED,
+                       void *data ATTRIBUTE_UNUSED);
+
+#endif /* cache.h */
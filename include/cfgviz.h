@@ -21,13 +21,52 @@
 #include <coretypes.h>
 
 /*
- * Dumps the graphviz CFG representation of fun in a file.
+ * Suffix of dump files, each holding the graphs of a translation unit.
+ */
+#define CFGVIZ_SUFFIX ".mpicoll.dot"
+
+/*
+ * Opens the dump file of the translation unit in the directory given by the
+ * dump plugin argument. This function is a PLUGIN_START_UNIT callback.
+ */
+void cfgviz_start_unit(void *event_data, void *data);
+
+/*
+ * Closes the dump file of the translation unit. This function is a
+ * PLUGIN_FINISH_UNIT callback.
+ */
+void cfgviz_finish_unit(void *event_data, void *data);
+
+/*
+ * Returns true if dumps are written, false otherwise.
+ */
+bool cfgviz_enabled_p(void);
+
+/*
+ * Dumps the graphviz CFG representation of fun in the dump file.
  */
 void cfgviz_dump(function *fun, const char *suffix);
 
 /*
- * Dumps the graphviz CFG representation of fun from cfg in a file.
+ * Dumps the graphviz CFG representation of fun from cfg in the dump file. The
+ * edges not in cfg are dashed.
  */
 void cfgviz_dump_cfg(function *fun, const char *suffix, bitmap cfg);
 
+/*
+ * Dumps the graphviz CFG representation of fun in the dump file, overlaid with
+ * the results of the analysis. MPI collectives are labelled with their ranks
+ * and groups, and filled in red if their group has a non-empty post-dominance
+ * frontier. Forks are diamonds labelled with the groups whose frontier they are
+ * in. Blocks of collapsed regions are grey, and edges not in cfg are dashed.
+ * Any of cfg, ranks, regions, groups and pdf can be NULL if it was not
+ * computed.
+ *
+ * Unless the dump mode is full, chains of basic blocks without MPI collective
+ * nor fork are contracted into boxes, and in flagged mode only the basic blocks
+ * between flagged groups and their forks are dumped.
+ */
+void cfgviz_dump_analysis(function *fun, bitmap cfg, bitmap ranks,
+                          const int *regions, bitmap groups, bitmap pdf);
+
 #endif /* cfgviz.h */
@@ -41,8 +41,17 @@
 bitmap frontier_compute_post_dominance(const function *fun);
 
 /*
- * Computes CFG’, a part of fun’s CFG without loop backedge. A loop backedge can
- * be found when a successor of a basic block is also one of its predecessors.
+ * Puts in order the indices of the basic blocks of fun reachable from its entry,
+ * in reverse postorder of a depth-first search, and returns their number. Every
+ * edge of the CFG goes forward in this order, except loop backedges.
+ */
+int frontier_reverse_postorder(const function *fun, int *order);
+
+/*
+ * Computes CFG’, a part of fun’s CFG without loop backedge. A loop backedge is
+ * an edge going backward in the reverse postorder of fun.
+ *
+ * See frontier_reverse_postorder() for details.
  */
 bitmap frontier_compute_cfg_bis(const function *fun);
 
@@ -58,21 +67,24 @@ bitmap frontier_make_groups(const function *fun, bitmap ranks);
 /*
  * Computes the post-dominance frontier for groups. A group post-dominance
  * frontier contains all basic blocks that are not post-dominated by the group
- * but have at least 1 of its successors that it is. If the dominance
- * information is not computed, the behaviour is undefined.
+ * but have at least 1 of its successors that it is. Collapsed basic blocks,
+ * whose representative in rep is another basic block, are never in it. If the
+ * dominance information is not computed, the behaviour is undefined.
  *
- * See calculate_dominance_info() for details
+ * See calculate_dominance_info() and region_collapse() for details
  */
 bitmap frontier_compute_groups_post_dominance(const function *fun,
-                                              bitmap groups);
+                                              bitmap groups, const int *rep);
 
 /*
- * Computes the itered post-dominance frontier for groups. If the dominance
- * information is not computed, the behaviour is undefined.
+ * Computes the itered post-dominance frontier for groups, skipping the regions
+ * collapsed in rep. If the dominance information is not computed, the behaviour
+ * is undefined.
  *
- * See calculate_dominance_info() for details
+ * See calculate_dominance_info() and region_collapse() for details
  */
 bitmap frontier_compute_groups_iter_post_dominance(const function *fun,
-                                                   bitmap groups);
+                                                   bitmap groups,
+                                                   const int *rep);
 
 #endif /* frontier.h */
@@ -0,0 +1,56 @@
+/*
+ * Declarations and definitions dealing with runtime checks instrumentation.
+ * Copyright (C) 2023-2025 Antoni Blanche
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef INSTRUMENT_H
+#define INSTRUMENT_H
+
+#include <coretypes.h>
+
+/*
+ * Registers the trees kept by the instrumentation across functions as garbage
+ * collector roots.
+ */
+void instrument_register_roots(const char *plugin_name);
+
+/*
+ * Inserts runtime checks in fun if at least 1 group has a non-empty
+ * post-dominance frontier. Each MPI collective in fun is preceded by a check
+ * agreeing on the collective code among all ranks. The agreement is started
+ * with a nonblocking collective as early as possible and completed right
+ * before the MPI collective. MPI collectives in a rank-uniform loop are checked
+ * once on entering the loop instead, unless the loop is expected to be entered
+ * more often than they are called, and a chain of MPI collectives always
+ * following each other is checked once at its first MPI collective. Only MPI
+ * collectives on MPI_COMM_WORLD are checked. MPI collective codes must be set
+ * in basic blocks’s aux field and the post-dominance information must be
+ * computed before calling this function.
+ *
+ * See mpicoll_mark_code() and runtime/mpicoll_rt.h for details.
+ */
+void instrument_checks(function *fun, bitmap groups, bitmap pdf);
+
+/*
+ * Inserts a call recording each MPI collective in fun, but MPI_Init, right
+ * before it is called. Calls pass the site ID and the communicator of the MPI
+ * collective. MPI collective codes must be set in basic blocks’s aux field
+ * before calling this function.
+ *
+ * See runtime/mpicoll_rt.h for details.
+ */
+void instrument_traces(function *fun);
+
+#endif /* instrument.h */
@@ -0,0 +1,53 @@
+/*
+ * Declarations and definitions dealing with rank-uniform loops.
+ * Copyright (C) 2023-2025 Antoni Blanche
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef LOOPS_H
+#define LOOPS_H
+
+#include <coretypes.h>
+
+/*
+ * Sets in exits the basic blocks of fun ending with an exit test of a
+ * rank-uniform loop. All ranks entering a rank-uniform loop run the same number
+ * of iterations: each exit test either does not depend on the rank, or compares
+ * an induction variable to a bound whose distance to the initial value of the
+ * induction variable does not depend on the rank. Basic blocks also ending with
+ * an exit test of a rank-divergent loop are not set.
+ *
+ * See taint_compute() for details.
+ */
+void loops_uniform_exits(function *fun, const struct taint *taint,
+                         bitmap exits);
+
+/*
+ * Sets in exits the basic blocks of fun ending with an exit test of a
+ * rank-uniform loop, computing the rank-tainted values of fun.
+ *
+ * See loops_uniform_exits() for details.
+ */
+void loops_compute_exits(function *fun, bitmap exits);
+
+/*
+ * Removes the exit tests of rank-uniform loops in exits from the post-dominance
+ * frontiers pdf of groups, so that only loops whose number of iterations may
+ * depend on the rank are forks.
+ *
+ * See loops_compute_exits() for details.
+ */
+void loops_prune_forks(bitmap groups, bitmap pdf, const_bitmap exits);
+
+#endif /* loops.h */
@@ -39,6 +39,15 @@ const char *const MPI_COLLECTIVE_NAME[] = {
 };
 #undef DEF_MPI_COLLECTIVES
 
+/*
+ * Returns the MPI collective code if stmt is a call to an MPI function defined
+ * in MPI_collectives.def, in any of its spellings, or
+ * LAST_AND_UNUSED_MPI_COLLECTIVE_CODE otherwise.
+ *
+ * See include/MPI_collectives.def for details.
+ */
+enum mpi_collective_code mpicoll_code(const gimple *stmt);
+
 /*
  * Puts MPI collective code in basic blocks’s aux field if they contain a MPI
  * call defined in MPI_collectives.def, or LAST_AND_UNUSED_MPI_COLLECTIVE_CODE
@@ -66,12 +75,21 @@ void mpicoll_split(const function *fun);
 
 /*
  * Returns MPI collectives’s rank in fun using cfg. Loop backedges in cfg must
- * be removed from cfg before calling this function to avoid an infinite loop.
+ * be removed from cfg before calling this function.
  *
  * See frontier_compute_cfg_bis() for details.
  */
 bitmap mpicoll_ranks(const function *fun, bitmap cfg);
 
+/*
+ * Returns the MPI collective gimple statement in bb, or NULL if bb does not
+ * contain MPI collective. The basic block must contain only one MPI collective
+ * gimple statement.
+ *
+ * See mpicoll_split() for details.
+ */
+gimple *mpicoll_stmt(basic_block bb);
+
 /*
  * Returns MPI collective location in bb. The basic block must contain only one
  * MPI collective gimple statement. If bb does not contain MPI collective, this
@@ -81,4 +99,27 @@ bitmap mpicoll_ranks(const function *fun, bitmap cfg);
  */
 location_t mpicoll_location(basic_block bb);
 
+/*
+ * Returns the communicator argument of the MPI collective stmt, or NULL_TREE if
+ * it does not take a communicator. The communicator is the first parameter
+ * declared with the MPI_Comm type.
+ */
+tree mpicoll_comm(const gcall *stmt);
+
+/*
+ * Returns true if the MPI collective stmt is called on MPI_COMM_WORLD or does
+ * not take a communicator, false otherwise. Only the MPI_COMM_WORLD constant
+ * itself is recognised, not a variable holding it.
+ *
+ * See mpicoll_comm() for details.
+ */
+bool mpicoll_world_p(const gcall *stmt);
+
+/*
+ * Returns the request argument of the MPI collective stmt, or NULL_TREE if it
+ * is blocking. The request is the first parameter declared as a pointer to the
+ * MPI_Request type.
+ */
+tree mpicoll_request(const gcall *stmt);
+
 #endif /* mpicoll.h */
@@ -0,0 +1,84 @@
+/*
+ * Definitions of the per-site counters format shared by the runtime
+ * verification library and the counters reader.
+ * Copyright (C) 2023-2025 Antoni Blanche
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef MPICOLL_COUNTERS_H
+#define MPICOLL_COUNTERS_H
+
+#include <stdint.h>
+
+/*
+ * When the MPICOLL_COUNTERS_DIR environment variable is set, each rank counts
+ * the work of the runtime library per site in its own counters file, named
+ * mpicoll-counters.<rank> in that directory. The file is a header followed by
+ * a hash table of slots, mapped in memory so that counters can be read while
+ * the program runs. Only the rank writes its file, with plain stores, and each
+ * slot fills a cache line of its own.
+ */
+#define MPICOLL_COUNTERS_FILE "mpicoll-counters"
+#define MPICOLL_COUNTERS_MAGIC 0x3143434dU /* "MCC1" */
+
+/*
+ * Default number of slots of the hash table, overridden by the
+ * MPICOLL_COUNTERS_SIZE environment variable. The number of slots is always a
+ * power of 2.
+ */
+#define MPICOLL_COUNTERS_DEFAULT_SIZE 4096U
+
+/*
+ * Size of the header and of the slots, a cache line.
+ */
+#define MPICOLL_COUNTERS_LINE 64U
+
+/*
+ * Counters file header.
+ */
+struct mpicoll_counters_header {
+        uint32_t magic;
+        uint32_t rank;          /* Rank in MPI_COMM_WORLD */
+        uint32_t size;          /* Size of MPI_COMM_WORLD */
+        uint32_t reserved;
+        uint64_t capacity;      /* Number of slots */
+        uint64_t dropped;       /* Site visits not counted, the table being full */
+        uint64_t padding[4];
+};
+
+/*
+ * Counters of a site, see include/mpicoll_sites.h. The slot of a site is found
+ * by linear probing from mpicoll_counters_hash(). A slot is free until its used
+ * field is set, once its site field is written.
+ */
+struct mpicoll_counters_slot {
+        uint32_t site;
+        uint32_t used;
+        uint64_t calls;         /* Times the site was reached */
+        uint64_t checks;        /* Agreements completed at the site */
+        uint64_t time;          /* Nanoseconds spent in the library for it */
+        uint64_t padding[4];
+};
+
+/*
+ * Returns the first slot probed for the site with ID site in a hash table with
+ * mask + 1 slots.
+ */
+static inline uint64_t mpicoll_counters_hash(const uint32_t site,
+                                             const uint64_t mask)
+{
+        return ((uint64_t) site * 0x9e3779b97f4a7c15ULL >> 32) & mask;
+}
+
+#endif /* mpicoll_counters.h */
@@ -0,0 +1,55 @@
+/*
+ * Definitions of the perfect hash table of MPI collective spellings shared by
+ * the plugin and its generator.
+ * Copyright (C) 2023-2025 Antoni Blanche
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef MPICOLL_HASH_H
+#define MPICOLL_HASH_H
+
+/*
+ * Every spelling of the MPI collectives is looked up in a perfect hash table
+ * generated at build time by utils/gentable.c, with a single probe:
+ *
+ *   d = MPICOLL_TABLE_DISPLACEMENTS[hash(name, 0) % MPICOLL_TABLE_BUCKETS]
+ *   slot = d < 0 ? -d - 1 : hash(name, d) % MPICOLL_TABLE_SIZE
+ *
+ * The name is a MPI collective spelling only if it is the name of the entry in
+ * the slot. Both sizes are powers of 2.
+ */
+struct mpicoll_table_entry {
+        const char *name;       /* NULL if the slot is empty */
+        int code;               /* MPI collective code, or -1 */
+};
+
+/*
+ * Returns the hash of the NUL-terminated string s with seed: FNV-1a, from an
+ * offset basis depending on seed, followed by the MurmurHash3 finalizer so that
+ * all bits depend on every character.
+ */
+static inline unsigned int mpicoll_hash(const char *s, const unsigned int seed)
+{
+        unsigned int hash = 2166136261U ^ (seed * 0x9e3779b9U);
+
+        for (; *s != '\0'; ++s)
+                hash = (hash ^ (unsigned char) *s) * 16777619U;
+
+        hash = (hash ^ (hash >> 16)) * 0x85ebca6bU;
+        hash = (hash ^ (hash >> 13)) * 0xc2b2ae35U;
+
+        return hash ^ (hash >> 16);
+}
+
+#endif /* mpicoll_hash.h */
@@ -0,0 +1,67 @@
+/*
+ * Definitions of the MPI collective site table shared by the plugin and the
+ * runtime verification library.
+ * Copyright (C) 2023-2025 Antoni Blanche
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef MPICOLL_SITES_H
+#define MPICOLL_SITES_H
+
+/*
+ * Each site instrumented by the plugin (MPI collective, loop entry or function
+ * exit) is identified by a 32-bit site ID. The low bits are the index of the
+ * site in its translation unit, dense from 0. The high bits are a tag derived
+ * from the main input file name of the translation unit.
+ *
+ * Tags are only likely to be distinct, not unique. The runtime verification
+ * library and the readers check that no two translation units of a program
+ * share a tag before mapping site IDs, and fail otherwise.
+ */
+#define MPICOLL_SITES_INDEX_BITS 16
+#define MPICOLL_SITES_MAX_INDEX ((1U << MPICOLL_SITES_INDEX_BITS) - 1U)
+
+#define MPICOLL_SITES_ID(tag, index) \
+        (((tag) << MPICOLL_SITES_INDEX_BITS) | (index))
+#define MPICOLL_SITES_TAG(id) ((id) >> MPICOLL_SITES_INDEX_BITS)
+#define MPICOLL_SITES_INDEX(id) ((id) & MPICOLL_SITES_MAX_INDEX)
+
+/*
+ * Tag of the sites of the PMPI interposition library, whose index is the MPI
+ * collective code. The plugin never derives this tag from a file name.
+ */
+#define MPICOLL_SITES_PMPI_TAG (-1U >> MPICOLL_SITES_INDEX_BITS)
+
+/*
+ * Site code of a loop entry. MPI collective sites use their MPI collective
+ * code and function exits use LAST_AND_UNUSED_MPI_COLLECTIVE_CODE.
+ */
+#define MPICOLL_SITES_LOOP (-1)
+
+/*
+ * Site IDs are mapped back to source locations with the non-allocated
+ * .mpicoll_sites section. Each translation unit contributes one block, aligned
+ * on 8 bytes, made of 32-bit numbers in the target byte order:
+ *
+ *   magic, tag, number of sites, size of the block in bytes
+ *   for each site, in index order:
+ *       code, line, NUL-terminated function name, NUL-terminated file name
+ *
+ * The size does not include the padding up to the next 8 bytes.
+ */
+#define MPICOLL_SITES_SECTION ".mpicoll_sites"
+#define MPICOLL_SITES_MAGIC 0x3153434dU /* "MCS1" */
+#define MPICOLL_SITES_ALIGN 8U
+
+#endif /* mpicoll_sites.h */
@@ -0,0 +1,79 @@
+/*
+ * Definitions of the MPI collective trace format shared by the runtime
+ * verification library and the trace reader.
+ * Copyright (C) 2023-2025 Antoni Blanche
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef MPICOLL_TRACE_H
+#define MPICOLL_TRACE_H
+
+#include <stdint.h>
+
+/*
+ * Each rank records the MPI collectives it calls in its own trace file, named
+ * mpicoll-trace.<rank> in the directory given by the MPICOLL_TRACE_DIR
+ * environment variable, or the current directory. The file is a header
+ * followed by a ring buffer of records, mapped in memory so that records
+ * survive the rank being killed.
+ */
+#define MPICOLL_TRACE_FILE "mpicoll-trace"
+#define MPICOLL_TRACE_MAGIC 0x3254434dU /* "MCT2" */
+
+/*
+ * Default number of records in the ring buffer, overridden by the
+ * MPICOLL_TRACE_SIZE environment variable. The number of records is always a
+ * power of 2.
+ */
+#define MPICOLL_TRACE_DEFAULT_SIZE 65536U
+
+/*
+ * Trace file header.
+ */
+struct mpicoll_trace_header {
+        uint32_t magic;
+        uint32_t rank;          /* Rank in MPI_COMM_WORLD */
+        uint32_t size;          /* Size of MPI_COMM_WORLD */
+        uint32_t reserved;
+        uint64_t capacity;      /* Number of records */
+        uint64_t head;          /* Number of records ever appended */
+};
+
+/*
+ * A MPI collective call. Record n is stored in slot n modulo the capacity, and
+ * its seq field is set to n + 1 once all other fields are written. A slot
+ * whose seq field is 0 is empty.
+ *
+ * Communicators are identified by a key which is the same on all their ranks:
+ * a number agreed on by their ranks in the high 32 bits and the MPI_COMM_WORLD
+ * rank of their rank 0 in the low 32 bits. The number is agreed on by a
+ * reduction on the communicator at the first call recorded on it, and differs
+ * from the numbers of all other communicators with the same rank 0, duplicates
+ * included. Intercommunicators all have number 0. MPI collectives without a
+ * communicator are recorded on MPI_COMM_WORLD. The count field numbers the
+ * calls on the communicator of the rank, from 0, so that calls of different
+ * ranks are matched by key and count. Matched calls diverge if their MPI
+ * collective codes differ, whatever their sites.
+ */
+struct mpicoll_trace_record {
+        uint64_t seq;
+        uint64_t time;          /* Nanoseconds since the Epoch */
+        uint64_t comm;          /* Communicator key */
+        uint32_t count;         /* Call number on the communicator */
+        uint32_t site;          /* Site ID, see include/mpicoll_sites.h */
+        int32_t code;           /* MPI collective code */
+        uint32_t reserved;
+};
+
+#endif /* mpicoll_trace.h */
@@ -0,0 +1,109 @@
+/*
+ * Declarations and definitions dealing with the MPI pass phases and counters.
+ * Copyright (C) 2023-2025 Antoni Blanche
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef PHASE_H
+#define PHASE_H
+
+#include <coretypes.h>
+
+/*
+ * Phases of the MPI pass.
+ */
+#define DEF_MPICOLL_PHASE(CODE, NAME) CODE,
+enum phase {
+#include "phases.def"
+        LAST_AND_UNUSED_PHASE
+};
+#undef DEF_MPICOLL_PHASE
+
+/*
+ * Counters of the MPI pass.
+ */
+#define DEF_MPICOLL_COUNTER(CODE, NAME) CODE,
+enum phase_counter {
+#include "counters.def"
+        LAST_AND_UNUSED_COUNTER
+};
+#undef DEF_MPICOLL_COUNTER
+
+/*
+ * Counters of the current function.
+ */
+extern long phase_counters[LAST_AND_UNUSED_COUNTER];
+
+/*
+ * Bitmap obstack of the analysis of the current function. All bitmaps of the
+ * analysis are allocated on it, so that their memory is accounted for and
+ * released at once by phase_release().
+ */
+extern bitmap_obstack phase_obstack;
+
+/*
+ * Adds n to counter of the current function.
+ */
+#define PHASE_COUNT(counter, n) (phase_counters[(counter)] += (n))
+
+/*
+ * Starts phase. With -ftime-report, the time spent in phase is reported under
+ * its own timevar.
+ */
+void phase_push(enum phase phase);
+
+/*
+ * Stops phase, which must be the last started phase.
+ */
+void phase_pop(enum phase phase);
+
+/*
+ * Resets the counters and phase times and initializes the bitmap obstack for a
+ * new function.
+ */
+void phase_reset(void);
+
+/*
+ * Releases the bitmap obstack of the current function. All bitmaps allocated
+ * on it must not be used anymore.
+ */
+void phase_release(void);
+
+/*
+ * Counts the blocks, edges, MPI collectives and groups of fun. MPI collective
+ * codes must be set in basic blocks’s aux field before calling this function.
+ *
+ * See mpicoll_mark_code() for details.
+ */
+void phase_count_function(const function *fun, bitmap groups);
+
+/*
+ * Prints the counters of fun as a note.
+ */
+void phase_print(function *fun);
+
+/*
+ * Appends the statistics of fun to the file at path as a single line. The line
+ * is written at once under an exclusive lock, so that concurrent compilations
+ * can share the file. Counters must be computed by phase_count_function()
+ * before calling this function.
+ *
+ * Fields are separated by tabulations: the version of the format, the file and
+ * the function, the numbers of blocks, edges, MPI collectives and groups, the
+ * CPU time of each phase in microseconds, the total time, and the bitmap memory
+ * in bytes used by the analysis.
+ */
+void phase_write(function *fun, const char *path);
+
+#endif /* phase.h */
@@ -33,7 +33,8 @@ void undefined_pragma_mpicoll(void *event_data ATTRIBUTE_UNUSED,
                               void *data ATTRIBUTE_UNUSED);
 
 /*
- * Returns true if fun is tagged by #pragma mpicoll check, false otherwise.
+ * Returns true if fun or the function it is a copy of is tagged by
+ * #pragma mpicoll check, false otherwise.
  */
 bool is_set_pragma_mpicoll(function *fun);
 
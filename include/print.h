@@ -68,7 +68,14 @@ void print_cfg(const function *fun, bitmap cfg);
 
 /*
  * Prints a warning if a possible MPI deadlock is detected in fun. A deadlock
- * might be possible if pdf is set for at least 1 basic block in fun.
+ * might be possible if pdf is set for at least 1 basic block in fun. There is
+ * one warning per group, with notes at its MPI collectives and forks, and
+ * findings already reported in the translation unit are skipped. Warnings are
+ * capped per function and per translation unit by the max-warnings and
+ * max-unit-warnings plugin arguments. Groups proven safe by the simulation of
+ * ranks are skipped, and warnings get notes at its mismatch, if any.
+ *
+ * See simulate_groups() for details.
  */
 void print_warning(function *fun, bitmap groups, bitmap pdf);
 
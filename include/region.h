@@ -0,0 +1,36 @@
+/*
+ * Declarations and definitions dealing with collective-free branch regions.
+ * Copyright (C) 2023-2025 Antoni Blanche
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef REGION_H
+#define REGION_H
+
+#include <coretypes.h>
+
+/*
+ * Collapses the regions of fun, from a branch to its immediate post-dominator,
+ * that contain no MPI collective. Returns the representative of each basic
+ * block, indexed by basic block index: the exit block of the outermost
+ * collapsed region containing the basic block, or the basic block itself if
+ * no collapsed region contains it. Representatives are never collapsed. MPI
+ * collective codes must be set in basic blocks’s aux field and the
+ * post-dominance information must be computed before calling this function.
+ *
+ * See mpicoll_mark_code() and calculate_dominance_info() for details.
+ */
+int *region_collapse(const function *fun);
+
+#endif /* region.h */
@@ -0,0 +1,58 @@
+/*
+ * Declarations and definitions dealing with machine-readable reports.
+ * Copyright (C) 2023-2025 Antoni Blanche
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef REPORT_H
+#define REPORT_H
+
+#include <coretypes.h>
+
+/*
+ * Suffix of report files, each holding the findings of a translation unit.
+ */
+#define REPORT_SUFFIX ".mpicoll.jsonl"
+
+/*
+ * Returns the path of the file of the translation unit in dir, named after the
+ * main input file with suffix. A hash of the absolute path of the main input
+ * file is added so that homonyms in different directories do not clash.
+ */
+char *report_unit_path(const char *dir, const char *suffix);
+
+/*
+ * Creates the report file of the translation unit in the directory given by the
+ * report plugin argument, replacing the findings of a previous compilation.
+ * This function is a PLUGIN_START_UNIT callback.
+ */
+void report_start_unit(void *event_data, void *data);
+
+/*
+ * Closes the report file of the translation unit. This function is a
+ * PLUGIN_FINISH_UNIT callback.
+ */
+void report_finish_unit(void *event_data, void *data);
+
+/*
+ * Writes a finding to the report file for each group in fun with a non-empty
+ * post-dominance frontier. Each finding is a line holding a SARIF result.
+ * MPI collective codes must be set in basic blocks’s aux field before calling
+ * this function.
+ *
+ * See mpicoll_mark_code() for details.
+ */
+void report_write(function *fun, bitmap groups, bitmap pdf);
+
+#endif /* report.h */
@@ -0,0 +1,34 @@
+/*
+ * Declarations and definitions dealing with nonblocking MPI requests.
+ * Copyright (C) 2023-2025 Antoni Blanche
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef REQUEST_H
+#define REQUEST_H
+
+#include <coretypes.h>
+
+/*
+ * Checks that the request of each nonblocking MPI collective in fun is
+ * completed by all ranks, and prints a warning otherwise. Requests are paired
+ * with the MPI_Wait, MPI_Test and similar calls taking the same local variable.
+ * MPI collective codes must be set in basic blocks’s aux field and the
+ * post-dominance information must be computed before calling this function.
+ *
+ * See mpicoll_mark_code() and calculate_dominance_info() for details.
+ */
+void request_check(function *fun);
+
+#endif /* request.h */
@@ -0,0 +1,52 @@
+/*
+ * Declarations and definitions dealing with the simulation of ranks.
+ * Copyright (C) 2023-2025 Antoni Blanche
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef SIMULATE_H
+#define SIMULATE_H
+
+#include <coretypes.h>
+
+/*
+ * Simulates fun on every rank of communicators of 2 to n ranks, n being set by
+ * the simulate plugin argument, when at least one group has a non-empty
+ * post-dominance frontier in pdf. Only the rank and the size, read with
+ * MPI_Comm_rank and MPI_Comm_size on MPI_COMM_WORLD, and constants are
+ * propagated: ranks reaching a branch on another value are not simulated
+ * further. The sequences of MPI collectives of all ranks are then
+ * compared, to prove groups safe or find ranks calling different MPI
+ * collectives. MPI collective codes must be set in basic blocks’s aux field
+ * before calling this function.
+ *
+ * See mpicoll_mark_code() for details.
+ */
+void simulate_groups(function *fun, bitmap groups, bitmap pdf);
+
+/*
+ * Returns true if the last simulation of fun proved that all ranks call the
+ * same sequence of MPI collectives, so that group cannot deadlock, false
+ * otherwise.
+ */
+bool simulate_proven_p(const function *fun, int group);
+
+/*
+ * Prints notes at the MPI collectives called by the first pair of ranks found
+ * calling different MPI collectives at group by the last simulation of fun, if
+ * any.
+ */
+void simulate_explain(function *fun, int group);
+
+#endif /* simulate.h */
@@ -0,0 +1,38 @@
+/*
+ * Declarations and definitions dealing with MPI collective site IDs.
+ * Copyright (C) 2023-2025 Antoni Blanche
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef SITES_H
+#define SITES_H
+
+#include <coretypes.h>
+
+#include "mpicoll_sites.h"
+
+/*
+ * Returns a new site ID for the site with code at loc in fun.
+ *
+ * See include/mpicoll_sites.h for details.
+ */
+unsigned int sites_register(function *fun, location_t loc, int code);
+
+/*
+ * Emits the .mpicoll_sites section of the translation unit mapping each site
+ * ID to its function, file, line and code.
+ */
+void sites_emit(void *event_data ATTRIBUTE_UNUSED, void *data ATTRIBUTE_UNUSED);
+
+#endif /* sites.h */
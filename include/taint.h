@@ -0,0 +1,72 @@
+/*
+ * Declarations and definitions dealing with rank-tainted values.
+ * Copyright (C) 2023-2025 Antoni Blanche
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef TAINT_H
+#define TAINT_H
+
+#include <coretypes.h>
+
+/*
+ * Rank-tainted values of a function. A value is rank-tainted if it may differ
+ * from one rank to another. Only constants and local variables whose address
+ * is never taken can be proven untainted, everything else (parameters, global
+ * variables, memory, call results) is considered rank-tainted. Values defined
+ * in divergent basic blocks, control dependent on a rank-tainted branch, are
+ * rank-tainted too.
+ */
+struct taint {
+        bitmap_head decls;      /* DECL_UID of rank-tainted local variables */
+        bitmap_head names;      /* SSA_NAME_VERSION of rank-tainted SSA names */
+        bitmap_head blocks;     /* Indices of divergent basic blocks */
+};
+
+/*
+ * Computes rank-tainted values in fun. If the post-dominance information is
+ * not computed, the behaviour is undefined.
+ *
+ * See calculate_dominance_info() for details
+ */
+struct taint *taint_compute(const function *fun);
+
+/*
+ * Releases taint.
+ */
+void taint_free(struct taint *taint);
+
+/*
+ * Returns true if the operand t may be rank-tainted, false otherwise.
+ */
+bool taint_operand_p(const struct taint *taint, const_tree t);
+
+/*
+ * Returns true if stmt is a control statement whose outcome may depend on a
+ * rank-tainted value, false otherwise.
+ */
+bool taint_control_p(const struct taint *taint, const gimple *stmt);
+
+/*
+ * Returns true if every control statement in loop is not rank-tainted, false
+ * otherwise. All ranks entering a rank-uniform loop run the same number of
+ * iterations and call the same sequence of MPI collectives. A loop whose bound
+ * is written under a rank-tainted branch is not rank-uniform, since the bound
+ * is rank-tainted.
+ *
+ * See taint_compute() for details.
+ */
+bool taint_loop_uniform_p(const struct taint *taint, const class loop *loop);
+
+#endif /* taint.h */
@@ -0,0 +1,41 @@
+/*
+ * Declarations and definitions dealing with the MPI thread level.
+ * Copyright (C) 2023-2025 Antoni Blanche
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef THREADING_H
+#define THREADING_H
+
+#include <coretypes.h>
+
+/*
+ * Computes the MPI thread level required by the MPI collectives of fun, from
+ * the OpenMP constructs enclosing them, and prints it in a note if a MPI
+ * collective is in a parallel region. MPI collective codes must be set in
+ * basic blocks’s aux field before calling this function. An error is emitted
+ * instead if OpenMP constructs of fun are already expanded.
+ *
+ * See mpicoll_mark_code() for details.
+ */
+void threading_check(function *fun);
+
+/*
+ * Prints a note at each call to MPI_Init_thread() requesting a higher thread
+ * level than required by the MPI collectives checked in the translation unit.
+ * This function is a PLUGIN_FINISH_UNIT callback.
+ */
+void threading_finish_unit(void *event_data, void *data);
+
+#endif /* threading.h */
@@ -0,0 +1,229 @@
+/*
+ * Functions of the runtime verification library dealing with MPI collective
+ * agreements.
+ * Copyright (C) 2023-2025 Antoni Blanche
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include <stdlib.h>
+#include <stdio.h>
+
+#include <mpi.h>
+
+#include "mpicoll_rt.h"
+#include "sitemap.h"
+#include "stall.h"
+#include "counters.h"
+
+/*
+ * Name of each MPI collective. The last code is used by ranks leaving a
+ * function.
+ */
+#define DEF_MPI_COLLECTIVES(CODE, NAME) NAME,
+static const char *const MPI_COLLECTIVE_NAME[] = {
+#include "MPI_collectives.def"
+        "return"
+};
+#undef DEF_MPI_COLLECTIVES
+
+#define NB_CODES (int) (sizeof(MPI_COLLECTIVE_NAME) / sizeof(char *))
+
+/*
+ * Communicator dedicated to agreements, duplicated from MPI_COMM_WORLD on first
+ * use.
+ */
+static MPI_Comm check_comm = MPI_COMM_NULL;
+
+/*
+ * Pending agreement, if any, with the site ID and the value it was started
+ * for.
+ */
+static MPI_Request check_request = MPI_REQUEST_NULL;
+static long long check_send[2];
+static long long check_recv[2];
+static unsigned int check_pending_site;
+static int check_pending_value;
+
+/*
+ * Returns 1 if agreements can be made, 0 otherwise. Agreements can only be
+ * made between MPI_Init and MPI_Finalize. The program is aborted on first call
+ * if two of its translation units share a site tag.
+ */
+static int check_ready(void)
+{
+        int flag;
+
+        MPI_Finalized(&flag);
+
+        if (flag)
+                return 0;
+
+        if (check_comm == MPI_COMM_NULL) {
+                MPI_Initialized(&flag);
+
+                if (!flag)
+                        return 0;
+
+                /* Sites sharing an ID would be reported at the wrong place */
+                if (!sitemap_check())
+                        MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+
+                MPI_Comm_dup(MPI_COMM_WORLD, &check_comm);
+                stall_start();
+        }
+
+        return 1;
+}
+
+/*
+ * Returns the name of the site with code agreeing on value.
+ */
+static const char *check_name(const int code, const int value)
+{
+        if (code == MPICOLL_SITES_LOOP || value < 0)
+                return "loop";
+
+        if (value >= 0x40000000)
+                return "sequence";
+
+        if (code < 0 || code >= NB_CODES)
+                return "unknown";
+
+        return MPI_COLLECTIVE_NAME[code];
+}
+
+/*
+ * Prints the site with ID site agreeing on value of rank.
+ */
+static void check_print(const int rank, const unsigned int site,
+                        const int value)
+{
+        struct sitemap_site s;
+
+        if (sitemap_lookup(site, &s))
+                fprintf(stderr, "mpicoll:   rank %d: %s in %s() at %s:%d\n",
+                        rank, check_name(s.code, value), s.function, s.file,
+                        s.line);
+        else
+                fprintf(stderr, "mpicoll:   rank %d: site %#x\n", rank,
+                        site);
+}
+
+/*
+ * Prints the MPI collective each rank is about to call and aborts. All ranks
+ * must call this function.
+ */
+static void check_report(const unsigned int site, const int value)
+{
+        unsigned int local[2] = { site, (unsigned int) value };
+        unsigned int *all = NULL;
+        int rank, size;
+        int i;
+
+        MPI_Comm_rank(check_comm, &rank);
+        MPI_Comm_size(check_comm, &size);
+
+        if (rank == 0)
+                all = malloc(2 * size * sizeof(unsigned int));
+
+        MPI_Gather(local, 2, MPI_UNSIGNED, all, 2, MPI_UNSIGNED, 0,
+                   check_comm);
+
+        if (rank == 0) {
+                fprintf(stderr, "mpicoll: MPI collective mismatch detected\n");
+
+                for (i = 0; i < size; ++i)
+                        check_print(i, all[2 * i], (int) all[2 * i + 1]);
+
+                fflush(stderr);
+                free(all);
+        }
+
+        MPI_Barrier(check_comm);
+        MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+}
+
+static void check_end(unsigned int site, int value);
+
+/*
+ * Starts the agreement on value for the site with ID site.
+ */
+static void check_begin(const unsigned int site, const int value)
+{
+        /* A pending agreement is reported with the site it was started for */
+        if (check_request != MPI_REQUEST_NULL)
+                check_end(check_pending_site, check_pending_value);
+
+        check_pending_site = site;
+        check_pending_value = value;
+
+        /* Both the maximum and the minimum are agreed on in one reduction */
+        check_send[0] = value;
+        check_send[1] = -(long long) value;
+
+        MPI_Iallreduce(check_send, check_recv, 2, MPI_LONG_LONG, MPI_MAX,
+                       check_comm, &check_request);
+}
+
+/*
+ * Completes the agreement on value for the site with ID site. If another
+ * agreement is pending, it is completed instead, with the site and the value
+ * it was started for.
+ */
+static void check_end(const unsigned int site, const int value)
+{
+        if (check_request == MPI_REQUEST_NULL)
+                check_begin(site, value);
+
+        stall_enter(STALL_AGREEMENT, check_pending_site, check_pending_value);
+        MPI_Wait(&check_request, MPI_STATUS_IGNORE);
+        stall_leave();
+
+        if (check_recv[0] != -check_recv[1])
+                check_report(check_pending_site, check_pending_value);
+}
+
+/*
+ * Starts the agreement on value for the site with ID site.
+ */
+void __mpicoll_check_begin(const unsigned int site, const int value)
+{
+        struct mpicoll_counters_slot *counters;
+        uint64_t start;
+
+        if (!check_ready())
+                return;
+
+        counters = counters_lookup(site);
+        start = counters_start(counters);
+        check_begin(site, value);
+        counters_stop(counters, start, 0U, 0U);
+}
+
+/*
+ * Completes the agreement on value for the site with ID site.
+ */
+void __mpicoll_check_end(const unsigned int site, const int value)
+{
+        struct mpicoll_counters_slot *counters;
+        uint64_t start;
+
+        if (!check_ready())
+                return;
+
+        counters = counters_lookup(site);
+        start = counters_start(counters);
+        check_end(site, value);
+        counters_stop(counters, start, 1U, 1U);
+}
@@ -0,0 +1,191 @@
+/*
+ * Functions of the runtime verification library dealing with per-site
+ * counters.
+ * Copyright (C) 2023-2025 Antoni Blanche
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+#include <mpi.h>
+
+#include "counters.h"
+
+/*
+ * Counters state: 0 before the first lookup, 1 when counting and -1 if counters
+ * are disabled.
+ */
+static int counters_state = 0;
+
+static struct mpicoll_counters_header *counters_header = NULL;
+static struct mpicoll_counters_slot *counters_slots = NULL;
+static uint64_t counters_mask;
+
+/*
+ * Last site looked up, since MPI collectives are often checked in a row.
+ */
+static struct mpicoll_counters_slot *counters_last = NULL;
+
+/*
+ * Returns the number of slots of the hash table, read from the
+ * MPICOLL_COUNTERS_SIZE environment variable and rounded up to a power of 2.
+ */
+static uint64_t counters_capacity(void)
+{
+        const char *env = getenv("MPICOLL_COUNTERS_SIZE");
+        uint64_t size = MPICOLL_COUNTERS_DEFAULT_SIZE;
+        uint64_t res = 1;
+
+        if (env != NULL && strtoull(env, NULL, 10) > 0)
+                size = strtoull(env, NULL, 10);
+
+        while (res < size)
+                res = res << 1;
+
+        return res;
+}
+
+/*
+ * Creates and maps the counters file of the rank in dir. Returns 1 on success,
+ * 0 otherwise.
+ */
+static int counters_open(const char *const dir)
+{
+        char path[4096];
+        uint64_t capacity = counters_capacity();
+        size_t length;
+        void *map;
+        int rank, size;
+        int fd;
+
+        MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+        MPI_Comm_size(MPI_COMM_WORLD, &size);
+
+        snprintf(path, sizeof(path), "%s/%s.%d", dir, MPICOLL_COUNTERS_FILE,
+                 rank);
+
+        length = sizeof(struct mpicoll_counters_header)
+                 + capacity * sizeof(struct mpicoll_counters_slot);
+
+        fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+
+        if (fd == -1) {
+                perror("mpicoll: cannot create counters file");
+                return 0;
+        }
+
+        if (ftruncate(fd, length) == -1) {
+                perror("mpicoll: cannot create counters file");
+                close(fd);
+                return 0;
+        }
+
+        map = mmap(NULL, length, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        close(fd);
+
+        if (map == MAP_FAILED) {
+                perror("mpicoll: cannot map counters file");
+                return 0;
+        }
+
+        counters_header = map;
+        counters_slots = (struct mpicoll_counters_slot *) (counters_header + 1);
+        counters_mask = capacity - 1;
+
+        counters_header->rank = rank;
+        counters_header->size = size;
+        counters_header->capacity = capacity;
+        __atomic_store_n(&counters_header->magic, MPICOLL_COUNTERS_MAGIC,
+                         __ATOMIC_RELEASE);
+
+        return 1;
+}
+
+/*
+ * Returns 1 if sites can be counted, 0 otherwise. The counters file is created
+ * on first call after MPI_Init.
+ */
+static int counters_ready(void)
+{
+        const char *dir;
+        int flag;
+
+        if (__builtin_expect(counters_state != 0, 1))
+                return counters_state > 0;
+
+        dir = getenv("MPICOLL_COUNTERS_DIR");
+
+        if (dir == NULL || dir[0] == '\0') {
+                counters_state = -1;
+                return 0;
+        }
+
+        MPI_Initialized(&flag);
+
+        if (!flag)
+                return 0;
+
+        counters_state = counters_open(dir) ? 1 : -1;
+
+        return counters_state > 0;
+}
+
+/*
+ * Returns the counters of the site with ID site, or NULL if counters are
+ * disabled or the table is full. The counters file is created on first call
+ * after MPI_Init if the MPICOLL_COUNTERS_DIR environment variable is set.
+ */
+struct mpicoll_counters_slot *counters_lookup(const unsigned int site)
+{
+        struct mpicoll_counters_slot *slot;
+        uint64_t i, n;
+
+        if (!counters_ready())
+                return NULL;
+
+        if (counters_last != NULL && counters_last->site == site)
+                return counters_last;
+
+        i = mpicoll_counters_hash(site, counters_mask);
+
+        for (n = 0; n <= counters_mask; ++n, i = (i + 1) & counters_mask) {
+                slot = &(counters_slots[i]);
+
+                if (slot->used && slot->site == site)
+                        break;
+
+                if (!slot->used) {
+                        slot->site = site;
+                        __atomic_store_n(&slot->used, 1U, __ATOMIC_RELEASE);
+                        break;
+                }
+        }
+
+        if (n > counters_mask) {
+                __atomic_store_n(&counters_header->dropped,
+                                 counters_header->dropped + 1,
+                                 __ATOMIC_RELAXED);
+                return NULL;
+        }
+
+        counters_last = slot;
+
+        return slot;
+}
@@ -0,0 +1,72 @@
+/*
+ * Declarations and definitions of the per-site counters of the runtime
+ * verification library.
+ * Copyright (C) 2023-2025 Antoni Blanche
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef COUNTERS_H
+#define COUNTERS_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <time.h>
+
+#include "mpicoll_counters.h"
+
+/*
+ * Returns the counters of the site with ID site, or NULL if counters are
+ * disabled or the table is full. The counters file is created on first call
+ * after MPI_Init if the MPICOLL_COUNTERS_DIR environment variable is set.
+ */
+struct mpicoll_counters_slot *counters_lookup(unsigned int site);
+
+/*
+ * Returns the time the runtime library starts working for a site with counters
+ * slot, or 0 if slot is NULL.
+ */
+static inline uint64_t counters_start(const struct mpicoll_counters_slot *slot)
+{
+        struct timespec now;
+
+        if (slot == NULL)
+                return 0U;
+
+        clock_gettime(CLOCK_MONOTONIC, &now);
+
+        return (uint64_t) now.tv_sec * 1000000000U + now.tv_nsec;
+}
+
+/*
+ * Adds calls, checks and the time elapsed since start to slot, if not NULL.
+ * Counters are only written by the thread calling the runtime library, so that
+ * relaxed loads and stores are enough for readers to see whole values.
+ */
+static inline void counters_stop(struct mpicoll_counters_slot *const slot,
+                                 const uint64_t start, const uint64_t calls,
+                                 const uint64_t checks)
+{
+        uint64_t time;
+
+        if (slot == NULL)
+                return;
+
+        time = counters_start(slot) - start;
+        __atomic_store_n(&slot->calls, slot->calls + calls, __ATOMIC_RELAXED);
+        __atomic_store_n(&slot->checks, slot->checks + checks,
+                         __ATOMIC_RELAXED);
+        __atomic_store_n(&slot->time, slot->time + time, __ATOMIC_RELAXED);
+}
+
+#endif /* counters.h */
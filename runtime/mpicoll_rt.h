@@ -0,0 +1,79 @@
+/*
+ * Declarations and definitions of the runtime verification library.
+ * Copyright (C) 2023-2025 Antoni Blanche
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef MPICOLL_RT_H
+#define MPICOLL_RT_H
+
+/*
+ * Calls to the following functions are inserted by the plugin when built with
+ * -fplugin-arg-libmpiplugin-instrument. They are not meant to be called by
+ * hand.
+ *
+ * Each call carries the ID of the instrumented site, see
+ * include/mpicoll_sites.h. Site IDs are only mapped back to source locations
+ * when a mismatch is reported.
+ *
+ * Before each MPI collective, all ranks agree on the code of the MPI
+ * collective they are about to call. The agreement is a nonblocking reduction
+ * started by __mpicoll_check_begin() as early as the static analysis allows
+ * and completed by __mpicoll_check_end() right before the MPI collective. At
+ * most one agreement is pending per rank. If ranks disagree, the codes of all
+ * ranks are printed and the program is aborted.
+ *
+ * MPI collectives in a rank-uniform loop are not checked one by one: ranks
+ * entering the loop agree once on a negative value derived from the loop site
+ * ID. Such a value never matches a MPI collective code.
+ *
+ * A chain of MPI collectives always following each other is checked once at
+ * its first MPI collective: ranks agree on a hash of the sequence of codes,
+ * greater than or equal to 2^30.
+ *
+ * If the MPICOLL_STALL_TIMEOUT environment variable is set, a thread of each
+ * rank watches the number of agreements the rank waited for. Once no rank has
+ * made progress for that many seconds while one of them at least is waiting
+ * in the library, the last site of each rank is printed and the program is
+ * aborted. See runtime/stall.h.
+ *
+ * If the MPICOLL_COUNTERS_DIR environment variable is set, each rank counts
+ * the calls, agreements and time of the library per site in a file of that
+ * directory. See include/mpicoll_counters.h.
+ */
+
+/*
+ * Starts the agreement on value for the site with ID site.
+ */
+void __mpicoll_check_begin(unsigned int site, int value);
+
+/*
+ * Completes the agreement on value for the site with ID site.
+ */
+void __mpicoll_check_end(unsigned int site, int value);
+
+/*
+ * With -fplugin-arg-libmpiplugin-trace, each MPI collective but MPI_Init is
+ * recorded right before it is called in a per-rank ring buffer, along with its
+ * MPI collective code. The communicator is passed as an integer, or 0 if the
+ * MPI collective does not take one. See include/mpicoll_trace.h for the trace
+ * format.
+ */
+
+/*
+ * Records the call of the MPI collective with code and ID site on comm.
+ */
+void __mpicoll_trace(unsigned int site, int code, unsigned long long comm);
+
+#endif /* mpicoll_rt.h */
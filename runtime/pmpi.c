@@ -0,0 +1,834 @@
+/*
+ * PMPI interposition library checking that ranks call the same sequence of MPI
+ * collectives on each communicator, without recompiling the program.
+ * Copyright (C) 2023-2025 Antoni Blanche
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#define _GNU_SOURCE
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+
+#include <dlfcn.h>
+
+#include <mpi.h>
+
+#include "mpicoll_sites.h"
+
+/*
+ * Code and name of each MPI collective.
+ */
+#define DEF_MPI_COLLECTIVES(CODE, NAME) WRAP_##CODE,
+enum wrap_code {
+#include "MPI_collectives.def"
+        WRAP_LAST
+};
+#undef DEF_MPI_COLLECTIVES
+
+#define DEF_MPI_COLLECTIVES(CODE, NAME) NAME,
+static const char *const MPI_COLLECTIVE_NAME[] = {
+#include "MPI_collectives.def"
+};
+#undef DEF_MPI_COLLECTIVES
+
+/*
+ * Number of MPI collectives between two validations when the
+ * MPICOLL_CHECK_INTERVAL environment variable is not set.
+ */
+#define PMPI_DEFAULT_INTERVAL 64
+
+/*
+ * Sequence of MPI collectives called by the rank on a communicator. Each call
+ * is identified by a site ID with tag MPICOLL_SITES_PMPI_TAG and the MPI
+ * collective code as index, and folded into a 64-bit FNV-1a hash. The last
+ * 2 * pmpi_interval site IDs are kept to print where ranks diverge.
+ */
+struct pmpi_comm {
+        MPI_Comm shadow;        /* Duplicate used for validations, or
+                                   MPI_COMM_NULL if the communicator is not
+                                   checked */
+        uint64_t hash;          /* Hash of the sequence */
+        uint64_t count;         /* Number of calls */
+        uint64_t checked;       /* Number of calls at the last validation */
+        uint32_t *history;      /* Ring buffer of the last site IDs */
+};
+
+/*
+ * Attribute key of the struct pmpi_comm of each communicator, created on first
+ * use.
+ */
+static int pmpi_keyval = MPI_KEYVAL_INVALID;
+static uint64_t pmpi_interval;
+
+/*
+ * Frees the struct pmpi_comm of a communicator being freed. Its shadow
+ * communicator is freed by MPI_Comm_free() beforehand.
+ */
+static int pmpi_delete(MPI_Comm comm, int keyval, void *const attribute,
+                       void *const extra)
+{
+        struct pmpi_comm *c = attribute;
+
+        (void) comm;
+        (void) keyval;
+        (void) extra;
+
+        free(c->history);
+        free(c);
+
+        return MPI_SUCCESS;
+}
+
+/*
+ * Returns the struct pmpi_comm of comm, creating it on first use.
+ * Intercommunicators are not checked.
+ */
+static struct pmpi_comm *pmpi_comm(const MPI_Comm comm)
+{
+        const char *env;
+        struct pmpi_comm *c;
+        int flag;
+
+        if (pmpi_keyval == MPI_KEYVAL_INVALID) {
+                env = getenv("MPICOLL_CHECK_INTERVAL");
+                pmpi_interval = PMPI_DEFAULT_INTERVAL;
+
+                if (env != NULL && strtoull(env, NULL, 10) > 0)
+                        pmpi_interval = strtoull(env, NULL, 10);
+
+                PMPI_Comm_create_keyval(MPI_COMM_NULL_COPY_FN, &pmpi_delete,
+                                        &pmpi_keyval, NULL);
+        }
+
+        PMPI_Comm_get_attr(comm, pmpi_keyval, &c, &flag);
+
+        if (flag)
+                return c;
+
+        c = calloc(1, sizeof(*c));
+
+        if (c == NULL)
+                PMPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+
+        c->hash = 14695981039346656037ULL;
+        c->shadow = MPI_COMM_NULL;
+        PMPI_Comm_test_inter(comm, &flag);
+
+        if (!flag) {
+                c->history = malloc(2U * pmpi_interval
+                                    * sizeof(*(c->history)));
+
+                if (c->history == NULL)
+                        PMPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+
+                PMPI_Comm_dup(comm, &(c->shadow));
+        }
+
+        PMPI_Comm_set_attr(comm, pmpi_keyval, c);
+
+        return c;
+}
+
+/*
+ * Returns the name of the MPI collective with site ID id.
+ */
+static const char *pmpi_name(const uint32_t id)
+{
+        const uint32_t code = MPICOLL_SITES_INDEX(id);
+
+        if (MPICOLL_SITES_TAG(id) != MPICOLL_SITES_PMPI_TAG
+            || code >= WRAP_LAST)
+                return "unknown";
+
+        return MPI_COLLECTIVE_NAME[code];
+}
+
+/*
+ * Prints the first call where the ranks of c diverge and aborts. The call
+ * count and history of each rank are gathered on rank 0 of c, which prints
+ * them. The calls before the last validation are known to match.
+ */
+static void pmpi_report(const struct pmpi_comm *const c)
+{
+        const int length = (int) (2U * pmpi_interval);
+        uint64_t *counts = NULL;
+        uint32_t *histories = NULL;
+        int *ranks = NULL;
+        MPI_Group group, world;
+        uint64_t n, last = c->count;
+        int rank, size;
+        int i;
+
+        PMPI_Comm_rank(c->shadow, &rank);
+        PMPI_Comm_size(c->shadow, &size);
+
+        if (rank == 0) {
+                counts = malloc(size * sizeof(*counts));
+                histories = malloc(size * length * sizeof(*histories));
+                ranks = malloc(2 * size * sizeof(*ranks));
+
+                if (counts == NULL || histories == NULL || ranks == NULL)
+                        PMPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+        }
+
+        PMPI_Gather(&(c->count), 1, MPI_UINT64_T, counts, 1, MPI_UINT64_T, 0,
+                    c->shadow);
+        PMPI_Gather(c->history, length, MPI_UINT32_T, histories, length,
+                    MPI_UINT32_T, 0, c->shadow);
+
+        /* Other ranks wait for rank 0 to abort */
+        if (rank != 0) {
+                PMPI_Barrier(c->shadow);
+                return;
+        }
+
+        for (i = 0; i < size; ++i) {
+                ranks[i] = i;
+                last = counts[i] > last ? counts[i] : last;
+        }
+
+        PMPI_Comm_group(c->shadow, &group);
+        PMPI_Comm_group(MPI_COMM_WORLD, &world);
+        PMPI_Group_translate_ranks(group, size, ranks, world, ranks + size);
+
+        for (n = c->checked; n < last; ++n) {
+                for (i = 0; i < size; ++i) {
+                        if (counts[i] <= n || histories[i * length + n % length]
+                                              != histories[n % length])
+                                break;
+                }
+
+                if (i < size)
+                        break;
+        }
+
+        fprintf(stderr, "mpicoll: MPI collective sequence mismatch detected\n"
+                "mpicoll: ranks diverge at call %llu on communicator of size "
+                "%d led by rank %d\n", (unsigned long long) n, size,
+                ranks[size]);
+
+        for (i = 0; i < size; ++i) {
+                if (counts[i] <= n)
+                        fprintf(stderr, "mpicoll:   rank %d: did not call it\n",
+                                ranks[size + i]);
+                else
+                        fprintf(stderr, "mpicoll:   rank %d: %s\n",
+                                ranks[size + i],
+                                pmpi_name(histories[i * length + n % length]));
+        }
+
+        fflush(stderr);
+        PMPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+}
+
+/*
+ * Checks that all ranks of c called the same sequence of MPI collectives. The
+ * maximums of the hash and of its complement are equal up to the complement if
+ * and only if all ranks have the same hash, so that a single reduction
+ * validates the sequence.
+ */
+static void pmpi_validate(struct pmpi_comm *const c)
+{
+        uint64_t send[2], recv[2];
+
+        send[0] = c->hash;
+        send[1] = ~c->hash;
+        PMPI_Allreduce(send, recv, 2, MPI_UINT64_T, MPI_MAX, c->shadow);
+
+        if (recv[0] != ~recv[1])
+                pmpi_report(c);
+
+        c->checked = c->count;
+}
+
+/*
+ * Records a call to the MPI collective with code on comm. Returns the struct
+ * pmpi_comm of comm, or NULL if comm is not checked.
+ */
+static struct pmpi_comm *pmpi_enter(const MPI_Comm comm, const int code)
+{
+        const uint32_t id = MPICOLL_SITES_ID(MPICOLL_SITES_PMPI_TAG,
+                                             (uint32_t) code);
+        struct pmpi_comm *c;
+
+        if (comm == MPI_COMM_NULL)
+                return NULL;
+
+        c = pmpi_comm(comm);
+
+        if (c->shadow == MPI_COMM_NULL)
+                return NULL;
+
+        c->history[c->count % (2U * pmpi_interval)] = id;
+        c->hash = (c->hash ^ id) * 1099511628211ULL;
+        c->count = c->count + 1U;
+
+        return c;
+}
+
+/*
+ * Returns err once the call recorded in c returned. Validations are
+ * piggybacked on MPI_Barrier once pmpi_interval calls are pending, and forced
+ * once 2 * pmpi_interval calls are pending.
+ */
+static int pmpi_leave(struct pmpi_comm *const c, const int err)
+{
+        if (c != NULL && c->count - c->checked >= 2U * pmpi_interval)
+                pmpi_validate(c);
+
+        return err;
+}
+
+/*
+ * Returns the next definition of MPI_Finalize, such as the one of the runtime
+ * verification library, or PMPI_Finalize if there is none.
+ */
+static int pmpi_finalize(void)
+{
+        int (*next)(void) = (int (*)(void)) dlsym(RTLD_NEXT, "MPI_Finalize");
+
+        return next != NULL ? next() : PMPI_Finalize();
+}
+
+int MPI_Finalize(void)
+{
+        struct pmpi_comm *c;
+        int flag = 0;
+
+        if (pmpi_keyval != MPI_KEYVAL_INVALID)
+                PMPI_Comm_get_attr(MPI_COMM_WORLD, pmpi_keyval, &c, &flag);
+
+        /* Other communicators are validated when freed */
+        if (flag && c->shadow != MPI_COMM_NULL) {
+                pmpi_validate(c);
+                PMPI_Comm_free(&(c->shadow));
+                PMPI_Comm_delete_attr(MPI_COMM_WORLD, pmpi_keyval);
+        }
+
+        return pmpi_finalize();
+}
+
+int MPI_Comm_free(MPI_Comm *comm)
+{
+        struct pmpi_comm *c;
+        int flag = 0;
+
+        if (pmpi_keyval != MPI_KEYVAL_INVALID && *comm != MPI_COMM_NULL)
+                PMPI_Comm_get_attr(*comm, pmpi_keyval, &c, &flag);
+
+        if (flag && c->shadow != MPI_COMM_NULL) {
+                pmpi_validate(c);
+                PMPI_Comm_free(&(c->shadow));
+        }
+
+        return PMPI_Comm_free(comm);
+}
+
+/*
+ * A due validation synchronizes the ranks as MPI_Barrier would, so it replaces
+ * the barrier instead of adding a reduction.
+ */
+int MPI_Barrier(MPI_Comm comm)
+{
+        struct pmpi_comm *c = pmpi_enter(comm, WRAP_MPI_BARRIER);
+
+        if (c != NULL && c->count - c->checked >= pmpi_interval) {
+                pmpi_validate(c);
+                return MPI_SUCCESS;
+        }
+
+        return pmpi_leave(c, PMPI_Barrier(comm));
+}
+
+int MPI_Reduce(const void *sendbuf, void *recvbuf, int count,
+               MPI_Datatype datatype, MPI_Op op, int root, MPI_Comm comm)
+{
+        struct pmpi_comm *c = pmpi_enter(comm, WRAP_MPI_REDUCE);
+
+        return pmpi_leave(c, PMPI_Reduce(sendbuf, recvbuf, count, datatype, op,
+                                         root, comm));
+}
+
+int MPI_Allreduce(const void *sendbuf, void *recvbuf, int count,
+                  MPI_Datatype datatype, MPI_Op op, MPI_Comm comm)
+{
+        struct pmpi_comm *c = pmpi_enter(comm, WRAP_MPI_ALLREDUCE);
+
+        return pmpi_leave(c, PMPI_Allreduce(sendbuf, recvbuf, count, datatype,
+                                            op, comm));
+}
+
+int MPI_Bcast(void *buffer, int count, MPI_Datatype datatype, int root,
+              MPI_Comm comm)
+{
+        struct pmpi_comm *c = pmpi_enter(comm, WRAP_MPI_BCAST);
+
+        return pmpi_leave(c, PMPI_Bcast(buffer, count, datatype, root, comm));
+}
+
+int MPI_Gather(const void *sendbuf, int sendcount, MPI_Datatype sendtype,
+               void *recvbuf, int recvcount, MPI_Datatype recvtype, int root,
+               MPI_Comm comm)
+{
+        struct pmpi_comm *c = pmpi_enter(comm, WRAP_MPI_GATHER);
+
+        return pmpi_leave(c, PMPI_Gather(sendbuf, sendcount, sendtype, recvbuf,
+                                         recvcount, recvtype, root, comm));
+}
+
+int MPI_Gatherv(const void *sendbuf, int sendcount, MPI_Datatype sendtype,
+                void *recvbuf, const int recvcounts[], const int displs[],
+                MPI_Datatype recvtype, int root, MPI_Comm comm)
+{
+        struct pmpi_comm *c = pmpi_enter(comm, WRAP_MPI_GATHERV);
+
+        return pmpi_leave(c, PMPI_Gatherv(sendbuf, sendcount, sendtype, recvbuf,
+                                          recvcounts, displs, recvtype, root,
+                                          comm));
+}
+
+int MPI_Scatter(const void *sendbuf, int sendcount, MPI_Datatype sendtype,
+                void *recvbuf, int recvcount, MPI_Datatype recvtype, int root,
+                MPI_Comm comm)
+{
+        struct pmpi_comm *c = pmpi_enter(comm, WRAP_MPI_SCATTER);
+
+        return pmpi_leave(c, PMPI_Scatter(sendbuf, sendcount, sendtype, recvbuf,
+                                          recvcount, recvtype, root, comm));
+}
+
+int MPI_Scatterv(const void *sendbuf, const int sendcounts[],
+                 const int displs[], MPI_Datatype sendtype, void *recvbuf,
+                 int recvcount, MPI_Datatype recvtype, int root, MPI_Comm comm)
+{
+        struct pmpi_comm *c = pmpi_enter(comm, WRAP_MPI_SCATTERV);
+
+        return pmpi_leave(c, PMPI_Scatterv(sendbuf, sendcounts, displs,
+                                           sendtype, recvbuf, recvcount,
+                                           recvtype, root, comm));
+}
+
+int MPI_Allgather(const void *sendbuf, int sendcount, MPI_Datatype sendtype,
+                  void *recvbuf, int recvcount, MPI_Datatype recvtype,
+                  MPI_Comm comm)
+{
+        struct pmpi_comm *c = pmpi_enter(comm, WRAP_MPI_ALLGATHER);
+
+        return pmpi_leave(c, PMPI_Allgather(sendbuf, sendcount, sendtype,
+                                            recvbuf, recvcount, recvtype,
+                                            comm));
+}
+
+int MPI_Allgatherv(const void *sendbuf, int sendcount, MPI_Datatype sendtype,
+                   void *recvbuf, const int recvcounts[], const int displs[],
+                   MPI_Datatype recvtype, MPI_Comm comm)
+{
+        struct pmpi_comm *c = pmpi_enter(comm, WRAP_MPI_ALLGATHERV);
+
+        return pmpi_leave(c, PMPI_Allgatherv(sendbuf, sendcount, sendtype,
+                                             recvbuf, recvcounts, displs,
+                                             recvtype, comm));
+}
+
+int MPI_Alltoall(const void *sendbuf, int sendcount, MPI_Datatype sendtype,
+                 void *recvbuf, int recvcount, MPI_Datatype recvtype,
+                 MPI_Comm comm)
+{
+        struct pmpi_comm *c = pmpi_enter(comm, WRAP_MPI_ALLTOALL);
+
+        return pmpi_leave(c, PMPI_Alltoall(sendbuf, sendcount, sendtype,
+                                           recvbuf, recvcount, recvtype, comm));
+}
+
+int MPI_Alltoallv(const void *sendbuf, const int sendcounts[],
+                  const int sdispls[], MPI_Datatype sendtype, void *recvbuf,
+                  const int recvcounts[], const int rdispls[],
+                  MPI_Datatype recvtype, MPI_Comm comm)
+{
+        struct pmpi_comm *c = pmpi_enter(comm, WRAP_MPI_ALLTOALLV);
+
+        return pmpi_leave(c, PMPI_Alltoallv(sendbuf, sendcounts, sdispls,
+                                            sendtype, recvbuf, recvcounts,
+                                            rdispls, recvtype, comm));
+}
+
+int MPI_Alltoallw(const void *sendbuf, const int sendcounts[],
+                  const int sdispls[], const MPI_Datatype sendtypes[],
+                  void *recvbuf, const int recvcounts[], const int rdispls[],
+                  const MPI_Datatype recvtypes[], MPI_Comm comm)
+{
+        struct pmpi_comm *c = pmpi_enter(comm, WRAP_MPI_ALLTOALLW);
+
+        return pmpi_leave(c, PMPI_Alltoallw(sendbuf, sendcounts, sdispls,
+                                            sendtypes, recvbuf, recvcounts,
+                                            rdispls, recvtypes, comm));
+}
+
+int MPI_Reduce_scatter_block(const void *sendbuf, void *recvbuf, int recvcount,
+                             MPI_Datatype datatype, MPI_Op op, MPI_Comm comm)
+{
+        struct pmpi_comm *c = pmpi_enter(comm, WRAP_MPI_REDUCE_SCATTER_BLOCK);
+
+        return pmpi_leave(c, PMPI_Reduce_scatter_block(sendbuf, recvbuf,
+                                                       recvcount, datatype, op,
+                                                       comm));
+}
+
+int MPI_Reduce_scatter(const void *sendbuf, void *recvbuf,
+                       const int recvcounts[], MPI_Datatype datatype, MPI_Op op,
+                       MPI_Comm comm)
+{
+        struct pmpi_comm *c = pmpi_enter(comm, WRAP_MPI_REDUCE_SCATTER);
+
+        return pmpi_leave(c, PMPI_Reduce_scatter(sendbuf, recvbuf, recvcounts,
+                                                 datatype, op, comm));
+}
+
+int MPI_Scan(const void *sendbuf, void *recvbuf, int count,
+             MPI_Datatype datatype, MPI_Op op, MPI_Comm comm)
+{
+        struct pmpi_comm *c = pmpi_enter(comm, WRAP_MPI_SCAN);
+
+        return pmpi_leave(c, PMPI_Scan(sendbuf, recvbuf, count, datatype, op,
+                                       comm));
+}
+
+int MPI_Exscan(const void *sendbuf, void *recvbuf, int count,
+               MPI_Datatype datatype, MPI_Op op, MPI_Comm comm)
+{
+        struct pmpi_comm *c = pmpi_enter(comm, WRAP_MPI_EXSCAN);
+
+        return pmpi_leave(c, PMPI_Exscan(sendbuf, recvbuf, count, datatype, op,
+                                         comm));
+}
+
+int MPI_Neighbor_allgather(const void *sendbuf, int sendcount,
+                           MPI_Datatype sendtype, void *recvbuf, int recvcount,
+                           MPI_Datatype recvtype, MPI_Comm comm)
+{
+        struct pmpi_comm *c = pmpi_enter(comm, WRAP_MPI_NEIGHBOR_ALLGATHER);
+
+        return pmpi_leave(c, PMPI_Neighbor_allgather(sendbuf, sendcount,
+                                                     sendtype, recvbuf,
+                                                     recvcount, recvtype,
+                                                     comm));
+}
+
+int MPI_Neighbor_allgatherv(const void *sendbuf, int sendcount,
+                            MPI_Datatype sendtype, void *recvbuf,
+                            const int recvcounts[], const int displs[],
+                            MPI_Datatype recvtype, MPI_Comm comm)
+{
+        struct pmpi_comm *c = pmpi_enter(comm, WRAP_MPI_NEIGHBOR_ALLGATHERV);
+
+        return pmpi_leave(c, PMPI_Neighbor_allgatherv(sendbuf, sendcount,
+                                                      sendtype, recvbuf,
+                                                      recvcounts, displs,
+                                                      recvtype, comm));
+}
+
+int MPI_Neighbor_alltoall(const void *sendbuf, int sendcount,
+                          MPI_Datatype sendtype, void *recvbuf, int recvcount,
+                          MPI_Datatype recvtype, MPI_Comm comm)
+{
+        struct pmpi_comm *c = pmpi_enter(comm, WRAP_MPI_NEIGHBOR_ALLTOALL);
+
+        return pmpi_leave(c, PMPI_Neighbor_alltoall(sendbuf, sendcount,
+                                                    sendtype, recvbuf,
+                                                    recvcount, recvtype, comm));
+}
+
+int MPI_Neighbor_alltoallv(const void *sendbuf, const int sendcounts[],
+                           const int sdispls[], MPI_Datatype sendtype,
+                           void *recvbuf, const int recvcounts[],
+                           const int rdispls[], MPI_Datatype recvtype,
+                           MPI_Comm comm)
+{
+        struct pmpi_comm *c = pmpi_enter(comm, WRAP_MPI_NEIGHBOR_ALLTOALLV);
+
+        return pmpi_leave(c, PMPI_Neighbor_alltoallv(sendbuf, sendcounts,
+                                                     sdispls, sendtype, recvbuf,
+                                                     recvcounts, rdispls,
+                                                     recvtype, comm));
+}
+
+int MPI_Neighbor_alltoallw(const void *sendbuf, const int sendcounts[],
+                           const MPI_Aint sdispls[],
+                           const MPI_Datatype sendtypes[], void *recvbuf,
+                           const int recvcounts[], const MPI_Aint rdispls[],
+                           const MPI_Datatype recvtypes[], MPI_Comm comm)
+{
+        struct pmpi_comm *c = pmpi_enter(comm, WRAP_MPI_NEIGHBOR_ALLTOALLW);
+
+        return pmpi_leave(c, PMPI_Neighbor_alltoallw(sendbuf, sendcounts,
+                                                     sdispls, sendtypes,
+                                                     recvbuf, recvcounts,
+                                                     rdispls, recvtypes, comm));
+}
+
+int MPI_Ibarrier(MPI_Comm comm, MPI_Request *request)
+{
+        struct pmpi_comm *c = pmpi_enter(comm, WRAP_MPI_IBARRIER);
+
+        return pmpi_leave(c, PMPI_Ibarrier(comm, request));
+}
+
+int MPI_Ibcast(void *buffer, int count, MPI_Datatype datatype, int root,
+               MPI_Comm comm, MPI_Request *request)
+{
+        struct pmpi_comm *c = pmpi_enter(comm, WRAP_MPI_IBCAST);
+
+        return pmpi_leave(c, PMPI_Ibcast(buffer, count, datatype, root, comm,
+                                         request));
+}
+
+int MPI_Igather(const void *sendbuf, int sendcount, MPI_Datatype sendtype,
+                void *recvbuf, int recvcount, MPI_Datatype recvtype, int root,
+                MPI_Comm comm, MPI_Request *request)
+{
+        struct pmpi_comm *c = pmpi_enter(comm, WRAP_MPI_IGATHER);
+
+        return pmpi_leave(c, PMPI_Igather(sendbuf, sendcount, sendtype, recvbuf,
+                                          recvcount, recvtype, root, comm,
+                                          request));
+}
+
+int MPI_Igatherv(const void *sendbuf, int sendcount, MPI_Datatype sendtype,
+                 void *recvbuf, const int recvcounts[], const int displs[],
+                 MPI_Datatype recvtype, int root, MPI_Comm comm,
+                 MPI_Request *request)
+{
+        struct pmpi_comm *c = pmpi_enter(comm, WRAP_MPI_IGATHERV);
+
+        return pmpi_leave(c, PMPI_Igatherv(sendbuf, sendcount, sendtype,
+                                           recvbuf, recvcounts, displs,
+                                           recvtype, root, comm, request));
+}
+
+int MPI_Iscatter(const void *sendbuf, int sendcount, MPI_Datatype sendtype,
+                 void *recvbuf, int recvcount, MPI_Datatype recvtype, int root,
+                 MPI_Comm comm, MPI_Request *request)
+{
+        struct pmpi_comm *c = pmpi_enter(comm, WRAP_MPI_ISCATTER);
+
+        return pmpi_leave(c, PMPI_Iscatter(sendbuf, sendcount, sendtype,
+                                           recvbuf, recvcount, recvtype, root,
+                                           comm, request));
+}
+
+int MPI_Iscatterv(const void *sendbuf, const int sendcounts[],
+                  const int displs[], MPI_Datatype sendtype, void *recvbuf,
+                  int recvcount, MPI_Datatype recvtype, int root, MPI_Comm comm,
+                  MPI_Request *request)
+{
+        struct pmpi_comm *c = pmpi_enter(comm, WRAP_MPI_ISCATTERV);
+
+        return pmpi_leave(c, PMPI_Iscatterv(sendbuf, sendcounts, displs,
+                                            sendtype, recvbuf, recvcount,
+                                            recvtype, root, comm, request));
+}
+
+int MPI_Iallgather(const void *sendbuf, int sendcount, MPI_Datatype sendtype,
+                   void *recvbuf, int recvcount, MPI_Datatype recvtype,
+                   MPI_Comm comm, MPI_Request *request)
+{
+        struct pmpi_comm *c = pmpi_enter(comm, WRAP_MPI_IALLGATHER);
+
+        return pmpi_leave(c, PMPI_Iallgather(sendbuf, sendcount, sendtype,
+                                             recvbuf, recvcount, recvtype, comm,
+                                             request));
+}
+
+int MPI_Iallgatherv(const void *sendbuf, int sendcount, MPI_Datatype sendtype,
+                    void *recvbuf, const int recvcounts[], const int displs[],
+                    MPI_Datatype recvtype, MPI_Comm comm, MPI_Request *request)
+{
+        struct pmpi_comm *c = pmpi_enter(comm, WRAP_MPI_IALLGATHERV);
+
+        return pmpi_leave(c, PMPI_Iallgatherv(sendbuf, sendcount, sendtype,
+                                              recvbuf, recvcounts, displs,
+                                              recvtype, comm, request));
+}
+
+int MPI_Ialltoall(const void *sendbuf, int sendcount, MPI_Datatype sendtype,
+                  void *recvbuf, int recvcount, MPI_Datatype recvtype,
+                  MPI_Comm comm, MPI_Request *request)
+{
+        struct pmpi_comm *c = pmpi_enter(comm, WRAP_MPI_IALLTOALL);
+
+        return pmpi_leave(c, PMPI_Ialltoall(sendbuf, sendcount, sendtype,
+                                            recvbuf, recvcount, recvtype, comm,
+                                            request));
+}
+
+int MPI_Ialltoallv(const void *sendbuf, const int sendcounts[],
+                   const int sdispls[], MPI_Datatype sendtype, void *recvbuf,
+                   const int recvcounts[], const int rdispls[],
+                   MPI_Datatype recvtype, MPI_Comm comm, MPI_Request *request)
+{
+        struct pmpi_comm *c = pmpi_enter(comm, WRAP_MPI_IALLTOALLV);
+
+        return pmpi_leave(c, PMPI_Ialltoallv(sendbuf, sendcounts, sdispls,
+                                             sendtype, recvbuf, recvcounts,
+                                             rdispls, recvtype, comm, request));
+}
+
+int MPI_Ialltoallw(const void *sendbuf, const int sendcounts[],
+                   const int sdispls[], const MPI_Datatype sendtypes[],
+                   void *recvbuf, const int recvcounts[], const int rdispls[],
+                   const MPI_Datatype recvtypes[], MPI_Comm comm,
+                   MPI_Request *request)
+{
+        struct pmpi_comm *c = pmpi_enter(comm, WRAP_MPI_IALLTOALLW);
+
+        return pmpi_leave(c, PMPI_Ialltoallw(sendbuf, sendcounts, sdispls,
+                                             sendtypes, recvbuf, recvcounts,
+                                             rdispls, recvtypes, comm,
+                                             request));
+}
+
+int MPI_Ireduce(const void *sendbuf, void *recvbuf, int count,
+                MPI_Datatype datatype, MPI_Op op, int root, MPI_Comm comm,
+                MPI_Request *request)
+{
+        struct pmpi_comm *c = pmpi_enter(comm, WRAP_MPI_IREDUCE);
+
+        return pmpi_leave(c, PMPI_Ireduce(sendbuf, recvbuf, count, datatype, op,
+                                          root, comm, request));
+}
+
+int MPI_Iallreduce(const void *sendbuf, void *recvbuf, int count,
+                   MPI_Datatype datatype, MPI_Op op, MPI_Comm comm,
+                   MPI_Request *request)
+{
+        struct pmpi_comm *c = pmpi_enter(comm, WRAP_MPI_IALLREDUCE);
+
+        return pmpi_leave(c, PMPI_Iallreduce(sendbuf, recvbuf, count, datatype,
+                                             op, comm, request));
+}
+
+int MPI_Ireduce_scatter_block(const void *sendbuf, void *recvbuf, int recvcount,
+                              MPI_Datatype datatype, MPI_Op op, MPI_Comm comm,
+                              MPI_Request *request)
+{
+        struct pmpi_comm *c = pmpi_enter(comm, WRAP_MPI_IREDUCE_SCATTER_BLOCK);
+
+        return pmpi_leave(c, PMPI_Ireduce_scatter_block(sendbuf, recvbuf,
+                                                        recvcount, datatype, op,
+                                                        comm, request));
+}
+
+int MPI_Ireduce_scatter(const void *sendbuf, void *recvbuf,
+                        const int recvcounts[], MPI_Datatype datatype,
+                        MPI_Op op, MPI_Comm comm, MPI_Request *request)
+{
+        struct pmpi_comm *c = pmpi_enter(comm, WRAP_MPI_IREDUCE_SCATTER);
+
+        return pmpi_leave(c, PMPI_Ireduce_scatter(sendbuf, recvbuf, recvcounts,
+                                                  datatype, op, comm, request));
+}
+
+int MPI_Iscan(const void *sendbuf, void *recvbuf, int count,
+              MPI_Datatype datatype, MPI_Op op, MPI_Comm comm,
+              MPI_Request *request)
+{
+        struct pmpi_comm *c = pmpi_enter(comm, WRAP_MPI_ISCAN);
+
+        return pmpi_leave(c, PMPI_Iscan(sendbuf, recvbuf, count, datatype, op,
+                                        comm, request));
+}
+
+int MPI_Iexscan(const void *sendbuf, void *recvbuf, int count,
+                MPI_Datatype datatype, MPI_Op op, MPI_Comm comm,
+                MPI_Request *request)
+{
+        struct pmpi_comm *c = pmpi_enter(comm, WRAP_MPI_IEXSCAN);
+
+        return pmpi_leave(c, PMPI_Iexscan(sendbuf, recvbuf, count, datatype, op,
+                                          comm, request));
+}
+
+int MPI_Ineighbor_allgather(const void *sendbuf, int sendcount,
+                            MPI_Datatype sendtype, void *recvbuf, int recvcount,
+                            MPI_Datatype recvtype, MPI_Comm comm,
+                            MPI_Request *request)
+{
+        struct pmpi_comm *c = pmpi_enter(comm, WRAP_MPI_INEIGHBOR_ALLGATHER);
+
+        return pmpi_leave(c, PMPI_Ineighbor_allgather(sendbuf, sendcount,
+                                                      sendtype, recvbuf,
+                                                      recvcount, recvtype, comm,
+                                                      request));
+}
+
+int MPI_Ineighbor_allgatherv(const void *sendbuf, int sendcount,
+                             MPI_Datatype sendtype, void *recvbuf,
+                             const int recvcounts[], const int displs[],
+                             MPI_Datatype recvtype, MPI_Comm comm,
+                             MPI_Request *request)
+{
+        struct pmpi_comm *c = pmpi_enter(comm, WRAP_MPI_INEIGHBOR_ALLGATHERV);
+
+        return pmpi_leave(c, PMPI_Ineighbor_allgatherv(sendbuf, sendcount,
+                                                       sendtype, recvbuf,
+                                                       recvcounts, displs,
+                                                       recvtype, comm,
+                                                       request));
+}
+
+int MPI_Ineighbor_alltoall(const void *sendbuf, int sendcount,
+                           MPI_Datatype sendtype, void *recvbuf, int recvcount,
+                           MPI_Datatype recvtype, MPI_Comm comm,
+                           MPI_Request *request)
+{
+        struct pmpi_comm *c = pmpi_enter(comm, WRAP_MPI_INEIGHBOR_ALLTOALL);
+
+        return pmpi_leave(c, PMPI_Ineighbor_alltoall(sendbuf, sendcount,
+                                                     sendtype, recvbuf,
+                                                     recvcount, recvtype, comm,
+                                                     request));
+}
+
+int MPI_Ineighbor_alltoallv(const void *sendbuf, const int sendcounts[],
+                            const int sdispls[], MPI_Datatype sendtype,
+                            void *recvbuf, const int recvcounts[],
+                            const int rdispls[], MPI_Datatype recvtype,
+                            MPI_Comm comm, MPI_Request *request)
+{
+        struct pmpi_comm *c = pmpi_enter(comm, WRAP_MPI_INEIGHBOR_ALLTOALLV);
+
+        return pmpi_leave(c, PMPI_Ineighbor_alltoallv(sendbuf, sendcounts,
+                                                      sdispls, sendtype,
+                                                      recvbuf, recvcounts,
+                                                      rdispls, recvtype, comm,
+                                                      request));
+}
+
+int MPI_Ineighbor_alltoallw(const void *sendbuf, const int sendcounts[],
+                            const MPI_Aint sdispls[],
+                            const MPI_Datatype sendtypes[], void *recvbuf,
+                            const int recvcounts[], const MPI_Aint rdispls[],
+                            const MPI_Datatype recvtypes[], MPI_Comm comm,
+                            MPI_Request *request)
+{
+        struct pmpi_comm *c = pmpi_enter(comm, WRAP_MPI_INEIGHBOR_ALLTOALLW);
+
+        return pmpi_leave(c, PMPI_Ineighbor_alltoallw(sendbuf, sendcounts,
+                                                      sdispls, sendtypes,
+                                                      recvbuf, recvcounts,
+                                                      rdispls, recvtypes, comm,
+                                                      request));
+}
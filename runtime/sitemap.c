@@ -0,0 +1,421 @@
+/*
+ * Functions of the runtime verification library dealing with site IDs mapping.
+ * Copyright (C) 2023-2025 Antoni Blanche
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#define _GNU_SOURCE
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+
+#include <link.h>
+
+#include "sitemap.h"
+
+/*
+ * Contents of the .mpicoll_sites section of an ELF file, loaded on first
+ * lookup and kept until the end of the program.
+ */
+struct sitemap_table {
+        char *path;
+        unsigned char *data;
+        size_t size;
+        struct sitemap_table *next;
+};
+
+static struct sitemap_table *sitemap_tables = NULL;
+
+/*
+ * Reads size bytes at offset in file into buf. Returns 1 on success, 0
+ * otherwise.
+ */
+static int sitemap_read(FILE *const file, const long offset,
+                        void *const buf, const size_t size)
+{
+        return fseek(file, offset, SEEK_SET) == 0
+               && fread(buf, 1, size, file) == size;
+}
+
+/*
+ * Loads the .mpicoll_sites section of the ELF file at path into table. The
+ * section is left empty if it does not exist.
+ */
+static void sitemap_load(const char *const path,
+                         struct sitemap_table *const table)
+{
+        ElfW(Ehdr) ehdr;
+        ElfW(Shdr) *shdrs = NULL;
+        char *names = NULL;
+        FILE *file;
+        int i;
+
+        table->data = NULL;
+        table->size = 0;
+
+        file = fopen(path, "rb");
+
+        if (file == NULL)
+                return;
+
+        if (!sitemap_read(file, 0, &ehdr, sizeof(ehdr))
+            || memcmp(ehdr.e_ident, ELFMAG, SELFMAG) != 0
+            || ehdr.e_shentsize != sizeof(ElfW(Shdr))
+            || ehdr.e_shstrndx >= ehdr.e_shnum)
+                goto out;
+
+        shdrs = malloc(ehdr.e_shnum * sizeof(ElfW(Shdr)));
+
+        if (shdrs == NULL || !sitemap_read(file, ehdr.e_shoff, shdrs,
+                                           ehdr.e_shnum * sizeof(ElfW(Shdr))))
+                goto out;
+
+        names = malloc(shdrs[ehdr.e_shstrndx].sh_size + 1);
+
+        if (names == NULL
+            || !sitemap_read(file, shdrs[ehdr.e_shstrndx].sh_offset, names,
+                             shdrs[ehdr.e_shstrndx].sh_size))
+                goto out;
+
+        names[shdrs[ehdr.e_shstrndx].sh_size] = '\0';
+
+        for (i = 0; i < ehdr.e_shnum; ++i) {
+                if (shdrs[i].sh_name < shdrs[ehdr.e_shstrndx].sh_size
+                    && strcmp(names + shdrs[i].sh_name,
+                              MPICOLL_SITES_SECTION) == 0)
+                        break;
+        }
+
+        if (i == ehdr.e_shnum)
+                goto out;
+
+        table->data = malloc(shdrs[i].sh_size);
+
+        if (table->data != NULL
+            && sitemap_read(file, shdrs[i].sh_offset, table->data,
+                            shdrs[i].sh_size))
+                table->size = shdrs[i].sh_size;
+
+out:
+        free(names);
+        free(shdrs);
+        fclose(file);
+}
+
+/*
+ * Returns the 32-bit number at offset in table.
+ */
+static uint32_t sitemap_u32(const struct sitemap_table *const table,
+                            const size_t offset)
+{
+        uint32_t res;
+
+        memcpy(&res, table->data + offset, sizeof(res));
+
+        return res;
+}
+
+/*
+ * Returns the offset of the first block at or after offset in table, or the
+ * size of table if there is none.
+ */
+static size_t sitemap_block(const struct sitemap_table *const table,
+                            size_t offset)
+{
+        uint32_t size;
+
+        for (; offset + 4 * sizeof(uint32_t) <= table->size;
+             offset = offset + MPICOLL_SITES_ALIGN) {
+                if (sitemap_u32(table, offset) != MPICOLL_SITES_MAGIC)
+                        continue;
+
+                size = sitemap_u32(table, offset + 12);
+
+                if (size < 4 * sizeof(uint32_t) || offset + size > table->size)
+                        break;
+
+                return offset;
+        }
+
+        return table->size;
+}
+
+/*
+ * Returns the offset of the first block after the block at offset in table, or
+ * the size of table if there is none.
+ */
+static size_t sitemap_next(const struct sitemap_table *const table,
+                           const size_t offset)
+{
+        const uint32_t size = sitemap_u32(table, offset + 12);
+
+        return sitemap_block(table, offset + (size + MPICOLL_SITES_ALIGN - 1)
+                                    / MPICOLL_SITES_ALIGN
+                                    * MPICOLL_SITES_ALIGN);
+}
+
+/*
+ * Reads the site at *offset in table, in a block ending at end, into site and
+ * moves *offset to the next site. Returns 1 on success, 0 otherwise.
+ */
+static int sitemap_site(const struct sitemap_table *const table,
+                        size_t *const offset, const size_t end,
+                        struct sitemap_site *const site)
+{
+        if (*offset + 2 * sizeof(uint32_t) >= end)
+                return 0;
+
+        site->code = (int) sitemap_u32(table, *offset);
+        site->line = (int) sitemap_u32(table, *offset + 4);
+        site->function = (const char *) table->data + *offset + 8;
+        site->file = site->function + strnlen(site->function,
+                                              end - *offset - 8) + 1;
+        *offset = site->file - (const char *) table->data;
+
+        if (*offset >= end)
+                return 0;
+
+        *offset = *offset + strnlen(site->file, end - *offset) + 1;
+
+        return 1;
+}
+
+/*
+ * Looks up id in table. Returns 1 and fills site if id is found, 0 otherwise.
+ */
+static int sitemap_find(const struct sitemap_table *const table,
+                        const unsigned int id, struct sitemap_site *const site)
+{
+        size_t offset, end;
+        uint32_t i;
+
+        for (offset = sitemap_block(table, 0); offset < table->size;
+             offset = sitemap_next(table, offset)) {
+                if (sitemap_u32(table, offset + 4) != MPICOLL_SITES_TAG(id)
+                    || MPICOLL_SITES_INDEX(id) >= sitemap_u32(table,
+                                                              offset + 8))
+                        continue;
+
+                end = offset + sitemap_u32(table, offset + 12);
+                offset = offset + 4 * sizeof(uint32_t);
+
+                for (i = 0; i <= MPICOLL_SITES_INDEX(id); ++i) {
+                        if (!sitemap_site(table, &offset, end, site))
+                                return 0;
+                }
+
+                return 1;
+        }
+
+        return 0;
+}
+
+/*
+ * Returns the file of the first site of the block at offset in table, which
+ * names its translation unit in messages.
+ */
+static const char *sitemap_unit(const struct sitemap_table *const table,
+                                const size_t offset)
+{
+        struct sitemap_site site;
+        size_t first = offset + 4 * sizeof(uint32_t);
+
+        if (!sitemap_site(table, &first, offset + sitemap_u32(table,
+                                                             offset + 12),
+                          &site))
+                return "?";
+
+        return site.file;
+}
+
+/*
+ * Returns the table of the ELF file at path, loading it if needed, or NULL if
+ * out of memory.
+ */
+static struct sitemap_table *sitemap_table(const char *const path)
+{
+        struct sitemap_table *table;
+
+        for (table = sitemap_tables; table != NULL; table = table->next) {
+                if (strcmp(table->path, path) == 0)
+                        return table;
+        }
+
+        table = malloc(sizeof(struct sitemap_table));
+
+        if (table == NULL)
+                return NULL;
+
+        table->path = strdup(path);
+
+        if (table->path == NULL) {
+                free(table);
+                return NULL;
+        }
+
+        sitemap_load(path, table);
+        table->next = sitemap_tables;
+        sitemap_tables = table;
+
+        return table;
+}
+
+/*
+ * Checks that the block at offset in table shares its tag with no later block
+ * of the loaded tables. Returns 1 if so, prints both translation units and
+ * returns 0 otherwise.
+ */
+static int sitemap_unique(const struct sitemap_table *const table,
+                          const size_t offset)
+{
+        const uint32_t tag = sitemap_u32(table, offset + 4);
+        const struct sitemap_table *other = table;
+        size_t i = sitemap_next(table, offset);
+
+        while (other != NULL) {
+                for (; i < other->size; i = sitemap_next(other, i)) {
+                        if (sitemap_u32(other, i + 4) != tag)
+                                continue;
+
+                        fprintf(stderr, "mpicoll: translation units of %s and "
+                                "%s share site tag %#x, rename one of them\n",
+                                sitemap_unit(table, offset),
+                                sitemap_unit(other, i), tag);
+
+                        return 0;
+                }
+
+                other = other->next;
+
+                if (other != NULL)
+                        i = sitemap_block(other, 0);
+        }
+
+        return 1;
+}
+
+/*
+ * Checks that no two translation units of the loaded tables share a tag.
+ * Returns 1 if so, prints the first two that do and returns 0 otherwise.
+ */
+static int sitemap_check_tables(void)
+{
+        const struct sitemap_table *table;
+        size_t offset;
+
+        for (table = sitemap_tables; table != NULL; table = table->next) {
+                for (offset = sitemap_block(table, 0); offset < table->size;
+                     offset = sitemap_next(table, offset)) {
+                        if (!sitemap_unique(table, offset))
+                                return 0;
+                }
+        }
+
+        return 1;
+}
+
+/*
+ * Looks up id in the .mpicoll_sites section of the ELF file at path. Returns 1
+ * and fills site if id is found, 0 otherwise.
+ */
+int sitemap_lookup_file(const char *const path, const unsigned int id,
+                        struct sitemap_site *const site)
+{
+        struct sitemap_table *table = sitemap_table(path);
+
+        return table != NULL && sitemap_find(table, id, site);
+}
+
+/*
+ * Checks that no two translation units of the ELF file at path share a site
+ * tag. Returns 1 if so, prints the first two that do and returns 0 otherwise.
+ */
+int sitemap_check_file(const char *const path)
+{
+        sitemap_table(path);
+
+        return sitemap_check_tables();
+}
+
+/*
+ * Arguments of sitemap_lookup_object().
+ */
+struct sitemap_lookup_args {
+        unsigned int id;
+        struct sitemap_site *site;
+};
+
+/*
+ * Looks up an ID in the loaded object described by info. Returns 1 if the ID
+ * is found, 0 otherwise.
+ */
+static int sitemap_lookup_object(struct dl_phdr_info *const info,
+                                 const size_t size __attribute__((unused)),
+                                 void *const data)
+{
+        struct sitemap_lookup_args *args = data;
+        const char *path = info->dlpi_name;
+
+        if (path == NULL || path[0] == '\0')
+                path = "/proc/self/exe";
+
+        return sitemap_lookup_file(path, args->id, args->site);
+}
+
+/*
+ * Looks up id in the .mpicoll_sites section of the program and of its loaded
+ * shared objects. Returns 1 and fills site if id is found, 0 otherwise.
+ */
+int sitemap_lookup(const unsigned int id, struct sitemap_site *const site)
+{
+        struct sitemap_lookup_args args = { id, site };
+
+        return dl_iterate_phdr(&sitemap_lookup_object, &args);
+}
+
+/*
+ * Loads the table of the loaded object described by info. Always returns 0 to
+ * go on with the next object.
+ */
+static int sitemap_load_object(struct dl_phdr_info *const info,
+                               const size_t size __attribute__((unused)),
+                               void *const data __attribute__((unused)))
+{
+        const char *path = info->dlpi_name;
+
+        if (path == NULL || path[0] == '\0')
+                path = "/proc/self/exe";
+
+        sitemap_table(path);
+
+        return 0;
+}
+
+/*
+ * Checks that no two translation units of the program and of its loaded shared
+ * objects share a site tag. Returns 1 if so, prints the first two that do and
+ * returns 0 otherwise. Objects are only read on the first call.
+ */
+int sitemap_check(void)
+{
+        static int res = -1;
+
+        if (res == -1) {
+                dl_iterate_phdr(&sitemap_load_object, NULL);
+                res = sitemap_check_tables();
+        }
+
+        return res;
+}
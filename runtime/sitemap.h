@@ -0,0 +1,61 @@
+/*
+ * Declarations and definitions of the runtime verification library dealing
+ * with site IDs mapping.
+ * Copyright (C) 2023-2025 Antoni Blanche
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef SITEMAP_H
+#define SITEMAP_H
+
+#include "mpicoll_sites.h"
+
+/*
+ * Source location of a site. Strings belong to the site map and must not be
+ * freed.
+ */
+struct sitemap_site {
+        int code;
+        int line;
+        const char *function;
+        const char *file;
+};
+
+/*
+ * Looks up id in the .mpicoll_sites section of the ELF file at path. Returns 1
+ * and fills site if id is found, 0 otherwise.
+ */
+int sitemap_lookup_file(const char *path, unsigned int id,
+                        struct sitemap_site *site);
+
+/*
+ * Looks up id in the .mpicoll_sites section of the program and of its loaded
+ * shared objects. Returns 1 and fills site if id is found, 0 otherwise.
+ */
+int sitemap_lookup(unsigned int id, struct sitemap_site *site);
+
+/*
+ * Checks that no two translation units of the ELF file at path share a site
+ * tag. Returns 1 if so, prints the first two that do and returns 0 otherwise.
+ */
+int sitemap_check_file(const char *path);
+
+/*
+ * Checks that no two translation units of the program and of its loaded shared
+ * objects share a site tag. Returns 1 if so, prints the first two that do and
+ * returns 0 otherwise. Objects are only read on the first call.
+ */
+int sitemap_check(void);
+
+#endif /* sitemap.h */
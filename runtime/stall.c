@@ -0,0 +1,343 @@
+/*
+ * Functions of the runtime verification library dealing with the detection of
+ * stalled ranks.
+ * Copyright (C) 2023-2025 Antoni Blanche
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#define _GNU_SOURCE
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <time.h>
+
+#include <dlfcn.h>
+#include <pthread.h>
+
+#include <mpi.h>
+
+#include "stall.h"
+#include "sitemap.h"
+
+/*
+ * Name of each MPI collective.
+ */
+#define DEF_MPI_COLLECTIVES(CODE, NAME) NAME,
+static const char *const MPI_COLLECTIVE_NAME[] = {
+#include "MPI_collectives.def"
+};
+#undef DEF_MPI_COLLECTIVES
+
+#define NB_CODES (int) (sizeof(MPI_COLLECTIVE_NAME) / sizeof(char *))
+
+/*
+ * Tag of the reports sent to rank 0.
+ */
+#define STALL_TAG 1
+
+/*
+ * Bounds of the polling period of the detector, in milliseconds.
+ */
+#define STALL_MIN_PERIOD 10
+#define STALL_MAX_PERIOD 1000
+
+/*
+ * A report of the state of a rank, sent to rank 0 whenever it changes. A rank
+ * is stalled once it has made no progress for longer than the timeout, which
+ * includes computing between two waits.
+ */
+struct stall_report {
+        int32_t stalled;        /* Nonzero if the rank is stalled */
+        int32_t state;          /* Last enum stall_state of the rank */
+        uint32_t site;          /* Site ID of its last wait */
+        int32_t value;          /* Value agreed on by its last wait */
+};
+
+#define STALL_REPORT_INTS 4
+
+struct stall_progress stall_progress;
+
+/*
+ * Communicator dedicated to reports, duplicated from MPI_COMM_WORLD when the
+ * detector starts, or MPI_COMM_NULL if the detector is not running.
+ */
+static MPI_Comm stall_comm = MPI_COMM_NULL;
+
+static pthread_t stall_thread;
+static int stall_stop = 0;
+static long stall_timeout;
+static int stall_rank, stall_size;
+
+/*
+ * Number of reports sent by the rank, and received by rank 0. Rank 0 keeps the
+ * last report of each rank.
+ */
+static long stall_sent = 0;
+static long stall_received = 0;
+static struct stall_report *stall_reports = NULL;
+
+/*
+ * Returns the current time in milliseconds.
+ */
+static long stall_now(void)
+{
+        struct timespec now;
+
+        clock_gettime(CLOCK_MONOTONIC, &now);
+
+        return now.tv_sec * 1000L + now.tv_nsec / 1000000L;
+}
+
+/*
+ * Returns the name of the site with code agreeing on value.
+ */
+static const char *stall_name(const int code, const int value)
+{
+        if (code == MPICOLL_SITES_LOOP || value < 0)
+                return "loop";
+
+        if (value >= 0x40000000)
+                return "sequence";
+
+        if (code < 0 || code >= NB_CODES)
+                return "unknown";
+
+        return MPI_COLLECTIVE_NAME[code];
+}
+
+/*
+ * Prints where rank is stalled according to report: either waiting at its last
+ * site, or somewhere after it.
+ */
+static void stall_print(const int rank, const struct stall_report *const report)
+{
+        const char *where = report->state == STALL_RUNNING ? "after " : "";
+        struct sitemap_site s;
+
+        if (report->state == STALL_FINALIZE)
+                fprintf(stderr, "mpicoll:   rank %d: MPI_Finalize\n", rank);
+        else if (sitemap_lookup(report->site, &s))
+                fprintf(stderr, "mpicoll:   rank %d: %s%s in %s() at %s:%d\n",
+                        rank, where, stall_name(s.code, report->value),
+                        s.function, s.file, s.line);
+        else
+                fprintf(stderr, "mpicoll:   rank %d: %ssite %#x\n", rank,
+                        where, report->site);
+}
+
+/*
+ * Prints where each rank is stalled and aborts. Called by rank 0 once all ranks
+ * are stalled, one of them at least in the library.
+ */
+static void stall_abort(void)
+{
+        int i;
+
+        fprintf(stderr, "mpicoll: MPI deadlock detected, no progress for "
+                "%.1f s\n", stall_timeout / 1000.0);
+
+        for (i = 0; i < stall_size; ++i)
+                stall_print(i, &(stall_reports[i]));
+
+        fflush(stderr);
+        MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+}
+
+/*
+ * Receives the pending reports on rank 0, then aborts if all ranks are stalled
+ * and at least one of them is waiting in the library.
+ */
+static void stall_collect(void)
+{
+        struct stall_report report;
+        MPI_Status status;
+        int flag, waiting = 0;
+        int i;
+
+        for (;;) {
+                MPI_Iprobe(MPI_ANY_SOURCE, STALL_TAG, stall_comm, &flag,
+                           &status);
+
+                if (!flag)
+                        break;
+
+                MPI_Recv(&report, STALL_REPORT_INTS, MPI_INT,
+                         status.MPI_SOURCE, STALL_TAG, stall_comm,
+                         MPI_STATUS_IGNORE);
+                stall_reports[status.MPI_SOURCE] = report;
+                stall_received = stall_received + 1;
+        }
+
+        for (i = 0; i < stall_size; ++i) {
+                if (!stall_reports[i].stalled)
+                        return;
+
+                if (stall_reports[i].state != STALL_RUNNING)
+                        waiting = 1;
+        }
+
+        /* Ranks all computing for longer than the timeout are not deadlocked */
+        if (waiting)
+                stall_abort();
+}
+
+/*
+ * Body of the detector thread. The progress of the rank is polled, and whether
+ * it is stalled is reported to rank 0 whenever it changes. Ranks blocked
+ * outside of the library, such as in a point-to-point call, are stalled too,
+ * but cannot be told from computing ranks.
+ */
+static void *stall_watch(void *const arg)
+{
+        struct stall_report report, last = { 0, STALL_RUNNING, 0U, 0 };
+        struct timespec period;
+        uint64_t count, seen = 0U;
+        long since = stall_now();
+        long ms;
+
+        (void) arg;
+
+        ms = stall_timeout / 4;
+        ms = ms < STALL_MIN_PERIOD ? STALL_MIN_PERIOD : ms;
+        ms = ms > STALL_MAX_PERIOD ? STALL_MAX_PERIOD : ms;
+        period.tv_sec = ms / 1000;
+        period.tv_nsec = (ms % 1000) * 1000000L;
+
+        while (!__atomic_load_n(&stall_stop, __ATOMIC_ACQUIRE)) {
+                nanosleep(&period, NULL);
+
+                count = __atomic_load_n(&stall_progress.count,
+                                        __ATOMIC_RELAXED);
+
+                if (count != seen) {
+                        seen = count;
+                        since = stall_now();
+                }
+
+                report.stalled = stall_now() - since >= stall_timeout;
+                report.state = __atomic_load_n(&stall_progress.state,
+                                               __ATOMIC_RELAXED);
+                report.site = __atomic_load_n(&stall_progress.site,
+                                              __ATOMIC_RELAXED);
+                report.value = __atomic_load_n(&stall_progress.value,
+                                               __ATOMIC_RELAXED);
+
+                if (report.stalled != last.stalled
+                    || (report.stalled && report.state != last.state)) {
+                        if (stall_rank == 0) {
+                                stall_reports[0] = report;
+                        } else {
+                                MPI_Send(&report, STALL_REPORT_INTS, MPI_INT,
+                                         0, STALL_TAG, stall_comm);
+                                stall_sent = stall_sent + 1;
+                        }
+
+                        last = report;
+                }
+
+                if (stall_rank == 0)
+                        stall_collect();
+        }
+
+        return NULL;
+}
+
+/*
+ * Starts the stall detector if the MPICOLL_STALL_TIMEOUT environment variable
+ * is a positive number of seconds. All ranks must call this function once,
+ * after MPI_Init.
+ */
+void stall_start(void)
+{
+        const char *env = getenv("MPICOLL_STALL_TIMEOUT");
+        int provided;
+
+        if (env == NULL || atof(env) <= 0.0)
+                return;
+
+        MPI_Comm_rank(MPI_COMM_WORLD, &stall_rank);
+        MPI_Query_thread(&provided);
+
+        /* The detector calls MPI while the main thread is blocked in it */
+        if (provided < MPI_THREAD_MULTIPLE) {
+                if (stall_rank == 0)
+                        fprintf(stderr, "mpicoll: the stall detector needs "
+                                "MPI_THREAD_MULTIPLE, disabled\n");
+                return;
+        }
+
+        stall_timeout = (long) (atof(env) * 1000.0);
+        MPI_Comm_dup(MPI_COMM_WORLD, &stall_comm);
+        MPI_Comm_size(stall_comm, &stall_size);
+
+        if (stall_rank == 0) {
+                stall_reports = calloc(stall_size, sizeof(*stall_reports));
+
+                if (stall_reports == NULL)
+                        MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+        }
+
+        if (pthread_create(&stall_thread, NULL, &stall_watch, NULL) != 0) {
+                fprintf(stderr, "mpicoll: cannot start the stall detector\n");
+                MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+        }
+}
+
+/*
+ * Returns the next definition of MPI_Finalize, such as the one of the PMPI
+ * interposition library, or PMPI_Finalize if there is none.
+ */
+static int stall_finalize(void)
+{
+        int (*next)(void) = (int (*)(void)) dlsym(RTLD_NEXT, "MPI_Finalize");
+
+        return next != NULL ? next() : PMPI_Finalize();
+}
+
+/*
+ * Stops the stall detector before finalizing MPI. Ranks wait for each other
+ * under the watch of the detector, so that a rank left behind in a MPI
+ * collective is reported.
+ */
+int MPI_Finalize(void)
+{
+        struct stall_report report;
+        MPI_Request request;
+        long total = 0;
+
+        if (stall_comm == MPI_COMM_NULL)
+                return stall_finalize();
+
+        stall_enter(STALL_FINALIZE, 0U, 0);
+        MPI_Ibarrier(stall_comm, &request);
+        MPI_Wait(&request, MPI_STATUS_IGNORE);
+        stall_leave();
+
+        __atomic_store_n(&stall_stop, 1, __ATOMIC_RELEASE);
+        pthread_join(stall_thread, NULL);
+
+        /* Reports still in flight are received before freeing stall_comm */
+        MPI_Reduce(&stall_sent, &total, 1, MPI_LONG, MPI_SUM, 0, stall_comm);
+
+        for (; stall_rank == 0 && stall_received < total; ++stall_received)
+                MPI_Recv(&report, STALL_REPORT_INTS, MPI_INT,
+                         MPI_ANY_SOURCE, STALL_TAG, stall_comm,
+                         MPI_STATUS_IGNORE);
+
+        MPI_Comm_free(&stall_comm);
+        free(stall_reports);
+
+        return stall_finalize();
+}
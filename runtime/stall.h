@@ -0,0 +1,77 @@
+/*
+ * Declarations and definitions of the stall detector of the runtime
+ * verification library.
+ * Copyright (C) 2023-2025 Antoni Blanche
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef STALL_H
+#define STALL_H
+
+#include <stdint.h>
+
+/*
+ * What a rank is doing, as seen by the stall detector.
+ */
+enum stall_state {
+        STALL_RUNNING,          /* Not waiting in the library */
+        STALL_AGREEMENT,        /* Waiting for an agreement */
+        STALL_FINALIZE          /* Waiting for the other ranks in MPI_Finalize */
+};
+
+/*
+ * Progress of the rank, written by the main thread only and read by the stall
+ * detector thread. Fields are accessed with relaxed atomics, which are plain
+ * loads and stores: the fast path never synchronizes with the detector.
+ */
+struct stall_progress {
+        uint64_t count;         /* Number of waits started */
+        uint32_t site;          /* Site ID of the last wait */
+        int32_t value;          /* Value agreed on by the last wait */
+        int32_t state;          /* Current enum stall_state */
+};
+
+extern struct stall_progress stall_progress;
+
+/*
+ * Starts the stall detector if the MPICOLL_STALL_TIMEOUT environment variable
+ * is a positive number of seconds. All ranks must call this function once,
+ * after MPI_Init.
+ */
+void stall_start(void);
+
+/*
+ * Marks the rank as waiting in state for the agreement on value for the site
+ * with ID site.
+ */
+static inline void stall_enter(const enum stall_state state,
+                               const unsigned int site, const int value)
+{
+        __atomic_store_n(&stall_progress.site, site, __ATOMIC_RELAXED);
+        __atomic_store_n(&stall_progress.value, value, __ATOMIC_RELAXED);
+        __atomic_store_n(&stall_progress.count, stall_progress.count + 1,
+                         __ATOMIC_RELAXED);
+        __atomic_store_n(&stall_progress.state, state, __ATOMIC_RELAXED);
+}
+
+/*
+ * Marks the rank as done waiting.
+ */
+static inline void stall_leave(void)
+{
+        __atomic_store_n(&stall_progress.state, STALL_RUNNING,
+                         __ATOMIC_RELAXED);
+}
+
+#endif /* stall.h */
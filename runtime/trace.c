@@ -0,0 +1,283 @@
+/*
+ * Functions of the runtime verification library dealing with MPI collective
+ * traces.
+ * Copyright (C) 2023-2025 Antoni Blanche
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <time.h>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+#include <mpi.h>
+
+#include "mpicoll_rt.h"
+#include "mpicoll_trace.h"
+#include "sitemap.h"
+#include "counters.h"
+
+/*
+ * A traced communicator, stored in an attribute of the communicator and freed
+ * along with it.
+ */
+struct trace_comm {
+        uint64_t key;
+        uint32_t count;         /* Next call number */
+};
+
+/*
+ * Trace state: 0 before the first trace, 1 when tracing and -1 if tracing is
+ * disabled.
+ */
+static int trace_state = 0;
+
+static struct mpicoll_trace_header *trace_header = NULL;
+static struct mpicoll_trace_record *trace_records = NULL;
+static uint64_t trace_mask;
+
+/*
+ * Attribute key of traced communicators, and the greatest communicator number
+ * agreed on by the rank.
+ */
+static int trace_keyval = MPI_KEYVAL_INVALID;
+static uint32_t trace_number = 0;
+
+/*
+ * Returns the number of records of the ring buffer, read from the
+ * MPICOLL_TRACE_SIZE environment variable and rounded up to a power of 2.
+ */
+static uint64_t trace_capacity(void)
+{
+        const char *env = getenv("MPICOLL_TRACE_SIZE");
+        uint64_t size = MPICOLL_TRACE_DEFAULT_SIZE;
+        uint64_t res = 1;
+
+        if (env != NULL && strtoull(env, NULL, 10) > 0)
+                size = strtoull(env, NULL, 10);
+
+        while (res < size)
+                res = res << 1;
+
+        return res;
+}
+
+/*
+ * Creates and maps the trace file of the rank. Returns 1 on success, 0
+ * otherwise.
+ */
+static int trace_open(void)
+{
+        const char *dir = getenv("MPICOLL_TRACE_DIR");
+        char path[4096];
+        uint64_t capacity = trace_capacity();
+        size_t length;
+        void *map;
+        int rank, size;
+        int fd;
+
+        MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+        MPI_Comm_size(MPI_COMM_WORLD, &size);
+
+        snprintf(path, sizeof(path), "%s/%s.%d", dir != NULL ? dir : ".",
+                 MPICOLL_TRACE_FILE, rank);
+
+        length = sizeof(struct mpicoll_trace_header)
+                 + capacity * sizeof(struct mpicoll_trace_record);
+
+        fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+
+        if (fd == -1) {
+                perror("mpicoll: cannot create trace file");
+                return 0;
+        }
+
+        if (ftruncate(fd, length) == -1) {
+                perror("mpicoll: cannot create trace file");
+                close(fd);
+                return 0;
+        }
+
+        map = mmap(NULL, length, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        close(fd);
+
+        if (map == MAP_FAILED) {
+                perror("mpicoll: cannot map trace file");
+                return 0;
+        }
+
+        trace_header = map;
+        trace_records = (struct mpicoll_trace_record *) (trace_header + 1);
+        trace_mask = capacity - 1;
+
+        trace_header->rank = rank;
+        trace_header->size = size;
+        trace_header->capacity = capacity;
+        __atomic_store_n(&trace_header->magic, MPICOLL_TRACE_MAGIC,
+                         __ATOMIC_RELEASE);
+
+        return 1;
+}
+
+/*
+ * Frees the traced communicator attr when its communicator is freed.
+ */
+static int trace_delete(MPI_Comm comm __attribute__((unused)),
+                        int keyval __attribute__((unused)), void *const attr,
+                        void *extra __attribute__((unused)))
+{
+        free(attr);
+
+        return MPI_SUCCESS;
+}
+
+/*
+ * Returns 1 if MPI collectives can be traced, 0 otherwise. The trace file is
+ * created on first call after MPI_Init. The program is aborted on first call if
+ * two of its translation units share a site tag.
+ */
+static int trace_ready(void)
+{
+        int flag;
+
+        if (__builtin_expect(trace_state != 0, 1))
+                return trace_state > 0;
+
+        MPI_Initialized(&flag);
+
+        if (!flag)
+                return 0;
+
+        /* Sites sharing an ID would be merged in traces */
+        if (!sitemap_check())
+                MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+
+        trace_state = trace_open() ? 1 : -1;
+
+        if (trace_state > 0
+            && MPI_Comm_create_keyval(MPI_COMM_NULL_COPY_FN, &trace_delete,
+                                      &trace_keyval, NULL) != MPI_SUCCESS)
+                trace_state = -1;
+
+        return trace_state > 0;
+}
+
+/*
+ * Returns the key of comm. All ranks of comm must call this function.
+ *
+ * Ranks agree on the smallest number greater than all numbers they agreed on
+ * so far. The rank 0 of comm takes part in all agreements of the communicators
+ * it leads, so that no two of them get the same number.
+ */
+static uint64_t trace_key(const MPI_Comm comm)
+{
+        MPI_Group group, world;
+        uint32_t number = trace_number + 1U;
+        int inter, leader = 0, res;
+
+        MPI_Comm_group(comm, &group);
+        MPI_Comm_group(MPI_COMM_WORLD, &world);
+        MPI_Group_translate_ranks(group, 1, &leader, world, &res);
+        MPI_Group_free(&world);
+        MPI_Group_free(&group);
+
+        if (res == MPI_UNDEFINED)
+                res = -1;
+
+        MPI_Comm_test_inter(comm, &inter);
+
+        /* Only the local group of an intercommunicator is known */
+        if (inter)
+                return (uint32_t) res;
+
+        MPI_Allreduce(MPI_IN_PLACE, &number, 1, MPI_UINT32_T, MPI_MAX, comm);
+        trace_number = number;
+
+        return ((uint64_t) number << 32) | (uint32_t) res;
+}
+
+/*
+ * Returns the traced communicator of handle, agreeing on its key on first
+ * call, or NULL if out of memory. A communicator handle of 0 stands for
+ * MPI_COMM_WORLD.
+ */
+static struct trace_comm *trace_comm(const uint64_t handle)
+{
+        MPI_Comm comm = MPI_COMM_WORLD;
+        struct trace_comm *res;
+        int flag;
+
+        if (handle != 0)
+                comm = (MPI_Comm) (uintptr_t) handle;
+
+        MPI_Comm_get_attr(comm, trace_keyval, &res, &flag);
+
+        if (flag)
+                return res;
+
+        res = malloc(sizeof(struct trace_comm));
+
+        if (res == NULL)
+                return NULL;
+
+        res->key = trace_key(comm);
+        res->count = 0;
+        MPI_Comm_set_attr(comm, trace_keyval, res);
+
+        return res;
+}
+
+/*
+ * Records the call of the MPI collective with code and ID site on comm.
+ */
+void __mpicoll_trace(const unsigned int site, const int code,
+                     const unsigned long long comm)
+{
+        struct mpicoll_trace_record *record;
+        struct mpicoll_counters_slot *counters;
+        struct trace_comm *c;
+        struct timespec now;
+        uint64_t n, start;
+
+        if (!trace_ready())
+                return;
+
+        counters = counters_lookup(site);
+        start = counters_start(counters);
+        c = trace_comm(comm);
+
+        if (c == NULL) {
+                counters_stop(counters, start, 0U, 0U);
+                return;
+        }
+
+        clock_gettime(CLOCK_REALTIME, &now);
+
+        n = __atomic_fetch_add(&trace_header->head, 1, __ATOMIC_RELAXED);
+        record = &(trace_records[n & trace_mask]);
+
+        __atomic_store_n(&record->seq, 0, __ATOMIC_RELAXED);
+        record->time = (uint64_t) now.tv_sec * 1000000000U + now.tv_nsec;
+        record->comm = c->key;
+        record->count = __atomic_fetch_add(&c->count, 1, __ATOMIC_RELAXED);
+        record->site = site;
+        record->code = code;
+        __atomic_store_n(&record->seq, n + 1, __ATOMIC_RELEASE);
+
+        counters_stop(counters, start, 1U, 0U);
+}
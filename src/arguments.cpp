@@ -0,0 +1,193 @@
+/*
+ * Functions dealing with plugin arguments.
+ * Copyright (C) 2023-2025 Antoni Blanche
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include <gcc-plugin.h>
+#include <diagnostic-core.h>
+
+#include <string.h>
+#include <limits.h>
+
+#include "arguments.h"
+
+/*
+ * Largest number of ranks simulated. Simulating n ranks runs each function on
+ * every communicator size up to n, so the work grows with n squared.
+ */
+#define ARGUMENTS_MAX_SIMULATE 1024
+
+/*
+ * Plugin arguments for the current compilation.
+ */
+struct mpicoll_arguments mpicoll_arguments = {
+        false,
+        false,
+        false,
+        false,
+        NULL,
+        NULL,
+        NULL,
+        "cfg",
+        DUMP_COLLAPSED,
+        50000,
+        100000,
+        5000,
+        10000,
+        10,
+        100,
+        0,
+};
+
+/*
+ * Sets a boolean flag from arg. A flag does not take any value.
+ */
+static bool arguments_set_flag(const struct plugin_argument *const arg,
+                               bool *const flag)
+{
+        if (arg->value != NULL) {
+                error("plugin argument %qs does not take a value", arg->key);
+                return false;
+        }
+
+        *flag = true;
+
+        return true;
+}
+
+/*
+ * Sets a string from arg. A string takes a non-empty value.
+ */
+static bool arguments_set_string(const struct plugin_argument *const arg,
+                                 const char **const string)
+{
+        if (arg->value == NULL || arg->value[0] == '\0') {
+                error("plugin argument %qs requires a value", arg->key);
+                return false;
+        }
+
+        *string = arg->value;
+
+        return true;
+}
+
+/*
+ * Sets a non-negative integer from arg.
+ */
+static bool arguments_set_int(const struct plugin_argument *const arg,
+                              int *const value)
+{
+        char *end;
+        long res;
+
+        if (arg->value == NULL || arg->value[0] == '\0') {
+                error("plugin argument %qs requires a value", arg->key);
+                return false;
+        }
+
+        res = strtol(arg->value, &end, 10);
+
+        if (*end != '\0' || res < 0L || res > INT_MAX) {
+                error("plugin argument %qs requires a non-negative integer, "
+                      "not %qs", arg->key, arg->value);
+                return false;
+        }
+
+        *value = (int) res;
+
+        return true;
+}
+
+/*
+ * Sets a dump mode from arg, one of full, collapsed and flagged.
+ */
+static bool arguments_set_dump_mode(const struct plugin_argument *const arg,
+                                    enum dump_mode *const mode)
+{
+        if (arg->value != NULL && strcmp(arg->value, "full") == 0)
+                *mode = DUMP_FULL;
+        else if (arg->value != NULL && strcmp(arg->value, "collapsed") == 0)
+                *mode = DUMP_COLLAPSED;
+        else if (arg->value != NULL && strcmp(arg->value, "flagged") == 0)
+                *mode = DUMP_FLAGGED;
+        else {
+                error("plugin argument %qs requires %qs, %qs or %qs",
+                      arg->key, "full", "collapsed", "flagged");
+                return false;
+        }
+
+        return true;
+}
+
+/*
+ * Parses plugin arguments in plugin_info. Returns false if at least one
+ * argument is unknown or malformed, true otherwise.
+ */
+bool arguments_parse(const struct plugin_name_args *const plugin_info)
+{
+        struct mpicoll_arguments *const args = &mpicoll_arguments;
+        const struct plugin_argument *arg;
+        bool res = true;
+        int i;
+
+        for (i = 0; i < plugin_info->argc; ++i) {
+                arg = &(plugin_info->argv[i]);
+
+                if (strcmp(arg->key, "instrument") == 0)
+                        res &= arguments_set_flag(arg, &args->instrument);
+                else if (strcmp(arg->key, "trace") == 0)
+                        res &= arguments_set_flag(arg, &args->trace);
+                else if (strcmp(arg->key, "counters") == 0)
+                        res &= arguments_set_flag(arg, &args->counters);
+                else if (strcmp(arg->key, "thread-level") == 0)
+                        res &= arguments_set_flag(arg, &args->thread_level);
+                else if (strcmp(arg->key, "stats") == 0)
+                        res &= arguments_set_string(arg, &args->stats);
+                else if (strcmp(arg->key, "report") == 0)
+                        res &= arguments_set_string(arg, &args->report);
+                else if (strcmp(arg->key, "dump") == 0)
+                        res &= arguments_set_string(arg, &args->dump);
+                else if (strcmp(arg->key, "after") == 0)
+                        res &= arguments_set_string(arg, &args->after);
+                else if (strcmp(arg->key, "dump-mode") == 0)
+                        res &= arguments_set_dump_mode(arg, &args->dump_mode);
+                else if (strcmp(arg->key, "max-blocks") == 0)
+                        res &= arguments_set_int(arg, &args->max_blocks);
+                else if (strcmp(arg->key, "max-edges") == 0)
+                        res &= arguments_set_int(arg, &args->max_edges);
+                else if (strcmp(arg->key, "max-collectives") == 0)
+                        res &= arguments_set_int(arg, &args->max_collectives);
+                else if (strcmp(arg->key, "max-time") == 0)
+                        res &= arguments_set_int(arg, &args->max_time);
+                else if (strcmp(arg->key, "max-warnings") == 0)
+                        res &= arguments_set_int(arg, &args->max_warnings);
+                else if (strcmp(arg->key, "max-unit-warnings") == 0)
+                        res &= arguments_set_int(arg, &args->max_unit_warnings);
+                else if (strcmp(arg->key, "simulate") == 0)
+                        res &= arguments_set_int(arg, &args->simulate);
+                else {
+                        error("unknown plugin argument %qs", arg->key);
+                        res = false;
+                }
+        }
+
+        if (args->simulate > ARGUMENTS_MAX_SIMULATE) {
+                error("plugin argument %qs is at most %d", "simulate",
+                      ARGUMENTS_MAX_SIMULATE);
+                res = false;
+        }
+
+        return res;
+}
@@ -0,0 +1,248 @@
+/*
+ * Functions dealing with the analysis complexity budgets.
+ * Copyright (C) 2023-2025 Antoni Blanche
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include <gcc-plugin.h>
+#include <tree.h>
+#include <gimple.h>
+#include <gimple-iterator.h>
+#include <diagnostic-core.h>
+
+#include "budget.h"
+#include "arguments.h"
+#include "mpicoll.h"
+#include "taint.h"
+#include "phase.h"
+
+/*
+ * Number of calls to budget_time_exceeded_p() between two clock readings.
+ */
+#define BUDGET_CLOCK_PERIOD 1024U
+
+/*
+ * Start time of the analysis of the current function, in microseconds, and
+ * whether its time budget is exceeded.
+ */
+static long budget_start_time = 0L;
+static bool budget_time_exceeded = false;
+static unsigned int budget_calls = 0U;
+
+/*
+ * Starts the time budget of the analysis of a new function.
+ */
+void budget_start(void)
+{
+        budget_start_time = get_run_time();
+        budget_time_exceeded = false;
+        budget_calls = 0U;
+}
+
+/*
+ * Returns true if value exceeds budget, false otherwise. A budget of 0 is
+ * unlimited.
+ */
+static bool budget_exceeds_p(const long value, const int budget)
+{
+        return budget > 0 && value > budget;
+}
+
+/*
+ * Returns the number of MPI collectives in fun.
+ */
+static long budget_nb_collectives(const function *const fun)
+{
+        basic_block bb;
+        long res = 0L;
+
+        FOR_EACH_BB_FN(bb, fun) {
+                if (bb->aux != (void *) LAST_AND_UNUSED_MPI_COLLECTIVE_CODE)
+                        res = res + 1;
+        }
+
+        return res;
+}
+
+/*
+ * Returns true if fun has more blocks, edges or MPI collectives than allowed
+ * by the plugin arguments, false otherwise. MPI collective codes must be set
+ * in basic blocks’s aux field before calling this function.
+ */
+bool budget_size_exceeded_p(const function *const fun)
+{
+        return budget_exceeds_p(n_basic_blocks_for_fn(fun),
+                                mpicoll_arguments.max_blocks)
+               || budget_exceeds_p(n_edges_for_fn(fun),
+                                   mpicoll_arguments.max_edges)
+               || budget_exceeds_p(budget_nb_collectives(fun),
+                                   mpicoll_arguments.max_collectives);
+}
+
+/*
+ * Returns true if the analysis of the current function has run longer than
+ * allowed by the plugin arguments, false otherwise. Once exceeded, the time
+ * budget stays exceeded until the next call to budget_start().
+ */
+bool budget_time_exceeded_p(void)
+{
+        if (budget_time_exceeded || mpicoll_arguments.max_time <= 0)
+                return budget_time_exceeded;
+
+        budget_calls = budget_calls + 1U;
+
+        if (budget_calls % BUDGET_CLOCK_PERIOD != 0U)
+                return false;
+
+        budget_time_exceeded = get_run_time() - budget_start_time
+                               > 1000L * mpicoll_arguments.max_time;
+
+        return budget_time_exceeded;
+}
+
+/*
+ * Marks in reach the blocks from which a MPI collective is reachable in fun.
+ */
+static void budget_reach_collectives(const function *const fun,
+                                     const bitmap reach)
+{
+        auto_vec<basic_block> queue;
+        basic_block bb;
+        edge e;
+        edge_iterator ei;
+
+        FOR_EACH_BB_FN(bb, fun) {
+                if (bb->aux != (void *) LAST_AND_UNUSED_MPI_COLLECTIVE_CODE
+                    && bitmap_set_bit(reach, bb->index))
+                        queue.safe_push(bb);
+        }
+
+        while (!queue.is_empty()) {
+                bb = queue.pop();
+
+                FOR_EACH_EDGE(e, ei, bb->preds) {
+                        if (bitmap_set_bit(reach, e->src->index))
+                                queue.safe_push(e->src);
+                }
+        }
+}
+
+/*
+ * Marks in forks the blocks of fun ending with a rank-tainted branch from which
+ * a MPI collective is reachable. Returns the number of forks.
+ */
+static int budget_forks(function *const fun, const bitmap forks)
+{
+        struct taint *taint = taint_compute(fun);
+        bitmap_head reach;
+        basic_block bb;
+        gimple *stmt;
+        int res = 0;
+
+        bitmap_initialize(&reach, &phase_obstack);
+        budget_reach_collectives(fun, &reach);
+
+        FOR_EACH_BB_FN(bb, fun) {
+                stmt = gsi_stmt(gsi_last_bb(bb));
+
+                if (EDGE_COUNT(bb->succs) >= 2 && stmt != NULL
+                    && bitmap_bit_p(&reach, bb->index)
+                    && taint_control_p(taint, stmt)) {
+                        bitmap_set_bit(forks, bb->index);
+                        res = res + 1;
+                }
+        }
+
+        bitmap_clear(&reach);
+        taint_free(taint);
+
+        return res;
+}
+
+/*
+ * Marks in group the MPI collectives of fun reachable from forks.
+ */
+static void budget_group(const function *const fun, const bitmap forks,
+                         const bitmap group)
+{
+        auto_vec<basic_block> queue;
+        bitmap_head visited;
+        bitmap_iterator bi;
+        basic_block bb;
+        unsigned int bb_index;
+        edge e;
+        edge_iterator ei;
+
+        bitmap_initialize(&visited, &phase_obstack);
+
+        EXECUTE_IF_SET_IN_BITMAP(forks, 0, bb_index, bi) {
+                bitmap_set_bit(&visited, bb_index);
+                queue.safe_push(BASIC_BLOCK_FOR_FN(fun, bb_index));
+        }
+
+        while (!queue.is_empty()) {
+                bb = queue.pop();
+
+                if (bb->aux != (void *) LAST_AND_UNUSED_MPI_COLLECTIVE_CODE)
+                        bitmap_set_bit(group, bb->index);
+
+                FOR_EACH_EDGE(e, ei, bb->succs) {
+                        if (bitmap_set_bit(&visited, e->dest->index))
+                                queue.safe_push(e->dest);
+                }
+        }
+
+        bitmap_clear(&visited);
+}
+
+/*
+ * Computes a conservative approximation of the groups and their iterated
+ * post-dominance frontier in fun, used instead of the exact analysis when a
+ * budget is exceeded. Every block ending with a rank-tainted branch from which
+ * a MPI collective is reachable is a fork, and every MPI collective reachable
+ * from a fork is in the only group. A note explains why the approximation is
+ * used. MPI collective codes must be set in basic blocks’s aux field before
+ * calling this function.
+ */
+void budget_approximate(function *const fun, bitmap *const groups,
+                        bitmap *const pdf)
+{
+        basic_block bb;
+        int nb_forks;
+
+        *groups = XNEWVEC(bitmap_head, last_basic_block_for_fn(fun));
+        *pdf = XNEWVEC(bitmap_head, last_basic_block_for_fn(fun));
+
+        FOR_ALL_BB_FN(bb, fun) {
+                bitmap_initialize(&((*groups)[bb->index]), &phase_obstack);
+                bitmap_initialize(&((*pdf)[bb->index]), &phase_obstack);
+        }
+
+        inform(DECL_SOURCE_LOCATION(fun->decl), "%qs exceeds the MPI deadlock "
+               "analysis budget (%d blocks, %d edges, %ld MPI collectives%s), "
+               "every rank-dependent branch reaching a MPI collective is "
+               "considered a fork", function_name(fun),
+               n_basic_blocks_for_fn(fun), n_edges_for_fn(fun),
+               budget_nb_collectives(fun),
+               budget_time_exceeded ? ", time limit reached" : "");
+
+        nb_forks = budget_forks(fun, &((*pdf)[0]));
+
+        if (nb_forks > 0)
+                budget_group(fun, &((*pdf)[0]), &((*groups)[0]));
+
+        /* A group without MPI collective ends the list of groups */
+        if (bitmap_empty_p(&((*groups)[0])))
+                bitmap_clear(&((*pdf)[0]));
+}
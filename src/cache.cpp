@@ -0,0 +1,247 @@
+/*
+ * Functions dealing with the cache of analysis verdicts.
+ * Copyright (C) 2023-2025 Antoni Blanche
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include <gcc-plugin.h>
+#include <tree.h>
+#include <inchash.h>
+
+#include "cache.h"
+#include "frontier.h"
+#include "phase.h"
+
+/*
+ * Edge flags that are part of the body shape.
+ */
+#define CACHE_EDGE_FLAGS (EDGE_TRUE_VALUE | EDGE_FALSE_VALUE | EDGE_COMPLEX)
+
+/*
+ * Verdict of the exact analysis of a function. Basic blocks are stored by
+ * position in the reverse postorder, so that copies with other basic block
+ * indices share it. The verdict lists, for each group, the number of its basic
+ * blocks and their positions, then the same for its frontier. Entries do not
+ * keep trees, since cache_entries is not a garbage collector root.
+ */
+struct cache_entry {
+        unsigned int origin;    /* DECL_UID of the function DECL_ORIGIN */
+        hashval_t hash;         /* Hash of the body shape */
+        vec<int> shape;         /* Body shape */
+        vec<int> verdict;
+};
+
+/*
+ * Verdicts of the functions analysed in the translation unit.
+ */
+static auto_vec<struct cache_entry> cache_entries; /* Global variable, yuck */
+
+/*
+ * Body shape of the function being analysed, its hash, and the index of its
+ * basic blocks by position. The shape is empty if the function is not cached.
+ */
+static auto_vec<int> cache_shape;
+static hashval_t cache_hash;
+static auto_vec<int> cache_order;
+
+/*
+ * Computes the body shape of fun in cache_shape. Functions with basic blocks
+ * unreachable from their entry are not cached.
+ */
+static void cache_compute_shape(const function *const fun,
+                                const const_bitmap exits)
+{
+        inchash::hash hash;
+        basic_block bb;
+        edge e;
+        edge_iterator ei;
+        int *order, *position;
+        int n, i;
+
+        cache_shape.truncate(0);
+        cache_order.truncate(0);
+
+        order = XNEWVEC(int, n_basic_blocks_for_fn(fun));
+        position = XNEWVEC(int, last_basic_block_for_fn(fun));
+        n = frontier_reverse_postorder(fun, order);
+
+        if (n != n_basic_blocks_for_fn(fun)) {
+                free(position);
+                free(order);
+                return;
+        }
+
+        for (i = 0; i < n; ++i) {
+                position[order[i]] = i;
+                cache_order.safe_push(order[i]);
+        }
+
+        for (i = 0; i < n; ++i) {
+                bb = BASIC_BLOCK_FOR_FN(fun, order[i]);
+
+                cache_shape.safe_push((int) (long) bb->aux);
+                cache_shape.safe_push(bitmap_bit_p(exits, bb->index));
+                cache_shape.safe_push(EDGE_COUNT(bb->succs));
+
+                FOR_EACH_EDGE(e, ei, bb->succs) {
+                        cache_shape.safe_push(position[e->dest->index]);
+                        cache_shape.safe_push(e->flags & CACHE_EDGE_FLAGS);
+                }
+        }
+
+        for (i = 0; i < (int) cache_shape.length(); ++i)
+                hash.add_int(cache_shape[i]);
+
+        cache_hash = hash.end();
+
+        free(position);
+        free(order);
+}
+
+/*
+ * Returns true if entry is the verdict of a function with the same origin and
+ * body shape as fun, false otherwise.
+ */
+static bool cache_match_p(const function *const fun,
+                          const struct cache_entry *const entry)
+{
+        return entry->origin == DECL_UID(DECL_ORIGIN(fun->decl))
+               && entry->hash == cache_hash
+               && entry->shape.length() == cache_shape.length()
+               && memcmp(entry->shape.address(), cache_shape.address(),
+                         cache_shape.length() * sizeof(int)) == 0;
+}
+
+/*
+ * Appends to verdict the number of basic blocks in set and their positions.
+ */
+static void cache_push_set(vec<int> &verdict, const const_bitmap set,
+                           const int *const position)
+{
+        bitmap_iterator bi;
+        unsigned int bb_index;
+
+        verdict.safe_push(bitmap_count_bits(set));
+
+        EXECUTE_IF_SET_IN_BITMAP(set, 0, bb_index, bi)
+                verdict.safe_push(position[bb_index]);
+}
+
+/*
+ * Sets in set the basic blocks read from verdict at *i, and moves *i past
+ * them.
+ */
+static void cache_pop_set(const vec<int> &verdict, unsigned int *const i,
+                          const bitmap set)
+{
+        int n;
+
+        for (n = verdict[(*i)++]; n > 0; --n)
+                bitmap_set_bit(set, cache_order[verdict[(*i)++]]);
+}
+
+/*
+ * Looks up the verdict of the exact analysis of a copy of fun, such as an IPA
+ * clone, with the same DECL_ORIGIN and body shape. Returns true and sets groups
+ * and their iterated post-dominance frontiers pdf if found, false otherwise.
+ */
+bool cache_lookup(function *const fun, const const_bitmap exits,
+                  bitmap *const groups, bitmap *const pdf)
+{
+        struct cache_entry *entry;
+        basic_block bb;
+        unsigned int i, j;
+        int g;
+
+        cache_compute_shape(fun, exits);
+
+        if (cache_shape.is_empty())
+                return false;
+
+        FOR_EACH_VEC_ELT(cache_entries, i, entry) {
+                if (cache_match_p(fun, entry))
+                        break;
+        }
+
+        if (i == cache_entries.length())
+                return false;
+
+        *groups = XNEWVEC(bitmap_head, last_basic_block_for_fn(fun));
+        *pdf = XNEWVEC(bitmap_head, last_basic_block_for_fn(fun));
+
+        FOR_ALL_BB_FN(bb, fun) {
+                bitmap_initialize(&((*groups)[bb->index]), &phase_obstack);
+                bitmap_initialize(&((*pdf)[bb->index]), &phase_obstack);
+        }
+
+        for (j = 0U, g = 0; j < entry->verdict.length(); ++g) {
+                cache_pop_set(entry->verdict, &j, &((*groups)[g]));
+                cache_pop_set(entry->verdict, &j, &((*pdf)[g]));
+        }
+
+        return true;
+}
+
+/*
+ * Records groups and their iterated post-dominance frontiers pdf as the verdict
+ * of the exact analysis of fun, whose body shape was computed by the last call
+ * to cache_lookup().
+ */
+void cache_store(function *const fun, const bitmap groups, const bitmap pdf)
+{
+        struct cache_entry entry;
+        int *position;
+        unsigned int i;
+        int g;
+
+        if (cache_shape.is_empty())
+                return;
+
+        position = XNEWVEC(int, last_basic_block_for_fn(fun));
+
+        for (i = 0U; i < cache_order.length(); ++i)
+                position[cache_order[i]] = i;
+
+        entry.origin = DECL_UID(DECL_ORIGIN(fun->decl));
+        entry.hash = cache_hash;
+        entry.shape = cache_shape.copy();
+        entry.verdict = vNULL;
+
+        FOR_EACH_BITMAP(groups, 0, g) {
+                cache_push_set(entry.verdict, &(groups[g]), position);
+                cache_push_set(entry.verdict, &(pdf[g]), position);
+        }
+
+        cache_entries.safe_push(entry);
+        free(position);
+}
+
+/*
+ * Releases the cache at the end of a translation unit.
+ */
+void cache_finish_unit(void *const event_data ATTRIBUTE_UNUSED,
+                       void *const data ATTRIBUTE_UNUSED)
+{
+        struct cache_entry *entry;
+        unsigned int i;
+
+        FOR_EACH_VEC_ELT(cache_entries, i, entry) {
+                entry->shape.release();
+                entry->verdict.release();
+        }
+
+        cache_entries.release();
+        cache_shape.release();
+        cache_order.release();
+}
@@ -16,150 +16,501 @@
  * along with this program.  If not, see <https://www.gnu.org/licenses/>.
  */
 #include <gcc-plugin.h>
+#include <diagnostic-core.h>
 
 #include <stdio.h>
 
 #include "cfgviz.h"
 #include "mpicoll.h"
+#include "frontier.h"
+#include "arguments.h"
+#include "report.h"
+#include "phase.h"
 
 /*
- * Builds a filename (as a string) based on fun’s name and suffix.
+ * Size of the buffer of the dump file.
  */
-static char *cfgviz_generate_filename(function *const fun,
-                                      const char *const suffix)
+#define CFGVIZ_BUFFER_SIZE (1 << 16)
+
+/*
+ * Dump file of the translation unit, holding a graph per dump, or NULL if
+ * dumps are disabled.
+ */
+static FILE *cfgviz_file = NULL;
+static char *cfgviz_path = NULL;
+
+/*
+ * Opens the dump file of the translation unit in the directory given by the
+ * dump plugin argument.
+ */
+void cfgviz_start_unit(void *const event_data ATTRIBUTE_UNUSED,
+                       void *const data ATTRIBUTE_UNUSED)
+{
+        if (mpicoll_arguments.dump == NULL || main_input_filename == NULL)
+                return;
+
+        cfgviz_path = report_unit_path(mpicoll_arguments.dump, CFGVIZ_SUFFIX);
+        cfgviz_file = fopen(cfgviz_path, "w");
+
+        if (cfgviz_file == NULL) {
+                error("cannot open dump file %qs: %m", cfgviz_path);
+                return;
+        }
+
+        setvbuf(cfgviz_file, NULL, _IOFBF, CFGVIZ_BUFFER_SIZE);
+}
+
+/*
+ * Closes the dump file of the translation unit.
+ */
+void cfgviz_finish_unit(void *const event_data ATTRIBUTE_UNUSED,
+                        void *const data ATTRIBUTE_UNUSED)
 {
-        char *target_filename = XNEWVEC(char, 1024);
+        if (cfgviz_file != NULL && fclose(cfgviz_file) != 0)
+                error("cannot write dump file %qs: %m", cfgviz_path);
 
-        snprintf(target_filename, 1024, "%s_%s_%d_%s.dot", function_name(fun),
-                 basename(LOCATION_FILE(fun->function_start_locus)),
-                 LOCATION_LINE(fun->function_start_locus), suffix);
+        cfgviz_file = NULL;
+        free(cfgviz_path);
+        cfgviz_path = NULL;
+}
 
-        return target_filename;
+/*
+ * Returns true if dumps are written, false otherwise.
+ */
+bool cfgviz_enabled_p(void)
+{
+        return cfgviz_file != NULL;
 }
 
 /*
- * Dumps the graphviz CFG representation of bb’s edges.
+ * Prints string as a graphviz string.
  */
-static void cfgviz_edge_dump(const basic_block bb, FILE *const out)
+static void cfgviz_string(const char *const string, FILE *const out)
+{
+        const char *c;
+
+        fputc('"', out);
+
+        for (c = string != NULL ? string : ""; *c != '\0'; ++c) {
+                if (*c == '"' || *c == '\\')
+                        fputc('\\', out);
+
+                fputc(*c, out);
+        }
+
+        fputc('"', out);
+}
+
+/*
+ * Starts the graph of fun named after suffix.
+ */
+static void cfgviz_begin(function *const fun, const char *const suffix,
+                         FILE *const out)
+{
+        char *name = concat(function_name(fun), " ", suffix, NULL);
+
+        fprintf(out, "digraph ");
+        cfgviz_string(name, out);
+        fprintf(out, " {\n\tlabel=");
+        cfgviz_string(name, out);
+        fprintf(out, "\n\tnode [shape=ellipse]\n");
+
+        free(name);
+}
+
+/*
+ * Dumps the graphviz CFG representation of bb’s edges. If cfg is not NULL, the
+ * edges not in cfg are dashed.
+ */
+static void cfgviz_edge_dump(const basic_block bb, FILE *const out,
+                             const bitmap cfg)
 {
         edge e;
         edge_iterator ei;
-        const char *label = "";
+        const char *label;
 
         FOR_EACH_EDGE(e, ei, bb->succs) {
-                if (e->flags == EDGE_TRUE_VALUE)
+                label = "";
+
+                if (e->flags & EDGE_TRUE_VALUE)
                         label = "true";
-                else if (e->flags == EDGE_FALSE_VALUE)
+                else if (e->flags & EDGE_FALSE_VALUE)
                         label = "false";
 
-                fprintf(out, "\tN%d -> N%d [color=red label=\"%s\"]\n",
-                        e->src->index, e->dest->index, label);
+                fprintf(out, "\tN%d -> N%d [color=red label=\"%s\"%s]\n",
+                        e->src->index, e->dest->index, label,
+                        cfg == NULL || bitmap_bit_p(&(cfg[bb->index]),
+                                                    e->dest->index)
+                        ? "" : " style=dashed");
         }
 }
 
 /*
- * Dumps the graphviz CFG representation of fun in out stream.
+ * Dumps the graphviz CFG representation of bb.
  */
-static void cfgviz_internal_dump(const function *const fun, FILE *const out)
+static void cfgviz_block_dump(const basic_block bb, FILE *const out)
+{
+        if (bb->aux != (void *) LAST_AND_UNUSED_MPI_COLLECTIVE_CODE)
+                fprintf(out, "\tN%d [label=\"%s\"]\n", bb->index,
+                        MPI_COLLECTIVE_NAME[(unsigned long) (bb->aux)]);
+        else
+                fprintf(out, "\tN%d [label=\"%d\"]\n", bb->index, bb->index);
+}
+
+/*
+ * Dumps the graphviz CFG representation of fun in the dump file.
+ */
+void cfgviz_dump(function *const fun, const char *const suffix)
 {
         basic_block bb;
 
-        fprintf(out, "Digraph G{\n");
+        if (cfgviz_file == NULL)
+                return;
+
+        cfgviz_begin(fun, suffix, cfgviz_file);
 
         FOR_ALL_BB_FN(bb, fun) {
-                if (bb->aux != (void *) LAST_AND_UNUSED_MPI_COLLECTIVE_CODE)
-                        fprintf(out, "\tN%d [label=\"%s\" shape=ellipse]\n",
-                                bb->index,
-                                MPI_COLLECTIVE_NAME[(unsigned long) (bb->aux)]);
-                else
-                        fprintf(out, "\tN%d [label=\"%d\" shape=ellipse]\n",
-                                bb->index, bb->index);
+                cfgviz_block_dump(bb, cfgviz_file);
+                cfgviz_edge_dump(bb, cfgviz_file, NULL);
+        }
+
+        fprintf(cfgviz_file, "}\n");
+}
+
+/*
+ * Dumps the graphviz CFG representation of fun from cfg in the dump file. The
+ * edges not in cfg are dashed.
+ */
+void cfgviz_dump_cfg(function *const fun,
+                     const char *const suffix, const bitmap cfg)
+{
+        basic_block bb;
+
+        if (cfgviz_file == NULL)
+                return;
+
+        cfgviz_begin(fun, suffix, cfgviz_file);
 
-                cfgviz_edge_dump(bb, out);
+        FOR_ALL_BB_FN(bb, fun) {
+                cfgviz_block_dump(bb, cfgviz_file);
+                cfgviz_edge_dump(bb, cfgviz_file, cfg);
         }
 
-        fprintf(out, "}\n");
+        fprintf(cfgviz_file, "}\n");
 }
 
 /*
- * Dumps the graphviz CFG representation of fun in a file.
+ * Prints the indices of the bitmaps in map containing bb_index, preceded by
+ * name, as a line of a graphviz label. Bitmaps are looked up as long as the
+ * bitmap with the same index in bound is not empty. Prints nothing if there is
+ * none.
  */
-void cfgviz_dump(function *const fun, const char *const suffix)
+static void cfgviz_indices(const bitmap map, const bitmap bound,
+                           const unsigned int bb_index, const char *name,
+                           FILE *const out)
 {
-        char *target_filename;
-        FILE *out;
+        const char *sep = "\\n";
+        int i;
+
+        FOR_EACH_BITMAP(bound, 0, i) {
+                if (bitmap_bit_p(&(map[i]), bb_index)) {
+                        fprintf(out, "%s%s %d", sep, name, i);
+                        sep = ",";
+                        name = "";
+                }
+        }
+}
+
+/*
+ * Returns true if bb is never contracted in collapsed dumps, that is if it is
+ * the entry or the exit, a MPI collective or a fork.
+ */
+static bool cfgviz_kept_p(const function *const fun, const basic_block bb,
+                          const bitmap forks)
+{
+        return bb == ENTRY_BLOCK_PTR_FOR_FN(fun)
+               || bb == EXIT_BLOCK_PTR_FOR_FN(fun)
+               || bb->aux != (void *) LAST_AND_UNUSED_MPI_COLLECTIVE_CODE
+               || bitmap_bit_p(forks, bb->index);
+}
+
+/*
+ * Puts in shown the basic blocks of fun between the forks and the MPI
+ * collectives of the flagged groups: the forks, the flagged MPI collectives, and the basic
+ * blocks reachable from a fork from which a flagged MPI collective is
+ * reachable.
+ */
+static void cfgviz_flagged(function *const fun, const bitmap groups,
+                           const bitmap pdf, const bitmap forks, bitmap shown)
+{
+        auto_vec<basic_block> worklist;
+        bitmap_head from, to;
+        basic_block bb;
+        edge e;
+        edge_iterator ei;
+        bitmap_iterator bi;
+        unsigned int bb_index;
+        int i;
 
-        target_filename = cfgviz_generate_filename(fun, suffix);
-        out = fopen(target_filename, "w");
+        bitmap_initialize(&from, &phase_obstack);
+        bitmap_initialize(&to, &phase_obstack);
 
-        cfgviz_internal_dump(fun, out);
+        EXECUTE_IF_SET_IN_BITMAP(forks, 0, bb_index, bi) {
+                bitmap_set_bit(&from, bb_index);
+                worklist.safe_push(BASIC_BLOCK_FOR_FN(fun, bb_index));
+        }
+
+        while (!worklist.is_empty()) {
+                bb = worklist.pop();
+
+                FOR_EACH_EDGE(e, ei, bb->succs) {
+                        if (bitmap_set_bit(&from, e->dest->index))
+                                worklist.safe_push(e->dest);
+                }
+        }
+
+        FOR_EACH_BITMAP(groups, 0, i) {
+                if (bitmap_empty_p(&(pdf[i])))
+                        continue;
+
+                EXECUTE_IF_SET_IN_BITMAP(&(groups[i]), 0, bb_index, bi) {
+                        bitmap_set_bit(shown, bb_index);
+
+                        if (bitmap_set_bit(&to, bb_index))
+                                worklist.safe_push(BASIC_BLOCK_FOR_FN(fun,
+                                                                      bb_index));
+                }
+        }
 
-        fclose(out);
-        free(target_filename);
+        while (!worklist.is_empty()) {
+                bb = worklist.pop();
+
+                FOR_EACH_EDGE(e, ei, bb->preds) {
+                        if (bitmap_set_bit(&to, e->src->index))
+                                worklist.safe_push(e->src);
+                }
+        }
+
+        bitmap_ior_and_into(shown, &from, &to);
+        bitmap_ior_into(shown, forks);
+
+        bitmap_clear(&from);
+        bitmap_clear(&to);
 }
 
 /*
- * Dumps the graphviz CFG representation of bb’s edges.
+ * Returns the only predecessor of bb in shown, or NULL if bb has none or
+ * several. All basic blocks are in shown if it is NULL.
  */
-static void cfgviz_edge_dump_bis(const basic_block bb,
-                                 FILE *const out, const bitmap cfg)
+static basic_block cfgviz_single_pred(const basic_block bb, const bitmap shown)
 {
+        basic_block res = NULL;
         edge e;
         edge_iterator ei;
-        const char *label = "";
 
-        FOR_EACH_EDGE(e, ei, bb->succs) {
-                if (bitmap_bit_p(&(cfg[bb->index]), e->dest->index)) {
-                        if (e->flags == EDGE_TRUE_VALUE)
-                                label = "true";
-                        else if (e->flags == EDGE_FALSE_VALUE)
-                                label = "false";
+        FOR_EACH_EDGE(e, ei, bb->preds) {
+                if (shown != NULL && !bitmap_bit_p(shown, e->src->index))
+                        continue;
 
-                        fprintf(out, "\tN%d -> N%d [color=red label=\"%s\"]\n",
-                                e->src->index, e->dest->index, label);
+                if (res != NULL)
+                        return NULL;
+
+                res = e->src;
+        }
+
+        return res;
+}
+
+/*
+ * Puts in rep the node of each basic block of fun in shown, or -1 for basic
+ * blocks not in shown. All basic blocks are in shown if it is NULL. Basic
+ * blocks without MPI collective nor fork whose only predecessor is such a basic
+ * block are contracted into the node of their predecessor, so that each node
+ * is a tree of basic blocks entered at its root, the index of the node.
+ */
+static void cfgviz_contract(function *const fun, const bitmap shown,
+                            const bitmap forks, int *const rep)
+{
+        auto_vec<basic_block> chain;
+        basic_block bb, b, pred;
+        int root;
+
+        FOR_ALL_BB_FN(bb, fun)
+                rep[bb->index] = -1;
+
+        FOR_ALL_BB_FN(bb, fun) {
+                if (shown != NULL && !bitmap_bit_p(shown, bb->index))
+                        continue;
+
+                /* -2 marks the chain walked up, to stop on cycles */
+                for (b = bb; rep[b->index] == -1; b = pred) {
+                        pred = cfgviz_single_pred(b, shown);
+
+                        if (cfgviz_kept_p(fun, b, forks) || pred == NULL
+                            || cfgviz_kept_p(fun, pred, forks)
+                            || rep[pred->index] == -2) {
+                                rep[b->index] = b->index;
+                                break;
+                        }
+
+                        rep[b->index] = -2;
+                        chain.safe_push(b);
                 }
+
+                root = rep[b->index];
+
+                while (!chain.is_empty())
+                        rep[chain.pop()->index] = root;
         }
 }
 
 /*
- * Dumps the graphviz CFG representation of fun from cfg in a file.
+ * Dumps the graphviz CFG representation of fun in the dump file, overlaid with
+ * the results of the analysis. MPI collectives are labelled with their ranks
+ * and groups, and filled in red if their group has a non-empty post-dominance
+ * frontier. Forks are diamonds labelled with the groups whose frontier they are
+ * in. Blocks of collapsed regions are grey, and edges not in cfg are dashed.
+ * Any of cfg, ranks, regions, groups and pdf can be NULL if it was not
+ * computed.
+ *
+ * Unless the dump mode is full, chains of basic blocks without MPI collective
+ * nor fork are contracted into boxes, and in flagged mode only the basic blocks
+ * between flagged groups and their forks are dumped.
  */
-static void cfgviz_internal_dump_bis(const function *const fun,
-                                     FILE *const out, const bitmap cfg)
+void cfgviz_dump_analysis(function *const fun, const bitmap cfg,
+                          const bitmap ranks, const int *const regions,
+                          const bitmap groups, const bitmap pdf)
 {
+        const enum dump_mode mode = mpicoll_arguments.dump_mode;
+        FILE *out = cfgviz_file;
+        bitmap_head forks, flagged, shown, *emitted;
         basic_block bb;
+        edge e;
+        edge_iterator ei;
+        const char *label;
+        int *rep, *size;
+        int i;
+
+        if (out == NULL)
+                return;
+
+        bitmap_initialize(&forks, &phase_obstack);
+        bitmap_initialize(&flagged, &phase_obstack);
+        bitmap_initialize(&shown, &phase_obstack);
 
-        fprintf(out, "Digraph G{\n");
+        if (groups != NULL && pdf != NULL) {
+                FOR_EACH_BITMAP(groups, 0, i) {
+                        if (bitmap_empty_p(&(pdf[i])))
+                                continue;
+
+                        bitmap_ior_into(&forks, &(pdf[i]));
+                        bitmap_ior_into(&flagged, &(groups[i]));
+                }
+        }
+
+        rep = XNEWVEC(int, last_basic_block_for_fn(fun));
+        size = XCNEWVEC(int, last_basic_block_for_fn(fun));
+        emitted = XNEWVEC(bitmap_head, last_basic_block_for_fn(fun));
+
+        if (mode == DUMP_FULL) {
+                FOR_ALL_BB_FN(bb, fun)
+                        rep[bb->index] = bb->index;
+        } else if (mode == DUMP_FLAGGED && groups != NULL && pdf != NULL) {
+                cfgviz_flagged(fun, groups, pdf, &forks, &shown);
+                cfgviz_contract(fun, &shown, &forks, rep);
+        } else {
+                cfgviz_contract(fun, NULL, &forks, rep);
+        }
 
         FOR_ALL_BB_FN(bb, fun) {
+                bitmap_initialize(&(emitted[bb->index]), &phase_obstack);
+
+                if (rep[bb->index] >= 0)
+                        size[rep[bb->index]] = size[rep[bb->index]] + 1;
+        }
+
+        cfgviz_begin(fun, "analysis", out);
+
+        FOR_ALL_BB_FN(bb, fun) {
+                if (rep[bb->index] != bb->index)
+                        continue;
+
+                fprintf(out, "\tN%d [label=\"%d", bb->index, bb->index);
+
+                if (size[bb->index] > 1)
+                        fprintf(out, "\\n%d blocks", size[bb->index]);
+
                 if (bb->aux != (void *) LAST_AND_UNUSED_MPI_COLLECTIVE_CODE)
-                        fprintf(out, "\tN%d [label=\"%s\" shape=ellipse]\n",
-                                bb->index,
+                        fprintf(out, "\\n%s",
                                 MPI_COLLECTIVE_NAME[(unsigned long) (bb->aux)]);
-                else
-                        fprintf(out, "\tN%d [label=\"%d\" shape=ellipse]\n",
-                                bb->index, bb->index);
 
-                cfgviz_edge_dump_bis(bb, out, cfg);
+                if (ranks != NULL)
+                        cfgviz_indices(ranks, ranks, bb->index, "rank",
+                                       out);
+
+                if (groups != NULL)
+                        cfgviz_indices(groups, groups, bb->index, "group",
+                                       out);
+
+                if (bitmap_bit_p(&forks, bb->index))
+                        cfgviz_indices(pdf, groups, bb->index, "fork of",
+                                       out);
+
+                fprintf(out, "\"");
+
+                if (size[bb->index] > 1)
+                        fprintf(out, " shape=box");
+
+                if (bitmap_bit_p(&flagged, bb->index))
+                        fprintf(out, " style=filled fillcolor=salmon");
+
+                if (bitmap_bit_p(&forks, bb->index))
+                        fprintf(out, " shape=diamond style=filled "
+                                "fillcolor=orange");
+
+                if (regions != NULL && regions[bb->index] != bb->index)
+                        fprintf(out, " color=grey fontcolor=grey");
+
+                fprintf(out, "]\n");
         }
 
-        fprintf(out, "}\n");
-}
+        FOR_ALL_BB_FN(bb, fun) {
+                if (rep[bb->index] < 0)
+                        continue;
 
-/*
- * Dumps the graphviz CFG representation of fun from cfg in a file.
- */
-void cfgviz_dump_cfg(function *const fun,
-                     const char *const suffix, const bitmap cfg)
-{
-        char *target_filename;
-        FILE *out;
+                FOR_EACH_EDGE(e, ei, bb->succs) {
+                        if (rep[e->dest->index] < 0
+                            || (mode != DUMP_FULL
+                                && rep[e->dest->index] == rep[bb->index])
+                            || !bitmap_set_bit(&(emitted[rep[bb->index]]),
+                                               rep[e->dest->index]))
+                                continue;
+
+                        label = "";
+
+                        if (e->flags & EDGE_TRUE_VALUE)
+                                label = "true";
+                        else if (e->flags & EDGE_FALSE_VALUE)
+                                label = "false";
 
-        target_filename = cfgviz_generate_filename(fun, suffix);
-        out = fopen(target_filename, "w");
+                        fprintf(out, "\tN%d -> N%d [color=red label=\"%s\"%s]\n",
+                                rep[bb->index], rep[e->dest->index],
+                                size[rep[bb->index]] > 1 ? "" : label,
+                                cfg == NULL || bitmap_bit_p(&(cfg[bb->index]),
+                                                            e->dest->index)
+                                ? "" : " style=dashed");
+                }
+        }
+
+        fprintf(out, "}\n");
 
-        cfgviz_internal_dump_bis(fun, out, cfg);
+        FOR_ALL_BB_FN(bb, fun)
+                bitmap_clear(&(emitted[bb->index]));
 
-        fclose(out);
-        free(target_filename);
+        free(emitted);
+        free(size);
+        free(rep);
+        bitmap_clear(&shown);
+        bitmap_clear(&flagged);
+        bitmap_clear(&forks);
 }
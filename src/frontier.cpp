@@ -18,6 +18,8 @@
 #include <gcc-plugin.h>
 
 #include "frontier.h"
+#include "phase.h"
+#include "budget.h"
 
 /*
  * Computes the post-dominance frontiers for basic blocks in fun. If the
@@ -45,15 +47,17 @@ bitmap frontier_compute_post_dominance(const function *const fun)
 
         FOR_ALL_BB_FN(bb, fun)
                 bitmap_initialize(&(frontiers[bb->index]),
-                                  &bitmap_default_obstack);
+                                  &phase_obstack);
 
         FOR_ALL_BB_FN(bb, fun) {
                 if (EDGE_COUNT(bb->succs) >= 2) {
                         FOR_EACH_EDGE(e, ei, bb->succs) {
                                 for (runner = e->dest;
                                      runner != get_immediate_dominator(CDI_POST_DOMINATORS, bb);
-                                     runner = get_immediate_dominator(CDI_POST_DOMINATORS, runner))
+                                     runner = get_immediate_dominator(CDI_POST_DOMINATORS, runner)) {
                                         bitmap_set_bit(&(frontiers[runner->index]), bb->index);
+                                        PHASE_COUNT(COUNTER_BITMAP_OPS, 1);
+                                }
                         }
                 }
         }
@@ -62,45 +66,97 @@ bitmap frontier_compute_post_dominance(const function *const fun)
 }
 
 /*
- * Computes CFG’, a part of fun’s CFG without loop backedge. A loop backedge can
- * be found when a successor of a basic block is also one of its predecessors.
+ * Puts in order the indices of the basic blocks of fun reachable from its entry,
+ * in reverse postorder of a depth-first search, and returns their number. Every
+ * edge of the CFG goes forward in this order, except loop backedges.
+ */
+int frontier_reverse_postorder(const function *const fun, int *const order)
+{
+        auto_vec<basic_block> blocks;
+        auto_vec<unsigned int> next;
+        bitmap_head visited;
+        basic_block bb, dest;
+        unsigned int i;
+        int n, tmp;
+
+        bitmap_initialize(&visited, &phase_obstack);
+
+        blocks.safe_push(ENTRY_BLOCK_PTR_FOR_FN(fun));
+        next.safe_push(0U);
+        bitmap_set_bit(&visited, ENTRY_BLOCK);
+        n = 0;
+
+        while (!blocks.is_empty()) {
+                bb = blocks.last();
+                i = next.last();
+
+                if (i < EDGE_COUNT(bb->succs)) {
+                        next.last() = i + 1U;
+                        dest = EDGE_SUCC(bb, i)->dest;
+
+                        if (bitmap_set_bit(&visited, dest->index)) {
+                                blocks.safe_push(dest);
+                                next.safe_push(0U);
+                        }
+                } else {
+                        order[n] = bb->index;
+                        n = n + 1;
+                        blocks.pop();
+                        next.pop();
+                }
+        }
+
+        for (i = 0U; i < (unsigned int) n / 2U; ++i) {
+                tmp = order[i];
+                order[i] = order[n - 1 - i];
+                order[n - 1 - i] = tmp;
+        }
+
+        bitmap_clear(&visited);
+
+        return n;
+}
+
+/*
+ * Computes CFG’, a part of fun’s CFG without loop backedge. A loop backedge is
+ * an edge going backward in the reverse postorder of fun.
+ *
+ * See frontier_reverse_postorder() for details.
  */
 bitmap frontier_compute_cfg_bis(const function *const fun)
 {
-        auto_vec<basic_block> bb_queue;
-        bitmap_head *cfg, *visited_blocks;
+        bitmap_head *cfg;
         basic_block bb;
         edge e;
         edge_iterator ei;
+        int *order, *position;
+        int n, i;
 
         cfg = XNEWVEC(bitmap_head, last_basic_block_for_fn(fun));
-        visited_blocks = XNEWVEC(bitmap_head, last_basic_block_for_fn(fun));
+        order = XNEWVEC(int, n_basic_blocks_for_fn(fun));
+        position = XNEWVEC(int, last_basic_block_for_fn(fun));
 
-        FOR_ALL_BB_FN(bb, fun) {
-                bitmap_initialize(&(cfg[bb->index]), &bitmap_default_obstack);
-                bitmap_initialize(&(visited_blocks[bb->index]),
-                                  &bitmap_default_obstack);
-        }
+        FOR_ALL_BB_FN(bb, fun)
+                bitmap_initialize(&(cfg[bb->index]), &phase_obstack);
+
+        n = frontier_reverse_postorder(fun, order);
 
-        bb_queue.safe_push(ENTRY_BLOCK_PTR_FOR_FN(fun));
+        for (i = 0; i < n; ++i)
+                position[order[i]] = i;
 
-        while (!bb_queue.is_empty()) {
-                bb = bb_queue.pop();
-                bitmap_set_bit(&(visited_blocks[bb->index]), bb->index);
+        for (i = 0; i < n; ++i) {
+                bb = BASIC_BLOCK_FOR_FN(fun, order[i]);
+                PHASE_COUNT(COUNTER_BITMAP_OPS, EDGE_COUNT(bb->succs));
 
                 FOR_EACH_EDGE(e, ei, bb->succs) {
-                        if (!bitmap_bit_p(&(visited_blocks[bb->index]),
-                                          e->dest->index)) {
+                        if (position[e->dest->index] > i)
                                 bitmap_set_bit(&(cfg[bb->index]),
                                                e->dest->index);
-                                bitmap_copy(&(visited_blocks[e->dest->index]),
-                                            &(visited_blocks[bb->index]));
-                                bb_queue.safe_push(e->dest);
-                        }
                 }
         }
 
-        free(visited_blocks);
+        free(position);
+        free(order);
 
         return cfg;
 }
@@ -150,7 +206,7 @@ bitmap frontier_make_groups(const function *const fun, const bitmap ranks)
 
         FOR_ALL_BB_FN(bb, fun)
                 bitmap_initialize(&(groups[bb->index]),
-                                  &bitmap_default_obstack);
+                                  &phase_obstack);
 
         nb_groups = 0;
 
@@ -172,9 +228,13 @@ bitmap frontier_make_groups(const function *const fun, const bitmap ranks)
 /*
  * Computes the post-dominance for groups. A group post-dominates a basic block
  * if all of the basic blocks in the group dominate it. If the dominance
- * information is not set, the behaviour is undefined.
+ * information is not set, the behaviour is undefined. Only the post-dominance
+ * of representatives in rep is computed, with successors replaced by their
+ * representative. Basic blocks are visited in postorder, successors first, so
+ * that the number of passes is bounded by the loop nesting depth rather than
+ * by the number of basic blocks.
  *
- * See calculate_dominance_info() for details
+ * See calculate_dominance_info() and region_collapse() for details
  *
  * The Iterative Post-Dominator Algorithm:
  * for all nodes, n
@@ -189,9 +249,10 @@ bitmap frontier_make_groups(const function *const fun, const bitmap ranks)
  *             Changed <- true
  */
 static bitmap frontier_get_groups_post_dominated(const function *const fun,
-                                                  const bitmap groups)
+                                                  const bitmap groups,
+                                                  const int *const rep)
 {
-        bitmap_head *pdom, new_set;
+        bitmap_head *pdom, new_set, ordered;
         auto_vec<basic_block> dom;
         basic_block bb;
         edge e;
@@ -199,12 +260,15 @@ static bitmap frontier_get_groups_post_dominated(const function *const fun,
         edge_iterator ei;
         unsigned int bb_index;
         unsigned int i, j;
+        int *order;
+        int dest_index, nb_order, k;
         bool changed;
 
         pdom = XNEWVEC(bitmap_head, last_basic_block_for_fn(fun));
+        order = XNEWVEC(int, last_basic_block_for_fn(fun));
 
         FOR_ALL_BB_FN(bb, fun)
-                bitmap_initialize(&(pdom[bb->index]), &bitmap_default_obstack);
+                bitmap_initialize(&(pdom[bb->index]), &phase_obstack);
 
         FOR_EACH_BITMAP(groups, 0, i) {
                 EXECUTE_IF_SET_IN_BITMAP(&(groups[i]), 0, bb_index, bi) {
@@ -216,21 +280,43 @@ static bitmap frontier_get_groups_post_dominated(const function *const fun,
                 }
         }
 
-        bitmap_initialize(&new_set, &bitmap_default_obstack);
+        bitmap_initialize(&new_set, &phase_obstack);
+        bitmap_initialize(&ordered, &phase_obstack);
+
+        /* Unreachable basic blocks come last, in any order */
+        nb_order = post_order_compute(order, true, false);
 
-        for (changed = true; changed;) {
+        for (k = 0; k < nb_order; ++k)
+                bitmap_set_bit(&ordered, order[k]);
+
+        FOR_ALL_BB_FN(bb, fun) {
+                if (!bitmap_bit_p(&ordered, bb->index))
+                        order[nb_order++] = bb->index;
+        }
+
+        for (changed = true; changed && !budget_time_exceeded_p();) {
                 changed = false;
+                PHASE_COUNT(COUNTER_ITERATIONS, 1);
+
+                for (k = 0; k < nb_order; ++k) {
+                        bb = BASIC_BLOCK_FOR_FN(fun, order[k]);
+
+                        if (rep[bb->index] != bb->index)
+                                continue;
 
-                FOR_ALL_BB_FN(bb, fun) {
                         bitmap_clear(&new_set);
+                        PHASE_COUNT(COUNTER_BITMAP_OPS,
+                                    3 + EDGE_COUNT(bb->succs));
 
                         FOR_EACH_EDGE(e, ei, bb->succs) {
+                                dest_index = rep[e->dest->index];
+
                                 if (bitmap_empty_p(&new_set))
                                         bitmap_copy(&new_set,
-                                                    &(pdom[e->dest->index]));
+                                                    &(pdom[dest_index]));
                                 else
                                         bitmap_and_into(&new_set,
-                                                       &(pdom[e->dest->index]));
+                                                        &(pdom[dest_index]));
                         }
 
                         bitmap_ior_into(&new_set, &(pdom[bb->index]));
@@ -242,19 +328,24 @@ static bitmap frontier_get_groups_post_dominated(const function *const fun,
                 }
         }
 
+        bitmap_clear(&ordered);
+        free(order);
+
         return pdom;
 }
 
 /*
  * Computes the post-dominance frontier for groups. A group post-dominance
  * frontier contains all basic blocks that are not post-dominated by the group
- * but have at least 1 of its successors that it is. If the dominance
- * information is not set, the behaviour is undefined.
+ * but have at least 1 of its successors that it is. Collapsed basic blocks,
+ * whose representative in rep is another basic block, are never in it. If the
+ * dominance information is not set, the behaviour is undefined.
  *
- * See calculate_dominance_info() for details
+ * See calculate_dominance_info() and region_collapse() for details
  */
 bitmap frontier_compute_groups_post_dominance(const function *const fun,
-                                              const bitmap groups)
+                                              const bitmap groups,
+                                              const int *const rep)
 {
         bitmap_head *pdom, *frontiers;
         basic_block bb;
@@ -266,16 +357,26 @@ bitmap frontier_compute_groups_post_dominance(const function *const fun,
 
         FOR_ALL_BB_FN(bb, fun)
                 bitmap_initialize(&(frontiers[bb->index]),
-                                  &bitmap_default_obstack);
+                                  &phase_obstack);
 
-        pdom = frontier_get_groups_post_dominated(fun, groups);
+        pdom = frontier_get_groups_post_dominated(fun, groups, rep);
 
         FOR_ALL_BB_FN(bb, fun) {
+                if (rep[bb->index] != bb->index)
+                        continue;
+
                 FOR_EACH_BITMAP(groups, 0, i) {
+                        PHASE_COUNT(COUNTER_BITMAP_OPS, 1);
+
                         if (!bitmap_bit_p(&(pdom[bb->index]), i)) {
+                                PHASE_COUNT(COUNTER_BITMAP_OPS,
+                                            EDGE_COUNT(bb->succs));
+
                                 FOR_EACH_EDGE(e, ei, bb->succs) {
-                                            if (bitmap_bit_p(&(pdom[e->dest->index]), i))
-                                                        bitmap_set_bit(&(frontiers[i]), bb->index);
+                                        if (bitmap_bit_p(&(pdom[rep[
+                                            e->dest->index]]), i))
+                                                bitmap_set_bit(&(frontiers[i]),
+                                                               bb->index);
                                 }
                         }
                 }
@@ -287,26 +388,30 @@ bitmap frontier_compute_groups_post_dominance(const function *const fun,
 }
 
 /*
- * Computes the itered post-dominance frontier for groups. If the dominance
- * information is not set, the behaviour is undefined.
+ * Computes the itered post-dominance frontier for groups, skipping the regions
+ * collapsed in rep. If the dominance information is not set, the behaviour is
+ * undefined.
  *
- * See calculate_dominance_info() for details
+ * See calculate_dominance_info() and region_collapse() for details
  */
 bitmap frontier_compute_groups_iter_post_dominance(const function *const fun,
-                                                   bitmap groups)
+                                                   bitmap groups,
+                                                   const int *const rep)
 {
         bitmap_head *grp_frontiers, *bb_frontiers;
         bitmap_iterator bi1, bi2;
         unsigned int bb_index1, bb_index2;
         int i;
 
-        grp_frontiers = frontier_compute_groups_post_dominance(fun, groups);
+        grp_frontiers = frontier_compute_groups_post_dominance(fun, groups,
+                                                               rep);
         bb_frontiers = frontier_compute_post_dominance(fun);
 
         FOR_EACH_BITMAP(groups, 0, i) {
                 EXECUTE_IF_SET_IN_BITMAP(&(grp_frontiers[i]), 0, bb_index1, bi1) {
                         EXECUTE_IF_SET_IN_BITMAP(&(bb_frontiers[bb_index1]), 0, bb_index2, bi2) {
                                 bitmap_set_bit(&(grp_frontiers[i]), bb_index2);
+                                PHASE_COUNT(COUNTER_BITMAP_OPS, 1);
                         }
                 }
         }
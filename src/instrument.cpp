@@ -0,0 +1,698 @@
+/*
+ * Functions dealing with runtime checks instrumentation.
+ * Copyright (C) 2023-2025 Antoni Blanche
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include <gcc-plugin.h>
+#include <tree.h>
+#include <gimple.h>
+#include <gimple-iterator.h>
+#include <gimplify-me.h>
+#include <stringpool.h>
+#include <ggc.h>
+#include <cfgloop.h>
+
+#include "instrument.h"
+#include "mpicoll.h"
+#include "frontier.h"
+#include "taint.h"
+#include "sites.h"
+#include "phase.h"
+
+/*
+ * Runtime library entry points, built on first use.
+ *
+ * See runtime/mpicoll_rt.h for details.
+ */
+static tree check_begin_decl = NULL_TREE;
+static tree check_end_decl = NULL_TREE;
+static tree trace_decl = NULL_TREE;
+
+/*
+ * Garbage collector roots for the runtime library entry points.
+ */
+static const struct ggc_root_tab instrument_roots[] = {
+        { &check_begin_decl, 1, sizeof(check_begin_decl),
+          &gt_ggc_mx_tree_node, &gt_pch_nx_tree_node },
+        { &check_end_decl, 1, sizeof(check_end_decl),
+          &gt_ggc_mx_tree_node, &gt_pch_nx_tree_node },
+        { &trace_decl, 1, sizeof(trace_decl),
+          &gt_ggc_mx_tree_node, &gt_pch_nx_tree_node },
+        LAST_GGC_ROOT_TAB
+};
+
+/*
+ * Registers the trees kept by the instrumentation across functions as garbage
+ * collector roots.
+ */
+void instrument_register_roots(const char *const plugin_name)
+{
+        register_callback(plugin_name, PLUGIN_REGISTER_GGC_ROOTS, NULL,
+                          (void *) instrument_roots);
+}
+
+/*
+ * Returns the runtime library entry point name stored in decl. The declaration
+ * is built on first use. Entry points take a site ID and a value to agree on.
+ */
+static tree instrument_decl(tree *const decl, const char *const name)
+{
+        tree type;
+
+        if (*decl == NULL_TREE) {
+                type = build_function_type_list(void_type_node,
+                                                unsigned_type_node,
+                                                integer_type_node, NULL_TREE);
+                *decl = build_fn_decl(name, type);
+        }
+
+        return *decl;
+}
+
+/*
+ * Returns a call to decl with site and value as arguments.
+ */
+static gimple *instrument_build_call(const tree decl, const unsigned int site,
+                                     const int value, const location_t loc)
+{
+        gimple *call;
+
+        call = gimple_build_call(decl, 2, build_int_cst(unsigned_type_node,
+                                                        site),
+                                 build_int_cst(integer_type_node, value));
+        gimple_set_location(call, loc);
+
+        return call;
+}
+
+/*
+ * Returns true if stmt may communicate with other ranks, false otherwise. Any
+ * call but builtins, const and pure functions may communicate.
+ */
+static bool instrument_may_communicate(const gimple *const stmt)
+{
+        tree fndecl;
+
+        if (!is_gimple_call(stmt))
+                return false;
+
+        fndecl = gimple_call_fndecl(stmt);
+
+        if (fndecl != NULL_TREE && fndecl_built_in_p(fndecl))
+                return false;
+
+        return !(gimple_call_flags(stmt) & (ECF_CONST | ECF_PURE));
+}
+
+/*
+ * Returns true if a statement in bb before last may communicate with other
+ * ranks, false otherwise. If last is NULL, all statements in bb are checked.
+ */
+static bool instrument_block_communicates(const basic_block bb,
+                                          const gimple *const last)
+{
+        gimple_stmt_iterator gsi;
+
+        for (gsi = gsi_start_bb(bb); !gsi_end_p(gsi); gsi_next(&gsi)) {
+                if (gsi_stmt(gsi) == last)
+                        break;
+
+                if (instrument_may_communicate(gsi_stmt(gsi)))
+                        return true;
+        }
+
+        return false;
+}
+
+/*
+ * Returns true if the agreement for the MPI collective in bb can be started in
+ * dom, false otherwise. The basic block dom must dominate bb. Every path from
+ * dom has to reach bb in the same loop, and no basic block in between may
+ * communicate, so that all ranks start and complete their agreements in the
+ * same order.
+ */
+static bool instrument_hoistable(const basic_block dom, const basic_block bb)
+{
+        unsigned int i;
+
+        if (dom->loop_father != bb->loop_father
+            || !dominated_by_p(CDI_POST_DOMINATORS, dom, bb))
+                return false;
+
+        auto_vec<basic_block> region = get_all_dominated_blocks(CDI_DOMINATORS,
+                                                                dom);
+
+        for (i = 0U; i < region.length(); ++i) {
+                if (region[i] != bb
+                    && dominated_by_p(CDI_POST_DOMINATORS, region[i], bb)
+                    && instrument_block_communicates(region[i], NULL))
+                        return false;
+        }
+
+        return true;
+}
+
+/*
+ * Returns the earliest basic block where the agreement for the MPI collective
+ * stmt in bb can be started. If the agreement cannot be hoisted, then bb is
+ * returned.
+ */
+static basic_block instrument_hoist_point(const function *const fun,
+                                          const basic_block bb,
+                                          const gimple *const stmt)
+{
+        basic_block point = bb;
+        basic_block dom;
+
+        if (instrument_block_communicates(bb, stmt))
+                return bb;
+
+        for (dom = get_immediate_dominator(CDI_DOMINATORS, bb);
+             dom != ENTRY_BLOCK_PTR_FOR_FN(fun) && instrument_hoistable(dom, bb);
+             dom = get_immediate_dominator(CDI_DOMINATORS, dom))
+                point = dom;
+
+        return point;
+}
+
+/*
+ * Inserts the agreement on value for the MPI collective in bb. The agreement
+ * is started at the beginning of point, or right before the MPI collective if
+ * point is bb, and completed right before the MPI collective.
+ */
+static void instrument_collective(function *const fun, const basic_block bb,
+                                  const basic_block point, const int value)
+{
+        gimple *stmt = mpicoll_stmt(bb);
+        location_t loc = gimple_location(stmt);
+        unsigned int site = sites_register(fun, loc, (int) (long) bb->aux);
+        gimple_stmt_iterator gsi;
+
+        if (point == bb)
+                gsi = gsi_for_stmt(stmt);
+        else
+                gsi = gsi_after_labels(point);
+
+        gsi_insert_before(&gsi, instrument_build_call(instrument_decl(
+                          &check_begin_decl, "__mpicoll_check_begin"), site,
+                          value, loc), GSI_SAME_STMT);
+
+        gsi = gsi_for_stmt(stmt);
+        gsi_insert_before(&gsi, instrument_build_call(instrument_decl(
+                          &check_end_decl, "__mpicoll_check_end"), site,
+                          value, loc), GSI_SAME_STMT);
+}
+
+/*
+ * Returns true if a statement in bb after the MPI collective may communicate
+ * with other ranks, false otherwise.
+ */
+static bool instrument_suffix_communicates(const basic_block bb)
+{
+        gimple_stmt_iterator gsi = gsi_for_stmt(mpicoll_stmt(bb));
+
+        for (gsi_next(&gsi); !gsi_end_p(gsi); gsi_next(&gsi)) {
+                if (instrument_may_communicate(gsi_stmt(gsi)))
+                        return true;
+        }
+
+        return false;
+}
+
+/*
+ * Returns true if the MPI collective in next always follows the MPI collective
+ * in bb, false otherwise. Every path from bb has to reach next in the same loop
+ * and every path to next has to come from bb, with no basic block in between
+ * that may communicate.
+ */
+static bool instrument_chained(const basic_block bb, const basic_block next)
+{
+        unsigned int i;
+
+        if (next->loop_father != bb->loop_father
+            || !dominated_by_p(CDI_DOMINATORS, next, bb)
+            || !dominated_by_p(CDI_POST_DOMINATORS, bb, next)
+            || instrument_suffix_communicates(bb)
+            || instrument_block_communicates(next, mpicoll_stmt(next)))
+                return false;
+
+        auto_vec<basic_block> region = get_all_dominated_blocks(CDI_DOMINATORS,
+                                                                bb);
+
+        for (i = 0U; i < region.length(); ++i) {
+                if (region[i] != bb && region[i] != next
+                    && dominated_by_p(CDI_POST_DOMINATORS, region[i], next)
+                    && instrument_block_communicates(region[i], NULL))
+                        return false;
+        }
+
+        return true;
+}
+
+/*
+ * Links each MPI collective in blocks to the MPI collective in blocks that
+ * always follows it, if any. Returns the index of the next basic block for
+ * each basic block, or -1 if there is none, and sets chained for each basic
+ * block following another one. Maximal fork-free chains of MPI collectives
+ * start at the basic blocks not set in chained.
+ */
+static int *instrument_chains(const function *const fun,
+                              const vec<basic_block> &blocks, bitmap chained)
+{
+        int *next = XNEWVEC(int, last_basic_block_for_fn(fun));
+        basic_block bb, runner;
+        unsigned int i;
+
+        for (i = 0U; i < (unsigned int) last_basic_block_for_fn(fun); ++i)
+                next[i] = -1;
+
+        for (i = 0U; i < blocks.length(); ++i) {
+                bb = blocks[i];
+
+                for (runner = get_immediate_dominator(CDI_POST_DOMINATORS, bb);
+                     runner != EXIT_BLOCK_PTR_FOR_FN(fun)
+                     && runner->aux == (void *) LAST_AND_UNUSED_MPI_COLLECTIVE_CODE;
+                     runner = get_immediate_dominator(CDI_POST_DOMINATORS, runner))
+                        ;
+
+                if (blocks.contains(runner) && instrument_chained(bb, runner)) {
+                        next[bb->index] = runner->index;
+                        bitmap_set_bit(chained, runner->index);
+                }
+        }
+
+        return next;
+}
+
+/*
+ * Returns the value to agree on for the chain of MPI collectives starting at
+ * bb. A single MPI collective agrees on its code, a longer chain agrees on a
+ * hash of its sequence of codes, greater than any MPI collective code. Ranks
+ * agreeing on a value call the same sequence of MPI collectives until their
+ * next agreement.
+ */
+static int instrument_chain_value(const function *const fun,
+                                  const int *const next, basic_block bb)
+{
+        unsigned int hash = 2166136261U;
+
+        if (next[bb->index] < 0)
+                return (int) (long) bb->aux;
+
+        for (;;) {
+                hash = (hash ^ (unsigned int) (long) bb->aux) * 16777619U;
+
+                if (next[bb->index] < 0)
+                        break;
+
+                bb = BASIC_BLOCK_FOR_FN(fun, next[bb->index]);
+        }
+
+        return (int) ((hash & 0x3fffffffU) | 0x40000000U);
+}
+
+/*
+ * Weight of a loop level in the static estimate of execution frequencies, and
+ * deepest loop level weighted.
+ */
+#define INSTRUMENT_LOOP_WEIGHT 10
+#define INSTRUMENT_MAX_DEPTH 15
+
+/*
+ * Returns the expected number of executions of bb. Profile counts are used if
+ * they were read from -fprofile-use data, otherwise each enclosing loop is
+ * assumed to run INSTRUMENT_LOOP_WEIGHT iterations.
+ */
+static gcov_type instrument_frequency(const function *const fun,
+                                      const basic_block bb)
+{
+        gcov_type res = 1;
+        int depth;
+
+        if (profile_status_for_fn(fun) == PROFILE_READ
+            && bb->count.initialized_p())
+                return bb->count.to_gcov_type();
+
+        for (depth = MIN(loop_depth(bb->loop_father), INSTRUMENT_MAX_DEPTH);
+             depth > 0; --depth)
+                res = res * INSTRUMENT_LOOP_WEIGHT;
+
+        return res;
+}
+
+/*
+ * Returns the expected number of times loop is entered.
+ *
+ * See instrument_frequency() for details.
+ */
+static gcov_type instrument_entry_frequency(const function *const fun,
+                                            const class loop *const loop)
+{
+        gcov_type res = 0;
+        edge e;
+        edge_iterator ei;
+
+        FOR_EACH_EDGE(e, ei, loop->header->preds) {
+                if (flow_bb_inside_loop_p(loop, e->src))
+                        continue;
+
+                if (profile_status_for_fn(fun) == PROFILE_READ
+                    && e->count().initialized_p())
+                        res = res + e->count().to_gcov_type();
+                else
+                        res = res + instrument_frequency(fun, e->src);
+        }
+
+        return res;
+}
+
+/*
+ * Sets in checked the rank-uniform loops of fun to check on entry, so that the
+ * expected number of checks executed is minimal. A rank-uniform loop is either
+ * checked on entry, or its MPI collectives in blocks and its inner loops are
+ * checked on their own, chains at their head. A loop entered more often than
+ * its MPI collectives are called, such as one calling them only on some
+ * iterations, is not checked on entry.
+ *
+ * See taint_loop_uniform_p() for details.
+ */
+static void instrument_place_loops(function *const fun,
+                                   const struct taint *const taint,
+                                   const vec<basic_block> &blocks,
+                                   const_bitmap chained, bitmap checked)
+{
+        gcov_type *cost;
+        gcov_type entry;
+        unsigned int i;
+
+        if (loops_for_fn(fun) == NULL)
+                return;
+
+        cost = XCNEWVEC(gcov_type, number_of_loops(fun));
+
+        for (i = 0U; i < blocks.length(); ++i) {
+                if (!bitmap_bit_p(chained, blocks[i]->index))
+                        cost[blocks[i]->loop_father->num]
+                                += instrument_frequency(fun, blocks[i]);
+        }
+
+        /* Loops around a rank-tainted loop are rank-tainted too */
+        for (auto loop: loops_list(fun, LI_FROM_INNERMOST)) {
+                if (cost[loop->num] == 0
+                    || !taint_loop_uniform_p(taint, loop))
+                        continue;
+
+                entry = instrument_entry_frequency(fun, loop);
+
+                if (entry <= cost[loop->num]) {
+                        bitmap_set_bit(checked, loop->num);
+                        cost[loop->num] = entry;
+                }
+
+                cost[loop_outer(loop)->num] += cost[loop->num];
+        }
+
+        free(cost);
+}
+
+/*
+ * Returns the outermost loop in checked containing bb, or NULL if bb is not in
+ * a loop checked on entry.
+ *
+ * See instrument_place_loops() for details.
+ */
+static class loop *instrument_checked_loop(function *const fun,
+                                           const_bitmap checked,
+                                           const basic_block bb)
+{
+        class loop *res = NULL;
+        class loop *loop;
+
+        if (loops_for_fn(fun) == NULL)
+                return NULL;
+
+        for (loop = bb->loop_father; loop_outer(loop) != NULL;
+             loop = loop_outer(loop)) {
+                if (bitmap_bit_p(checked, loop->num))
+                        res = loop;
+        }
+
+        return res;
+}
+
+/*
+ * Inserts an agreement on each edge entering loop in fun. All ranks entering a
+ * rank-uniform loop call the same sequence of MPI collectives, so this single
+ * agreement replaces the agreement of every MPI collective in loop. Entering
+ * ranks agree on a negative value derived from the loop site ID, which never
+ * matches a MPI collective code. The insertions are committed by
+ * gsi_commit_edge_inserts().
+ */
+static void instrument_loop(function *const fun, const class loop *const loop,
+                            location_t loc)
+{
+        gimple_stmt_iterator gsi = gsi_last_bb(loop->header);
+        gimple_seq seq;
+        unsigned int site;
+        int value;
+        edge e;
+        edge_iterator ei;
+
+        if (!gsi_end_p(gsi) && gimple_location(gsi_stmt(gsi)) != UNKNOWN_LOCATION)
+                loc = gimple_location(gsi_stmt(gsi));
+
+        site = sites_register(fun, loc, MPICOLL_SITES_LOOP);
+        value = -(int) (site & 0x7fffffffU) - 1;
+
+        FOR_EACH_EDGE(e, ei, loop->header->preds) {
+                if (flow_bb_inside_loop_p(loop, e->src))
+                        continue;
+
+                seq = NULL;
+                gimple_seq_add_stmt(&seq, instrument_build_call(instrument_decl(
+                                    &check_begin_decl, "__mpicoll_check_begin"),
+                                    site, value, loc));
+                gimple_seq_add_stmt(&seq, instrument_build_call(instrument_decl(
+                                    &check_end_decl, "__mpicoll_check_end"),
+                                    site, value, loc));
+                gsi_insert_seq_on_edge(e, seq);
+        }
+}
+
+/*
+ * Inserts an agreement on leaving fun before each return. Ranks leaving fun
+ * agree on LAST_AND_UNUSED_MPI_COLLECTIVE_CODE, so that a rank calling a MPI
+ * collective while another one returns is detected.
+ */
+static void instrument_exits(function *const fun)
+{
+        const int code = LAST_AND_UNUSED_MPI_COLLECTIVE_CODE;
+        gimple_stmt_iterator gsi;
+        unsigned int site;
+        location_t loc;
+        edge e;
+        edge_iterator ei;
+
+        FOR_EACH_EDGE(e, ei, EXIT_BLOCK_PTR_FOR_FN(fun)->preds) {
+                gsi = gsi_last_bb(e->src);
+                loc = fun->function_end_locus;
+
+                if (!gsi_end_p(gsi)
+                    && gimple_code(gsi_stmt(gsi)) == GIMPLE_RETURN) {
+                        if (gimple_location(gsi_stmt(gsi)) != UNKNOWN_LOCATION)
+                                loc = gimple_location(gsi_stmt(gsi));
+
+                        site = sites_register(fun, loc, code);
+
+                        gsi_insert_before(&gsi, instrument_build_call(
+                                          instrument_decl(&check_begin_decl,
+                                          "__mpicoll_check_begin"), site, code,
+                                          loc), GSI_SAME_STMT);
+                        gsi_insert_before(&gsi, instrument_build_call(
+                                          instrument_decl(&check_end_decl,
+                                          "__mpicoll_check_end"), site, code,
+                                          loc), GSI_SAME_STMT);
+                }
+        }
+}
+
+/*
+ * Inserts runtime checks in fun if at least 1 group has a non-empty
+ * post-dominance frontier. Each MPI collective in fun is preceded by a check
+ * agreeing on the collective code among all ranks. The agreement is started
+ * with a nonblocking collective as early as possible and completed right
+ * before the MPI collective. MPI collectives in a rank-uniform loop are checked
+ * once on entering the loop instead, unless the loop is expected to be entered
+ * more often than they are called, and a chain of MPI collectives always
+ * following each other is checked once at its first MPI collective. Only MPI
+ * collectives on MPI_COMM_WORLD are checked. MPI collective codes must be set
+ * in basic blocks’s aux field and the post-dominance information must be
+ * computed before calling this function.
+ */
+void instrument_checks(function *const fun, const bitmap groups,
+                       const bitmap pdf)
+{
+        auto_vec<basic_block> blocks, heads, points;
+        struct taint *taint;
+        bitmap_head entered, chained, checked;
+        int *next;
+        class loop *loop;
+        basic_block bb;
+        bool flagged = false;
+        bool finalized = false;
+        unsigned int i;
+
+        FOR_EACH_BITMAP(groups, 0, i) {
+                if (!bitmap_empty_p(&(pdf[i])))
+                        flagged = true;
+        }
+
+        if (!flagged)
+                return;
+
+        /*
+         * Every MPI collective is checked, not only flagged ones: a rank
+         * reaching an unchecked MPI collective while another one waits for an
+         * agreement would deadlock. MPI_Init cannot be checked. Agreements are
+         * made between all ranks, so MPI collectives on other communicators
+         * than MPI_COMM_WORLD, which only some ranks may call, are not checked.
+         */
+        FOR_EACH_BB_FN(bb, fun) {
+                if (bb->aux == (void *) MPI_FINALIZE)
+                        finalized = true;
+
+                if (bb->aux != (void *) LAST_AND_UNUSED_MPI_COLLECTIVE_CODE
+                    && bb->aux != (void *) MPI_INIT
+                    && mpicoll_world_p(as_a<gcall *>(mpicoll_stmt(bb))))
+                        blocks.safe_push(bb);
+        }
+
+        /*
+         * Functions only calling MPI collectives on other communicators may
+         * only be called by some ranks, so their exits are not checked either.
+         */
+        if (blocks.is_empty())
+                return;
+
+        calculate_dominance_info(CDI_DOMINATORS);
+        taint = taint_compute(fun);
+        bitmap_initialize(&entered, &phase_obstack);
+        bitmap_initialize(&chained, &phase_obstack);
+        bitmap_initialize(&checked, &phase_obstack);
+
+        /* Chains never cross loop boundaries */
+        next = instrument_chains(fun, blocks, &chained);
+        instrument_place_loops(fun, taint, blocks, &chained, &checked);
+
+        for (i = 0U; i < blocks.length(); ++i) {
+                loop = instrument_checked_loop(fun, &checked, blocks[i]);
+
+                if (loop != NULL) {
+                        if (bitmap_set_bit(&entered, loop->num))
+                                instrument_loop(fun, loop,
+                                                mpicoll_location(blocks[i]));
+                } else if (!bitmap_bit_p(&chained, blocks[i]->index)) {
+                        heads.safe_push(blocks[i]);
+                        points.safe_push(instrument_hoist_point(fun, blocks[i],
+                                                   mpicoll_stmt(blocks[i])));
+                }
+        }
+
+        for (i = 0U; i < heads.length(); ++i)
+                instrument_collective(fun, heads[i], points[i],
+                                      instrument_chain_value(fun, next,
+                                                             heads[i]));
+
+        if (!finalized)
+                instrument_exits(fun);
+
+        gsi_commit_edge_inserts();
+
+        free(next);
+        bitmap_clear(&checked);
+        bitmap_clear(&chained);
+        bitmap_clear(&entered);
+        taint_free(taint);
+        free_dominance_info(CDI_DOMINATORS);
+}
+
+/*
+ * Returns the communicator stmt is called on, converted to an unsigned 64-bit
+ * integer, or 0 if the MPI collective does not take a communicator. Statements
+ * computing the conversion are inserted before gsi.
+ *
+ * See mpicoll_comm() for details.
+ */
+static tree instrument_comm(gimple_stmt_iterator *const gsi,
+                            const gcall *const stmt)
+{
+        tree comm = mpicoll_comm(stmt);
+
+        if (comm == NULL_TREE)
+                return build_int_cst(long_long_unsigned_type_node, 0);
+
+        return force_gimple_operand_gsi(gsi, fold_convert(
+                                        long_long_unsigned_type_node, comm),
+                                        true, NULL_TREE, true, GSI_SAME_STMT);
+}
+
+/*
+ * Inserts a call recording each MPI collective in fun, but MPI_Init, right
+ * before it is called. Calls pass the site ID, the code and the communicator of
+ * the MPI collective. MPI collective codes must be set in basic blocks’s aux
+ * field before calling this function.
+ */
+void instrument_traces(function *const fun)
+{
+        gimple_stmt_iterator gsi;
+        gimple *stmt, *call;
+        unsigned int site;
+        tree comm;
+        basic_block bb;
+
+        if (trace_decl == NULL_TREE)
+                trace_decl = build_fn_decl("__mpicoll_trace",
+                                           build_function_type_list(
+                                           void_type_node, unsigned_type_node,
+                                           integer_type_node,
+                                           long_long_unsigned_type_node,
+                                           NULL_TREE));
+
+        FOR_EACH_BB_FN(bb, fun) {
+                if (bb->aux == (void *) LAST_AND_UNUSED_MPI_COLLECTIVE_CODE
+                    || bb->aux == (void *) MPI_INIT)
+                        continue;
+
+                stmt = mpicoll_stmt(bb);
+
+                /* Blocks split by runtime checks do not have a code */
+                if (stmt == NULL)
+                        continue;
+
+                gsi = gsi_for_stmt(stmt);
+                site = sites_register(fun, gimple_location(stmt),
+                                      (int) (long) bb->aux);
+                comm = instrument_comm(&gsi, as_a<gcall *>(stmt));
+
+                call = gimple_build_call(trace_decl, 3,
+                                         build_int_cst(unsigned_type_node,
+                                                       site),
+                                         build_int_cst(integer_type_node,
+                                                       (long) bb->aux),
+                                         comm);
+                gimple_set_location(call, gimple_location(stmt));
+                gsi_insert_before(&gsi, call, GSI_SAME_STMT);
+        }
+}
@@ -0,0 +1,449 @@
+/*
+ * Functions dealing with rank-uniform loops.
+ * Copyright (C) 2023-2025 Antoni Blanche
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include <gcc-plugin.h>
+#include <tree.h>
+#include <gimple.h>
+#include <gimple-iterator.h>
+#include <cfgloop.h>
+
+#include "loops.h"
+#include "taint.h"
+#include "frontier.h"
+#include "phase.h"
+
+/*
+ * Number of definitions followed back from an operand to find its base.
+ */
+#define LOOPS_MAX_DEPTH 8
+
+/*
+ * An affine value, base + offset. Constants have no base.
+ */
+struct affine {
+        tree base;              /* Base with the same value in the loop */
+        HOST_WIDE_INT offset;   /* Constant offset */
+};
+
+/*
+ * Sets value to the integer constant t. Returns true if t is an integer
+ * constant of at most 32 bits, so that sums of a few of them cannot overflow,
+ * false otherwise.
+ */
+static bool loops_constant_p(const_tree t, HOST_WIDE_INT *const value)
+{
+        if (TREE_CODE(t) != INTEGER_CST || !tree_fits_shwi_p(t)
+            || !IN_RANGE(tree_to_shwi(t), INT_MIN, INT_MAX))
+                return false;
+
+        *value = tree_to_shwi(t);
+
+        return true;
+}
+
+/*
+ * Returns true if stmt assigns t, false otherwise.
+ */
+static bool loops_defines_p(const gimple *const stmt, const_tree t)
+{
+        const gasm *asm_stmt;
+        unsigned int i;
+
+        if (gimple_get_lhs(stmt) == t)
+                return true;
+
+        if (gimple_code(stmt) != GIMPLE_ASM)
+                return false;
+
+        asm_stmt = as_a<const gasm *>(stmt);
+
+        for (i = 0U; i < gimple_asm_noutputs(asm_stmt); ++i) {
+                if (TREE_VALUE(gimple_asm_output_op(asm_stmt, i)) == t)
+                        return true;
+        }
+
+        return false;
+}
+
+/*
+ * Sets in assigned the DECL_UID of the parameters of fun assigned by a
+ * statement.
+ */
+static void loops_assigned(const function *const fun, const bitmap assigned)
+{
+        gimple_stmt_iterator gsi;
+        basic_block bb;
+        tree lhs;
+
+        FOR_EACH_BB_FN(bb, fun) {
+                for (gsi = gsi_start_bb(bb); !gsi_end_p(gsi); gsi_next(&gsi)) {
+                        lhs = gimple_get_lhs(gsi_stmt(gsi));
+
+                        if (lhs != NULL_TREE && TREE_CODE(lhs) == PARM_DECL)
+                                bitmap_set_bit(assigned, DECL_UID(lhs));
+                }
+        }
+}
+
+/*
+ * Returns true if t has the same value everywhere in loop, false otherwise.
+ * Such values are SSA names defined outside of loop, and parameters whose
+ * address is never taken and whose DECL_UID is not in assigned.
+ */
+static bool loops_invariant_p(const class loop *const loop, const_tree t,
+                              const bitmap assigned)
+{
+        basic_block bb;
+
+        if (TREE_CODE(t) == SSA_NAME) {
+                bb = gimple_bb(SSA_NAME_DEF_STMT(t));
+
+                return bb == NULL || !flow_bb_inside_loop_p(loop, bb);
+        }
+
+        return TREE_CODE(t) == PARM_DECL && !TREE_ADDRESSABLE(t)
+               && !bitmap_bit_p(assigned, DECL_UID(t));
+}
+
+static bool loops_affine_assign(const class loop *loop, const gimple *stmt,
+                                const bitmap assigned, struct affine *res,
+                                int depth);
+
+/*
+ * Sets res to the value of the operand t in loop as an affine value, following
+ * the definitions of SSA names. Returns true on success, false if t is neither
+ * a constant, nor the same value everywhere in loop plus a constant.
+ */
+static bool loops_affine(const class loop *const loop, const tree t,
+                         const bitmap assigned, struct affine *const res,
+                         const int depth)
+{
+        gimple *def;
+
+        if (loops_constant_p(t, &(res->offset))) {
+                res->base = NULL_TREE;
+                return true;
+        }
+
+        if (TREE_CODE(t) == SSA_NAME && depth < LOOPS_MAX_DEPTH) {
+                def = SSA_NAME_DEF_STMT(t);
+
+                if (is_gimple_assign(def)
+                    && loops_affine_assign(loop, def, assigned, res, depth + 1))
+                        return true;
+        }
+
+        if (!loops_invariant_p(loop, t, assigned))
+                return false;
+
+        res->base = t;
+        res->offset = 0;
+
+        return true;
+}
+
+/*
+ * Sets res to the value assigned by stmt in loop as an affine value. Returns
+ * true on success, false otherwise.
+ *
+ * See loops_affine() for details.
+ */
+static bool loops_affine_assign(const class loop *const loop,
+                                const gimple *const stmt,
+                                const bitmap assigned, struct affine *const res,
+                                const int depth)
+{
+        tree rhs1 = gimple_assign_rhs1(stmt);
+        tree rhs2 = gimple_assign_rhs2(stmt);
+        HOST_WIDE_INT value;
+
+        switch (gimple_assign_rhs_code(stmt)) {
+        case PLUS_EXPR:
+                if (loops_constant_p(rhs1, &value)) {
+                        rhs1 = rhs2;
+                        rhs2 = gimple_assign_rhs1(stmt);
+                }
+
+                if (!loops_constant_p(rhs2, &value)
+                    || !loops_affine(loop, rhs1, assigned, res, depth))
+                        return false;
+
+                res->offset = res->offset + value;
+
+                return true;
+        case MINUS_EXPR:
+                if (!loops_constant_p(rhs2, &value)
+                    || !loops_affine(loop, rhs1, assigned, res, depth))
+                        return false;
+
+                res->offset = res->offset - value;
+
+                return true;
+        case SSA_NAME:
+        case PARM_DECL:
+        case INTEGER_CST:
+                return loops_affine(loop, rhs1, assigned, res, depth);
+        default:
+                return false;
+        }
+}
+
+/*
+ * Returns true if iv is an induction variable of loop, whose basic blocks are
+ * body, false otherwise. An induction variable is a local variable whose
+ * address is never taken, of a signed integer type whose overflow is
+ * undefined, and assigned by a single statement of loop that adds a constant
+ * to it at each iteration.
+ */
+static bool loops_induction_p(const class loop *const loop,
+                              const basic_block *const body, const_tree iv)
+{
+        gimple_stmt_iterator gsi;
+        gimple *stmt, *step = NULL;
+        HOST_WIDE_INT value;
+        edge e;
+        edge_iterator ei;
+        unsigned int i;
+
+        if (TREE_CODE(iv) != VAR_DECL || is_global_var(iv)
+            || TREE_ADDRESSABLE(iv) || !INTEGRAL_TYPE_P(TREE_TYPE(iv))
+            || !TYPE_OVERFLOW_UNDEFINED(TREE_TYPE(iv)))
+                return false;
+
+        for (i = 0U; i < loop->num_nodes; ++i) {
+                for (gsi = gsi_start_bb(body[i]); !gsi_end_p(gsi);
+                     gsi_next(&gsi)) {
+                        stmt = gsi_stmt(gsi);
+
+                        if (!loops_defines_p(stmt, iv))
+                                continue;
+
+                        if (step != NULL)
+                                return false;
+
+                        step = stmt;
+                }
+        }
+
+        if (step == NULL || !is_gimple_assign(step))
+                return false;
+
+        switch (gimple_assign_rhs_code(step)) {
+        case PLUS_EXPR:
+                if (!(gimple_assign_rhs1(step) == iv
+                      && loops_constant_p(gimple_assign_rhs2(step), &value))
+                    && !(gimple_assign_rhs2(step) == iv
+                         && loops_constant_p(gimple_assign_rhs1(step),
+                                             &value)))
+                        return false;
+
+                break;
+        case MINUS_EXPR:
+                if (gimple_assign_rhs1(step) != iv
+                    || !loops_constant_p(gimple_assign_rhs2(step), &value))
+                        return false;
+
+                break;
+        default:
+                return false;
+        }
+
+        /* Skipping the step on some iterations would change the trip count */
+        FOR_EACH_EDGE(e, ei, loop->header->preds) {
+                if (flow_bb_inside_loop_p(loop, e->src)
+                    && !dominated_by_p(CDI_DOMINATORS, e->src,
+                                       gimple_bb(step)))
+                        return false;
+        }
+
+        return value != 0;
+}
+
+/*
+ * Sets init to the value of iv on entering loop, assigned by the last
+ * assignment to iv on the straight path to the single entry edge of loop.
+ * Returns true on success, false otherwise.
+ */
+static bool loops_initial(const function *const fun,
+                          const class loop *const loop, const_tree iv,
+                          const bitmap assigned, struct affine *const init)
+{
+        gimple_stmt_iterator gsi;
+        basic_block bb = NULL;
+        gimple *stmt;
+        edge e;
+        edge_iterator ei;
+        int n;
+
+        FOR_EACH_EDGE(e, ei, loop->header->preds) {
+                if (flow_bb_inside_loop_p(loop, e->src))
+                        continue;
+
+                if (bb != NULL)
+                        return false;
+
+                bb = e->src;
+        }
+
+        for (n = n_basic_blocks_for_fn(fun);
+             bb != NULL && bb != ENTRY_BLOCK_PTR_FOR_FN(fun) && n > 0;
+             bb = single_pred_p(bb) ? single_pred(bb) : NULL, --n) {
+                for (gsi = gsi_last_bb(bb); !gsi_end_p(gsi); gsi_prev(&gsi)) {
+                        stmt = gsi_stmt(gsi);
+
+                        if (loops_defines_p(stmt, iv))
+                                return is_gimple_assign(stmt)
+                                       && loops_affine_assign(loop, stmt,
+                                                              assigned, init,
+                                                              0);
+                }
+        }
+
+        return false;
+}
+
+/*
+ * Returns true if all ranks in loop, whose basic blocks are body, take its exit
+ * edge e at the same iteration, false otherwise. Either the exit test does not
+ * depend on the rank, or it compares an induction variable to a bound at the
+ * same distance from its initial value on all ranks, such as i < rank + 10
+ * with i starting at rank. A bound written under a rank-tainted branch is
+ * rank-tainted, so its loop is only uniform through the second case.
+ *
+ * See taint_compute() for details.
+ */
+static bool loops_exit_uniform_p(const function *const fun,
+                                 const struct taint *const taint,
+                                 const class loop *const loop,
+                                 const basic_block *const body, const edge e,
+                                 const bitmap assigned)
+{
+        gimple *stmt = gsi_stmt(gsi_last_bb(e->src));
+        struct affine init, bound;
+        tree iv, other;
+        int i;
+
+        if ((e->flags & EDGE_COMPLEX) != 0)
+                return false;
+
+        if (stmt == NULL || !taint_control_p(taint, stmt))
+                return true;
+
+        if (gimple_code(stmt) != GIMPLE_COND)
+                return false;
+
+        for (i = 0; i < 2; ++i) {
+                iv = i == 0 ? gimple_cond_lhs(stmt) : gimple_cond_rhs(stmt);
+                other = i == 0 ? gimple_cond_rhs(stmt) : gimple_cond_lhs(stmt);
+
+                if (loops_induction_p(loop, body, iv)
+                    && loops_initial(fun, loop, iv, assigned, &init)
+                    && loops_affine(loop, other, assigned, &bound, 0)
+                    && init.base == bound.base)
+                        return true;
+        }
+
+        return false;
+}
+
+/*
+ * Sets in exits the basic blocks of fun ending with an exit test of a
+ * rank-uniform loop. All ranks entering a rank-uniform loop run the same number
+ * of iterations: each exit test either does not depend on the rank, or compares
+ * an induction variable to a bound whose distance to the initial value of the
+ * induction variable does not depend on the rank. Basic blocks also ending with
+ * an exit test of a rank-divergent loop are not set.
+ *
+ * See taint_compute() for details.
+ */
+void loops_uniform_exits(function *const fun, const struct taint *const taint,
+                         const bitmap exits)
+{
+        bitmap_head assigned, divergent;
+        basic_block *body;
+        bool uniform;
+        edge e;
+        unsigned int i;
+
+        if (loops_for_fn(fun) == NULL)
+                return;
+
+        bitmap_initialize(&assigned, &phase_obstack);
+        bitmap_initialize(&divergent, &phase_obstack);
+
+        loops_assigned(fun, &assigned);
+        calculate_dominance_info(CDI_DOMINATORS);
+
+        for (auto loop: loops_list(fun, 0)) {
+                body = get_loop_body(loop);
+                auto_vec<edge> loop_exits = get_loop_exit_edges(loop, body);
+                uniform = true;
+
+                PHASE_COUNT(COUNTER_BITMAP_OPS, loop_exits.length());
+
+                FOR_EACH_VEC_ELT(loop_exits, i, e) {
+                        if (uniform)
+                                uniform = loops_exit_uniform_p(fun, taint,
+                                                               loop, body, e,
+                                                               &assigned);
+                }
+
+                FOR_EACH_VEC_ELT(loop_exits, i, e)
+                        bitmap_set_bit(uniform ? exits : &divergent,
+                                       e->src->index);
+
+                free(body);
+        }
+
+        bitmap_and_compl_into(exits, &divergent);
+
+        free_dominance_info(CDI_DOMINATORS);
+        bitmap_clear(&divergent);
+        bitmap_clear(&assigned);
+}
+
+/*
+ * Sets in exits the basic blocks of fun ending with an exit test of a
+ * rank-uniform loop, computing the rank-tainted values of fun.
+ */
+void loops_compute_exits(function *const fun, const bitmap exits)
+{
+        struct taint *taint;
+
+        if (loops_for_fn(fun) == NULL)
+                return;
+
+        taint = taint_compute(fun);
+        loops_uniform_exits(fun, taint, exits);
+        taint_free(taint);
+}
+
+/*
+ * Removes the exit tests of rank-uniform loops in exits from the post-dominance
+ * frontiers pdf of groups, so that only loops whose number of iterations may
+ * depend on the rank are forks.
+ */
+void loops_prune_forks(const bitmap groups, const bitmap pdf,
+                       const_bitmap exits)
+{
+        int i;
+
+        FOR_EACH_BITMAP(groups, 0, i) {
+                bitmap_and_compl_into(&(pdf[i]), exits);
+                PHASE_COUNT(COUNTER_BITMAP_OPS, 1);
+        }
+}
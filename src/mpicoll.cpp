@@ -23,29 +23,60 @@
 #include <string.h>
 
 #include "mpicoll.h"
+#include "mpicoll_hash.h"
+#include "mpicoll_table.h"
+#include "frontier.h"
+#include "phase.h"
+#include "budget.h"
+
+/*
+ * Returns the code of the MPI collective spelled name, or
+ * LAST_AND_UNUSED_MPI_COLLECTIVE_CODE if name is not a MPI collective spelling.
+ *
+ * See include/mpicoll_hash.h for details.
+ */
+static enum mpi_collective_code mpicoll_lookup(const char *const name)
+{
+        const struct mpicoll_table_entry *entry;
+        int displacement;
+
+        displacement = MPICOLL_TABLE_DISPLACEMENTS[mpicoll_hash(name, 0U)
+                                                   & (MPICOLL_TABLE_BUCKETS
+                                                      - 1U)];
+
+        if (displacement < 0)
+                entry = &(MPICOLL_TABLE[-displacement - 1]);
+        else
+                entry = &(MPICOLL_TABLE[mpicoll_hash(name, displacement)
+                                        & (MPICOLL_TABLE_SIZE - 1U)]);
+
+        if (entry->name == NULL || strcmp(entry->name, name) != 0)
+                return LAST_AND_UNUSED_MPI_COLLECTIVE_CODE;
+
+        return (enum mpi_collective_code) entry->code;
+}
 
 /*
  * Returns the MPI collective code if stmt is a call to an MPI function defined
- * in MPI_collectives.def, or LAST_AND_UNUSED_MPI_COLLECCTIVE_CODE otherwise.
+ * in MPI_collectives.def, in any of its spellings, or
+ * LAST_AND_UNUSED_MPI_COLLECTIVE_CODE otherwise.
  *
  * See include/MPI_collectives.def for details.
  */
-static enum mpi_collective_code mpicoll_code(const gimple *const stmt)
+enum mpi_collective_code mpicoll_code(const gimple *const stmt)
 {
-        const char *fname;
-        int i;
+        tree fndecl;
 
-        if (is_gimple_call(stmt)) {
-                fname = IDENTIFIER_POINTER(DECL_NAME(gimple_call_fndecl(stmt)));
+        if (!is_gimple_call(stmt))
+                return LAST_AND_UNUSED_MPI_COLLECTIVE_CODE;
 
-                for (i = 0; i < 5; ++i) {
-                        if (strncmp(fname, MPI_COLLECTIVE_NAME[i],
-                                    strlen(MPI_COLLECTIVE_NAME[i])) == 0)
-                                return (enum mpi_collective_code) i;
-                }
-        }
+        fndecl = gimple_call_fndecl(stmt);
+
+        /* Indirect calls are not MPI collectives */
+        if (fndecl == NULL_TREE || DECL_NAME(fndecl) == NULL_TREE)
+                return LAST_AND_UNUSED_MPI_COLLECTIVE_CODE;
 
-        return LAST_AND_UNUSED_MPI_COLLECTIVE_CODE;
+        return mpicoll_lookup(IDENTIFIER_POINTER(DECL_NAME(fndecl)));
 }
 
 /*
@@ -150,41 +181,90 @@ void mpicoll_split(const function *const fun)
 }
 
 /*
- * Ranks bb and all of its successors using cfg if they contain a MPI
- * collective. If bb do not contain a MPI collective, then its rank is 0.
+ * Returns MPI collectives’s rank in fun using cfg. Loop backedges in cfg must
+ * be removed from cfg before calling this function.
+ *
+ * The ranks a basic block can be reached with are the ranks its predecessors
+ * in cfg are left with, so that each basic block is visited once, in reverse
+ * postorder, rather than once per path of cfg.
  */
-static void mpicoll_rank_next(const bitmap cfg, const basic_block bb,
-                               bitmap ranks, int current_rank)
+bitmap mpicoll_ranks(const function *const fun, const bitmap cfg)
 {
-        edge e;
-        edge_iterator ei;
+        bitmap_head *ranks = XNEWVEC(bitmap_head, last_basic_block_for_fn(fun));
+        bitmap_head *reach = XNEWVEC(bitmap_head, last_basic_block_for_fn(fun));
+        bitmap_head out;
+        basic_block bb;
+        bitmap_iterator bi;
+        unsigned int rank, dest_index;
+        int *order;
+        int n, i;
 
-        if (bb->aux != (void *) LAST_AND_UNUSED_MPI_COLLECTIVE_CODE) {
-                bitmap_set_bit(&(ranks[current_rank]), bb->index);
-                current_rank = current_rank + 1;
+        FOR_ALL_BB_FN(bb, fun) {
+                bitmap_initialize(&(ranks[bb->index]), &phase_obstack);
+                bitmap_initialize(&(reach[bb->index]), &phase_obstack);
         }
 
-        FOR_EACH_EDGE(e, ei, bb->succs) {
-                if (bitmap_bit_p(&(cfg[bb->index]), e->dest->index))
-                        mpicoll_rank_next(cfg, e->dest, ranks, current_rank);
+        bitmap_initialize(&out, &phase_obstack);
+        order = XNEWVEC(int, n_basic_blocks_for_fn(fun));
+        n = frontier_reverse_postorder(fun, order);
+
+        bitmap_set_bit(&(reach[ENTRY_BLOCK]), 0);
+
+        /* The exact analysis is abandoned once out of time */
+        for (i = 0; i < n && !budget_time_exceeded_p(); ++i) {
+                bb = BASIC_BLOCK_FOR_FN(fun, order[i]);
+                PHASE_COUNT(COUNTER_RANK_VISITS, 1);
+
+                if (bb->aux != (void *) LAST_AND_UNUSED_MPI_COLLECTIVE_CODE) {
+                        bitmap_clear(&out);
+
+                        EXECUTE_IF_SET_IN_BITMAP(&(reach[bb->index]), 0, rank,
+                                                 bi) {
+                                bitmap_set_bit(&(ranks[rank]), bb->index);
+                                bitmap_set_bit(&out, rank + 1);
+                                PHASE_COUNT(COUNTER_BITMAP_OPS, 2);
+                        }
+                } else {
+                        bitmap_copy(&out, &(reach[bb->index]));
+                        PHASE_COUNT(COUNTER_BITMAP_OPS, 1);
+                }
+
+                EXECUTE_IF_SET_IN_BITMAP(&(cfg[bb->index]), 0, dest_index,
+                                         bi) {
+                        bitmap_ior_into(&(reach[dest_index]), &out);
+                        PHASE_COUNT(COUNTER_BITMAP_OPS, 1);
+                }
+
+                bitmap_clear(&(reach[bb->index]));
         }
+
+        bitmap_clear(&out);
+        free(order);
+        free(reach);
+
+        return ranks;
 }
 
 /*
- * Returns MPI collectives’s rank in fun using cfg. Loop backedges in cfg must
- * be removed from cfg before calling this function to avoid an infinite loop.
+ * Returns the MPI collective gimple statement in bb, or NULL if bb does not
+ * contain MPI collective. The basic block must contain only one MPI collective
+ * gimple statement.
+ *
+ * See mpicoll_split() for details.
  */
-bitmap mpicoll_ranks(const function *const fun, const bitmap cfg)
+gimple *mpicoll_stmt(const basic_block bb)
 {
-        bitmap_head *ranks = XNEWVEC(bitmap_head, last_basic_block_for_fn(fun));
-        basic_block bb;
+        gimple_stmt_iterator gsi;
+        gimple *stmt;
 
-        FOR_ALL_BB_FN(bb, fun)
-                bitmap_initialize(&(ranks[bb->index]), &bitmap_default_obstack);
+        for (gsi = gsi_start_bb(bb); !gsi_end_p(gsi); gsi_next(&gsi)) {
+                stmt = gsi_stmt(gsi);
 
-        mpicoll_rank_next(cfg, ENTRY_BLOCK_PTR_FOR_FN(fun), ranks, 0);
+                if (mpicoll_code(stmt) != LAST_AND_UNUSED_MPI_COLLECTIVE_CODE)
+                        return stmt;
+        }
 
-        return ranks;
+        return NULL;
 }
 
 /*
@@ -196,25 +276,106 @@ bitmap mpicoll_ranks(const function *const fun, const bitmap cfg)
  */
 location_t mpicoll_location(const basic_block bb)
 {
-        gimple_stmt_iterator gsi;
-        gimple *stmt;
-        const char *fname;
-        int i;
+        gimple *stmt = mpicoll_stmt(bb);
 
-        for (gsi = gsi_start_bb(bb); !gsi_end_p(gsi); gsi_next(&gsi)) {
-                stmt = gsi_stmt(gsi);
+        if (stmt == NULL)
+                return UNKNOWN_LOCATION;
 
-                if (is_gimple_call(stmt)) {
-                        fname = IDENTIFIER_POINTER(DECL_NAME(
-                                                     gimple_call_fndecl(stmt)));
+        return gimple_location(stmt);
+}
 
-                        for (i = 0; i < 5; ++i) {
-                                if (strncmp(fname, MPI_COLLECTIVE_NAME[i],
-                                           strlen(MPI_COLLECTIVE_NAME[i])) == 0)
-                                        return gimple_location(stmt);
-                        }
-                }
+/*
+ * Returns the communicator argument of the MPI collective stmt, or NULL_TREE if
+ * it does not take a communicator. The communicator is the first parameter
+ * declared with the MPI_Comm type.
+ */
+tree mpicoll_comm(const gcall *const stmt)
+{
+        tree type = gimple_call_fntype(stmt);
+        tree arg;
+        tree name;
+        unsigned int i = 0U;
+
+        if (type == NULL_TREE)
+                return NULL_TREE;
+
+        for (arg = TYPE_ARG_TYPES(type);
+             arg != NULL_TREE && i < gimple_call_num_args(stmt);
+             arg = TREE_CHAIN(arg), ++i) {
+                name = TYPE_NAME(TREE_VALUE(arg));
+
+                if (name != NULL_TREE && TREE_CODE(name) == TYPE_DECL
+                    && DECL_NAME(name) != NULL_TREE
+                    && id_equal(DECL_NAME(name), "MPI_Comm"))
+                        return gimple_call_arg(stmt, i);
+        }
+
+        return NULL_TREE;
+}
+
+/*
+ * Value of MPI_COMM_WORLD in MPICH and its derivatives, where communicators are
+ * integer handles. In Open MPI, it is the address of ompi_mpi_comm_world.
+ */
+#define MPICOLL_MPICH_COMM_WORLD 0x44000000
+
+/*
+ * Returns true if the MPI collective stmt is called on MPI_COMM_WORLD or does
+ * not take a communicator, false otherwise. Only the MPI_COMM_WORLD constant
+ * itself is recognised, not a variable holding it.
+ *
+ * See mpicoll_comm() for details.
+ */
+bool mpicoll_world_p(const gcall *const stmt)
+{
+        tree comm = mpicoll_comm(stmt);
+
+        if (comm == NULL_TREE)
+                return true;
+
+        STRIP_NOPS(comm);
+
+        if (TREE_CODE(comm) == INTEGER_CST)
+                return tree_fits_shwi_p(comm)
+                       && tree_to_shwi(comm) == MPICOLL_MPICH_COMM_WORLD;
+
+        if (TREE_CODE(comm) != ADDR_EXPR)
+                return false;
+
+        comm = TREE_OPERAND(comm, 0);
+
+        return VAR_P(comm) && DECL_NAME(comm) != NULL_TREE
+               && id_equal(DECL_NAME(comm), "ompi_mpi_comm_world");
+}
+
+/*
+ * Returns the request argument of the MPI collective stmt, or NULL_TREE if it
+ * is blocking. The request is the first parameter declared as a pointer to the
+ * MPI_Request type.
+ */
+tree mpicoll_request(const gcall *const stmt)
+{
+        tree type = gimple_call_fntype(stmt);
+        tree arg;
+        tree name;
+        unsigned int i = 0U;
+
+        if (type == NULL_TREE)
+                return NULL_TREE;
+
+        for (arg = TYPE_ARG_TYPES(type);
+             arg != NULL_TREE && i < gimple_call_num_args(stmt);
+             arg = TREE_CHAIN(arg), ++i) {
+                if (!POINTER_TYPE_P(TREE_VALUE(arg)))
+                        continue;
+
+                name = TYPE_NAME(TREE_TYPE(TREE_VALUE(arg)));
+
+                if (name != NULL_TREE && TREE_CODE(name) == TYPE_DECL
+                    && DECL_NAME(name) != NULL_TREE
+                    && id_equal(DECL_NAME(name), "MPI_Request"))
+                        return gimple_call_arg(stmt, i);
         }
 
-        return UNKNOWN_LOCATION;
+        return NULL_TREE;
 }
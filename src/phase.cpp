@@ -0,0 +1,201 @@
+/*
+ * Functions dealing with the MPI pass phases and counters.
+ * Copyright (C) 2023-2025 Antoni Blanche
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include <gcc-plugin.h>
+#include <tree.h>
+#include <timevar.h>
+#include <diagnostic-core.h>
+#include <pretty-print.h>
+
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/file.h>
+
+#include "phase.h"
+#include "mpicoll.h"
+#include "frontier.h"
+
+/*
+ * Name of each phase, used as timevar name.
+ */
+#define DEF_MPICOLL_PHASE(CODE, NAME) NAME,
+static const char *const PHASE_NAME[] = {
+#include "phases.def"
+};
+#undef DEF_MPICOLL_PHASE
+
+/*
+ * Name of each counter.
+ */
+#define DEF_MPICOLL_COUNTER(CODE, NAME) NAME,
+static const char *const COUNTER_NAME[] = {
+#include "counters.def"
+};
+#undef DEF_MPICOLL_COUNTER
+
+/*
+ * Version of the statistics format, first field of each line.
+ */
+#define PHASE_STATS_VERSION "mpicoll2"
+
+/*
+ * Counters of the current function.
+ */
+long phase_counters[LAST_AND_UNUSED_COUNTER];
+
+/*
+ * Bitmap obstack of the analysis of the current function.
+ */
+bitmap_obstack phase_obstack;
+
+/*
+ * CPU time spent in each phase of the current function, and start time of
+ * each running phase, in microseconds.
+ */
+static long phase_times[LAST_AND_UNUSED_PHASE];
+static long phase_starts[LAST_AND_UNUSED_PHASE];
+
+/*
+ * Starts phase. With -ftime-report, the time spent in phase is reported under
+ * its own timevar.
+ */
+void phase_push(const enum phase phase)
+{
+        phase_starts[phase] = get_run_time();
+
+        /* The timer only exists with -ftime-report */
+        if (g_timer != NULL)
+                g_timer->push_client_item(PHASE_NAME[phase]);
+}
+
+/*
+ * Stops phase, which must be the last started phase.
+ */
+void phase_pop(const enum phase phase)
+{
+        phase_times[phase] += get_run_time() - phase_starts[phase];
+
+        if (g_timer != NULL)
+                g_timer->pop_client_item();
+}
+
+/*
+ * Resets the counters and phase times and initializes the bitmap obstack for a
+ * new function.
+ */
+void phase_reset(void)
+{
+        memset(phase_counters, 0, sizeof(phase_counters));
+        memset(phase_times, 0, sizeof(phase_times));
+        bitmap_obstack_initialize(&phase_obstack);
+}
+
+/*
+ * Releases the bitmap obstack of the current function. All bitmaps allocated
+ * on it must not be used anymore.
+ */
+void phase_release(void)
+{
+        bitmap_obstack_release(&phase_obstack);
+}
+
+/*
+ * Counts the blocks, edges, MPI collectives and groups of fun. MPI collective
+ * codes must be set in basic blocks’s aux field before calling this function.
+ */
+void phase_count_function(const function *const fun, const bitmap groups)
+{
+        basic_block bb;
+        int i;
+
+        PHASE_COUNT(COUNTER_BLOCKS, n_basic_blocks_for_fn(fun));
+        PHASE_COUNT(COUNTER_EDGES, n_edges_for_fn(fun));
+
+        FOR_EACH_BB_FN(bb, fun) {
+                if (bb->aux != (void *) LAST_AND_UNUSED_MPI_COLLECTIVE_CODE)
+                        PHASE_COUNT(COUNTER_COLLECTIVES, 1);
+        }
+
+        FOR_EACH_BITMAP(groups, 0, i)
+                PHASE_COUNT(COUNTER_GROUPS, 1);
+}
+
+/*
+ * Prints the counters of fun as a note.
+ */
+void phase_print(function *const fun)
+{
+        pretty_printer pp;
+        int i;
+
+        for (i = 0; i < LAST_AND_UNUSED_COUNTER; ++i)
+                pp_printf(&pp, "%s%ld %s", i == 0 ? "" : ", ",
+                          phase_counters[i], COUNTER_NAME[i]);
+
+        inform(DECL_SOURCE_LOCATION(fun->decl), "%qs: %s", function_name(fun),
+               pp_formatted_text(&pp));
+}
+
+/*
+ * Appends the statistics of fun to the file at path as a single line. The line
+ * is written at once under an exclusive lock, so that concurrent compilations
+ * can share the file. Counters must be computed by phase_count_function()
+ * before calling this function.
+ */
+void phase_write(function *const fun, const char *const path)
+{
+        pretty_printer pp;
+        const char *line;
+        long total = 0;
+        size_t length;
+        int fd;
+        int i;
+
+        pp_printf(&pp, "%s\t%s\t%s\t%ld\t%ld\t%ld\t%ld", PHASE_STATS_VERSION,
+                  DECL_SOURCE_FILE(fun->decl), function_name(fun),
+                  phase_counters[COUNTER_BLOCKS], phase_counters[COUNTER_EDGES],
+                  phase_counters[COUNTER_COLLECTIVES],
+                  phase_counters[COUNTER_GROUPS]);
+
+        for (i = 0; i < LAST_AND_UNUSED_PHASE; ++i) {
+                pp_printf(&pp, "\t%ld", phase_times[i]);
+                total = total + phase_times[i];
+        }
+
+        pp_printf(&pp, "\t%ld\t%ld\n", total,
+                  (long) obstack_memory_used(&phase_obstack.obstack));
+
+        line = pp_formatted_text(&pp);
+        length = strlen(line);
+
+        fd = open(path, O_WRONLY | O_APPEND | O_CREAT, 0644);
+
+        if (fd == -1) {
+                error("cannot open statistics file %qs: %m", path);
+                return;
+        }
+
+        /* O_APPEND alone does not make writes atomic on network file systems */
+        flock(fd, LOCK_EX);
+
+        if (write(fd, line, length) != (ssize_t) length)
+                error("cannot write statistics file %qs: %m", path);
+
+        flock(fd, LOCK_UN);
+        close(fd);
+}
@@ -19,12 +19,28 @@
 #include <plugin-version.h>
 #include <tree-pass.h>
 #include <context.h>
+#include <tree.h>
+#include <gimple.h>
+#include <gimple-ssa.h>
+#include <tree-into-ssa.h>
 
 #include "print.h"
 #include "cfgviz.h"
 #include "mpicoll.h"
 #include "frontier.h"
 #include "pragma.h"
+#include "arguments.h"
+#include "instrument.h"
+#include "sites.h"
+#include "phase.h"
+#include "budget.h"
+#include "region.h"
+#include "report.h"
+#include "threading.h"
+#include "request.h"
+#include "loops.h"
+#include "cache.h"
+#include "simulate.h"
 
 /*
  * Ensures the plugin is build for GCC 12.2.0.
@@ -47,7 +63,7 @@ static const pass_data mpi_pass_data = {
         GIMPLE_PASS,
         "mpi_pass",
         OPTGROUP_NONE,
-        TV_OPTIMIZE,
+        TV_PLUGIN_RUN,
         0U,
         0U,
         0U,
@@ -90,18 +106,33 @@ public:
         {
                 /* bitmap_head *frontiers; */
                 bitmap_head *cfg, *ranks, *groups, *pdf;
+                bitmap_head exits;
+                int *regions;
+                unsigned int todo = 0U;
+                bool exact, cached;
 
                 /* print_function_name(fun); */
 
+                phase_reset();
+                budget_start();
+
+                phase_push(PHASE_SPLIT);
+
                 while (mpicoll_check(fun))
                         mpicoll_split(fun);
 
+                phase_pop(PHASE_SPLIT);
+
+                phase_push(PHASE_MARK);
                 mpicoll_mark_code(fun);
+                phase_pop(PHASE_MARK);
 
                 /* print_blocks(fun); */
                 /* cfgviz_dump(fun, "cfg"); */
 
+                phase_push(PHASE_POST_DOMINATORS);
                 calculate_dominance_info(CDI_POST_DOMINATORS);
+                phase_pop(PHASE_POST_DOMINATORS);
 
                 /* print_dominators(fun); */
                 /* print_post_dominators(fun); */
@@ -109,32 +140,129 @@ public:
                 /* frontiers = frontier_compute_post_dominance(fun);
                 print_post_dominance_frontiers(fun, frontiers); */
 
-                cfg = frontier_compute_cfg_bis(fun);
+                cfg = ranks = groups = pdf = NULL;
+                regions = NULL;
+                exact = !budget_size_exceeded_p(fun);
+                cached = false;
+                bitmap_initialize(&exits, &phase_obstack);
+
+                /* IPA clones with the same body shape reuse the verdict */
+                if (exact) {
+                        phase_push(PHASE_MARK);
+                        loops_compute_exits(fun, &exits);
+                        cached = cache_lookup(fun, &exits, &groups, &pdf);
+                        phase_pop(PHASE_MARK);
+                }
+
+                if (exact && !cached) {
+                        phase_push(PHASE_CFG_BIS);
+                        cfg = frontier_compute_cfg_bis(fun);
+                        phase_pop(PHASE_CFG_BIS);
+
+                        /* print_cfg(fun, cfg); */
+                        /* cfgviz_dump_cfg(fun, "bis", cfg); */
+
+                        phase_push(PHASE_RANKS);
+                        ranks = mpicoll_ranks(fun, cfg);
+                        phase_pop(PHASE_RANKS);
+
+                        phase_push(PHASE_GROUPS);
+                        groups = frontier_make_groups(fun, ranks);
+                        phase_pop(PHASE_GROUPS);
+
+                        /* pdf = frontier_compute_post_dominance(fun);
+                        print_post_dominance_frontiers(fun, pdf);
+                        free(pdf); */
+
+                        phase_push(PHASE_REGIONS);
+                        regions = region_collapse(fun);
+                        phase_pop(PHASE_REGIONS);
+
+                        phase_push(PHASE_FRONTIERS);
+                        pdf = frontier_compute_groups_iter_post_dominance(
+                              fun, groups, regions);
+                        loops_prune_forks(groups, pdf, &exits);
+                        phase_pop(PHASE_FRONTIERS);
+
+                        if (!budget_time_exceeded_p())
+                                cache_store(fun, groups, pdf);
+                }
+
+                /* An exceeded budget leaves the exact analysis incomplete */
+                if (!cached && (pdf == NULL || budget_time_exceeded_p())) {
+                        free(pdf);
+                        free(groups);
+
+                        phase_push(PHASE_APPROXIMATE);
+                        budget_approximate(fun, &groups, &pdf);
+                        phase_pop(PHASE_APPROXIMATE);
+                }
 
-                /* print_cfg(fun, cfg); */
-                /* cfgviz_dump_cfg(fun, "bis", cfg); */
+                phase_push(PHASE_DIAGNOSTICS);
 
-                ranks = mpicoll_ranks(fun, cfg);
-                groups = frontier_make_groups(fun, ranks);
+                /* Diagnostics of a cached verdict were already emitted */
+                if (!cached) {
+                        if (mpicoll_arguments.simulate != 0)
+                                simulate_groups(fun, groups, pdf);
 
-                /* pdf = frontier_compute_post_dominance(fun);
-                print_post_dominance_frontiers(fun, pdf);
-                free(pdf); */
+                        print_warning(fun, groups, pdf);
+                        request_check(fun);
 
-                /* pdf = frontier_compute_groups_post_dominance(fun, groups); */
-                pdf = frontier_compute_groups_iter_post_dominance(fun, groups);
+                        if (mpicoll_arguments.report != NULL)
+                                report_write(fun, groups, pdf);
 
-                print_warning(fun, groups, pdf);
+                        if (cfgviz_enabled_p())
+                                cfgviz_dump_analysis(fun, cfg, ranks, regions,
+                                                     groups, pdf);
+
+                        if (mpicoll_arguments.thread_level)
+                                threading_check(fun);
+                }
+
+                phase_pop(PHASE_DIAGNOSTICS);
+
+                phase_push(PHASE_INSTRUMENT);
+
+                if (mpicoll_arguments.instrument)
+                        instrument_checks(fun, groups, pdf);
+
+                if (mpicoll_arguments.trace)
+                        instrument_traces(fun);
+
+                /*
+                 * After the "ssa" pass, calls inserted by the instrumentation
+                 * need their virtual operands to be renamed.
+                 */
+                if ((mpicoll_arguments.instrument || mpicoll_arguments.trace)
+                    && gimple_in_ssa_p(fun)) {
+                        mark_virtual_operands_for_renaming(fun);
+                        todo = TODO_update_ssa_only_virtuals;
+                }
+
+                phase_pop(PHASE_INSTRUMENT);
+
+                if (mpicoll_arguments.counters
+                    || mpicoll_arguments.stats != NULL)
+                        phase_count_function(fun, groups);
+
+                if (mpicoll_arguments.counters)
+                        phase_print(fun);
+
+                if (mpicoll_arguments.stats != NULL)
+                        phase_write(fun, mpicoll_arguments.stats);
 
                 free(pdf);
                 free(groups);
+                free(regions);
                 free(ranks);
                 free(cfg);
+                bitmap_clear(&exits);
 
                 free_dominance_info(CDI_POST_DOMINATORS);
                 mpicoll_sanitize(fun);
+                phase_release();
 
-                return 0U;
+                return todo;
         }
 };
 
@@ -152,9 +280,12 @@ int plugin_init(struct plugin_name_args *const plugin_info,
         if (!plugin_default_version_check(version, &gcc_version))
                 return 1;
 
+        if (!arguments_parse(plugin_info))
+                return 1;
+
         mpi_pass_info.pass = &mpi_pass;
-        mpi_pass_info.reference_pass_name = "cfg";
-        mpi_pass_info.ref_pass_instance_number = 0;
+        mpi_pass_info.reference_pass_name = mpicoll_arguments.after;
+        mpi_pass_info.ref_pass_instance_number = 1;
         mpi_pass_info.pos_op = PASS_POS_INSERT_AFTER;
 
         register_callback(plugin_info->base_name, PLUGIN_PASS_MANAGER_SETUP,
@@ -163,6 +294,22 @@ int plugin_init(struct plugin_name_args *const plugin_info,
                           &register_pragma_mpicoll, NULL);
         register_callback(plugin_info->base_name, PLUGIN_FINISH,
                           &undefined_pragma_mpicoll, NULL);
+        register_callback(plugin_info->base_name, PLUGIN_FINISH_UNIT,
+                          &sites_emit, NULL);
+        register_callback(plugin_info->base_name, PLUGIN_START_UNIT,
+                          &report_start_unit, NULL);
+        register_callback(plugin_info->base_name, PLUGIN_FINISH_UNIT,
+                          &report_finish_unit, NULL);
+        register_callback(plugin_info->base_name, PLUGIN_START_UNIT,
+                          &cfgviz_start_unit, NULL);
+        register_callback(plugin_info->base_name, PLUGIN_FINISH_UNIT,
+                          &cfgviz_finish_unit, NULL);
+        register_callback(plugin_info->base_name, PLUGIN_FINISH_UNIT,
+                          &threading_finish_unit, NULL);
+        register_callback(plugin_info->base_name, PLUGIN_FINISH_UNIT,
+                          &cache_finish_unit, NULL);
+
+        instrument_register_roots(plugin_info->base_name);
 
         return 0;
 }
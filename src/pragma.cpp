@@ -20,6 +20,7 @@
 #include <c-family/c-pragma.h>
 #include <tree.h>
 #include <intl.h>
+#include <langhooks.h>
 
 #include <string.h>
 
@@ -35,6 +36,13 @@
  */
 static auto_vec<tree> fnames; /* Global variable, yuck */
 
+/*
+ * DECL_UID of the DECL_ORIGIN of all functions matched by #pragma mpicoll
+ * check, so that their IPA clones are matched too. Trees are not kept, since
+ * this vector is not a garbage collector root.
+ */
+static auto_vec<unsigned int> origins; /* Global variable, yuck */
+
 /*
  * Returns true if fnames contains t, false otherwise.
  */
@@ -148,15 +156,22 @@ void undefined_pragma_mpicoll(void *const event_data ATTRIBUTE_UNUSED,
 }
 
 /*
- * Returns true if fun is tagged by #pragma mpicoll check, false otherwise.
+ * Returns true if fun or the function it is a copy of is tagged by
+ * #pragma mpicoll check, false otherwise.
  */
 bool is_set_pragma_mpicoll(function *const fun)
 {
+        const tree origin = DECL_ORIGIN(fun->decl);
         unsigned int i;
 
+        if (origins.contains(DECL_UID(origin)))
+                return true;
+
         for (i = 0U; i < fnames.length(); ++i) {
-                if (strcmp(FNAME(fnames[i]), function_name(fun)) == 0) {
+                if (strcmp(FNAME(fnames[i]),
+                           lang_hooks.decl_printable_name(origin, 2)) == 0) {
                         fnames.unordered_remove(i);
+                        origins.safe_push(DECL_UID(origin));
                         return true;
                 }
         }
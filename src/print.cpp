@@ -21,9 +21,13 @@
 #include <gimple-iterator.h>
 #include <diagnostic-core.h>
 
+#include <string.h>
+
 #include "print.h"
 #include "mpicoll.h"
 #include "frontier.h"
+#include "arguments.h"
+#include "simulate.h"
 
 /*
  * Prints bb’s direct (post-)dominators (depending on dir).
@@ -86,18 +90,9 @@ void print_called_functions(const basic_block bb)
  */
 void print_mpicoll_name(const gimple *const stmt)
 {
-        const char *fname;
-        int i;
-
-        if (is_gimple_call(stmt)) {
-                fname = IDENTIFIER_POINTER(DECL_NAME(gimple_call_fndecl(stmt)));
-
-                for (i = 0; i < 5; ++i) {
-                        if (strncmp(fname, MPI_COLLECTIVE_NAME[i],
-                                    strlen(MPI_COLLECTIVE_NAME[i])) == 0)
-                                printf("\t\tCall %s()\n", fname);
-                }
-        }
+        if (mpicoll_code(stmt) != LAST_AND_UNUSED_MPI_COLLECTIVE_CODE)
+                printf("\t\tCall %s()\n", IDENTIFIER_POINTER(DECL_NAME(
+                       gimple_call_fndecl(stmt))));
 }
 
 /*
@@ -160,28 +155,277 @@ void print_cfg(const function *const fun, const bitmap cfg)
 }
 
 /*
- * Prints a warning if a possible MPI deadlock is detected in fun. A deadlock
- * might be possible if pdf is set for at least 1 basic block in fun.
+ * Maximum number of notes listing the MPI collectives, or the forks, of a
+ * warning. Further ones are counted in a last note.
  */
-void print_warning(function *const fun, const bitmap groups, const bitmap pdf)
+#define PRINT_MAX_NOTES 8
+
+/*
+ * A finding reported in the translation unit: its hash, and its sites followed
+ * by its forks in print_seen from start.
+ */
+struct print_record {
+        hashval_t hash;
+        unsigned int start;
+        unsigned int nb_sites;
+        unsigned int nb_forks;
+};
+
+/*
+ * Findings reported in the translation unit, in order.
+ */
+static auto_vec<struct print_record> print_records;
+
+/*
+ * Sites then forks of each finding of print_records, one after the other.
+ */
+static auto_vec<location_t> print_seen;
+
+/*
+ * Hashes of the findings of print_records.
+ */
+static hash_set<int_hash<hashval_t, 0U, 1U> > print_findings;
+
+/*
+ * Number of warnings emitted in the translation unit, and whether their cap was
+ * reached.
+ */
+static int print_unit_warnings = 0;
+static bool print_unit_capped = false;
+
+/*
+ * Compares locations by file, line and column.
+ */
+static int print_compare_locations(const void *const a, const void *const b)
+{
+        expanded_location x = expand_location(*(const location_t *) a);
+        expanded_location y = expand_location(*(const location_t *) b);
+        int res = strcmp(x.file != NULL ? x.file : "",
+                         y.file != NULL ? y.file : "");
+
+        if (res != 0)
+                return res;
+
+        if (x.line != y.line)
+                return x.line < y.line ? -1 : 1;
+
+        return (x.column > y.column) - (x.column < y.column);
+}
+
+/*
+ * Puts in locations the distinct source locations of the MPI collectives in
+ * blocks if collectives is true, or of their last statement otherwise. Blocks
+ * duplicated from the same source, such as peeled loop iterations, share
+ * their location.
+ */
+static void print_locations(function *const fun, const bitmap blocks,
+                            const bool collectives,
+                            auto_vec<location_t> &locations)
 {
         basic_block bb;
+        gimple *stmt;
         bitmap_iterator bi;
-        unsigned int bb_index;
+        unsigned int bb_index, i, j;
+        location_t loc;
+
+        locations.truncate(0);
+
+        EXECUTE_IF_SET_IN_BITMAP(blocks, 0, bb_index, bi) {
+                bb = BASIC_BLOCK_FOR_FN(fun, bb_index);
+                stmt = collectives ? mpicoll_stmt(bb)
+                                   : gsi_stmt(gsi_last_bb(bb));
+                loc = stmt != NULL ? gimple_location(stmt) : UNKNOWN_LOCATION;
+
+                if (loc != UNKNOWN_LOCATION)
+                        locations.safe_push(loc);
+        }
+
+        locations.qsort(print_compare_locations);
+
+        for (i = 0U, j = 0U; i < locations.length(); ++i) {
+                if (j == 0U || print_compare_locations(&(locations[i]),
+                                                       &(locations[j - 1U]))
+                               != 0)
+                        locations[j++] = locations[i];
+        }
+
+        locations.truncate(j);
+}
+
+/*
+ * Returns true if the locations in print_seen from start are those in
+ * locations, false otherwise.
+ */
+static bool print_same_locations(const unsigned int start,
+                                 const auto_vec<location_t> &locations)
+{
+        unsigned int i;
+
+        for (i = 0U; i < locations.length(); ++i) {
+                if (print_compare_locations(&(print_seen[start + i]),
+                                            &(locations[i])) != 0)
+                        return false;
+        }
+
+        return true;
+}
+
+/*
+ * Returns true if no finding with the same sites and forks was reported in
+ * the translation unit, and records it, false otherwise. Findings are looked
+ * up by hash, and their locations are compared when hashes are equal.
+ */
+static bool print_new_finding(const auto_vec<location_t> &sites,
+                              const auto_vec<location_t> &forks)
+{
+        struct print_record record;
+        inchash::hash hash;
+        expanded_location x;
+        hashval_t res;
+        unsigned int i;
+
+        for (i = 0U; i < sites.length() + forks.length(); ++i) {
+                x = expand_location(i < sites.length()
+                                    ? sites[i] : forks[i - sites.length()]);
+
+                if (x.file != NULL)
+                        hash.add(x.file, strlen(x.file));
+
+                hash.add_int(x.line);
+                hash.add_int(x.column);
+                hash.add_int(i < sites.length());
+        }
+
+        /* 0 and 1 mark empty and deleted slots */
+        res = hash.end();
+        res = res > 1U ? res : res + 2U;
+
+        if (print_findings.add(res)) {
+                for (i = 0U; i < print_records.length(); ++i) {
+                        record = print_records[i];
+
+                        if (record.hash == res
+                            && record.nb_sites == sites.length()
+                            && record.nb_forks == forks.length()
+                            && print_same_locations(record.start, sites)
+                            && print_same_locations(record.start
+                                                    + record.nb_sites, forks))
+                                return false;
+                }
+        }
+
+        record.hash = res;
+        record.start = print_seen.length();
+        record.nb_sites = sites.length();
+        record.nb_forks = forks.length();
+        print_records.safe_push(record);
+        print_seen.safe_splice(sites);
+        print_seen.safe_splice(forks);
+
+        return true;
+}
+
+/*
+ * Prints a warning at the first MPI collective site of group in fun, with notes
+ * at the other sites, at the forks, and at the mismatch found by the
+ * simulation of ranks, if any. Returns true if the warning was emitted, false
+ * otherwise.
+ *
+ * See simulate_explain() for details.
+ */
+static bool print_finding(function *const fun, const int group,
+                          const char *const name,
+                          const auto_vec<location_t> &sites,
+                          const auto_vec<location_t> &forks)
+{
+        auto_diagnostic_group d;
+        unsigned int i;
+
+        if (!warning_at(sites[0], 0, "possible MPI deadlock: %qs may not be "
+                        "called by all ranks", name))
+                return false;
+
+        for (i = 1U; i < sites.length() && i <= PRINT_MAX_NOTES; ++i)
+                inform(sites[i], "%qs also called here", name);
+
+        if (sites.length() > PRINT_MAX_NOTES + 1U)
+                inform_n(sites[0], sites.length() - PRINT_MAX_NOTES - 1U,
+                         "and %u other call", "and %u other calls",
+                         sites.length() - PRINT_MAX_NOTES - 1U);
+
+        for (i = 0U; i < forks.length() && i < PRINT_MAX_NOTES; ++i)
+                inform(forks[i], "fork here");
+
+        if (forks.length() > PRINT_MAX_NOTES)
+                inform_n(forks[0], forks.length() - PRINT_MAX_NOTES,
+                         "and %u other fork", "and %u other forks",
+                         forks.length() - PRINT_MAX_NOTES);
+
+        simulate_explain(fun, group);
+
+        return true;
+}
+
+/*
+ * Prints a warning if a possible MPI deadlock is detected in fun. A deadlock
+ * might be possible if pdf is set for at least 1 basic block in fun. There is
+ * one warning per group, with notes at its MPI collectives and forks, and
+ * findings already reported in the translation unit are skipped. Warnings are
+ * capped per function and per translation unit by the max-warnings and
+ * max-unit-warnings plugin arguments. Groups proven safe by the simulation of
+ * ranks are skipped, and warnings get notes at its mismatch, if any.
+ *
+ * See simulate_groups() for details.
+ */
+void print_warning(function *const fun, const bitmap groups, const bitmap pdf)
+{
+        auto_vec<location_t> sites, forks;
+        const int max = mpicoll_arguments.max_warnings;
+        const int max_unit = mpicoll_arguments.max_unit_warnings;
+        int warnings = 0, suppressed = 0;
+        gimple *stmt;
         int i;
 
         FOR_EACH_BITMAP(groups, 0, i) {
-                if (!bitmap_empty_p(&(pdf[i]))) {
-                        EXECUTE_IF_SET_IN_BITMAP(&(groups[i]), 0, bb_index, bi) {
-                                bb = BASIC_BLOCK_FOR_FN(fun, bb_index);
-                                warning_at(mpicoll_location(bb), 0,
-                                           "possible MPI deadlock");
-                        }
-
-                        EXECUTE_IF_SET_IN_BITMAP(&(pdf[i]), 0, bb_index, bi)
-                                inform(gimple_location(gsi_stmt(gsi_last_bb(
-                                       BASIC_BLOCK_FOR_FN(fun, bb_index)))),
-                                       "fork here");
+                if (bitmap_empty_p(&(pdf[i])) || simulate_proven_p(fun, i))
+                        continue;
+
+                print_locations(fun, &(groups[i]), true, sites);
+                print_locations(fun, &(pdf[i]), false, forks);
+
+                if (sites.is_empty() || !print_new_finding(sites, forks))
+                        continue;
+
+                if ((max != 0 && warnings >= max)
+                    || (max_unit != 0 && print_unit_warnings >= max_unit)) {
+                        suppressed = suppressed + 1;
+                        continue;
                 }
+
+                stmt = mpicoll_stmt(BASIC_BLOCK_FOR_FN(fun,
+                                    bitmap_first_set_bit(&(groups[i]))));
+
+                if (!print_finding(fun, i, IDENTIFIER_POINTER(DECL_NAME(
+                                   gimple_call_fndecl(stmt))), sites, forks))
+                        continue;
+
+                warnings = warnings + 1;
+                print_unit_warnings = print_unit_warnings + 1;
         }
+
+        if (suppressed == 0)
+                return;
+
+        if (max_unit == 0 || print_unit_warnings < max_unit)
+                inform_n(DECL_SOURCE_LOCATION(fun->decl), suppressed,
+                         "%d other possible MPI deadlock in %qs not reported",
+                         "%d other possible MPI deadlocks in %qs not reported",
+                         suppressed, function_name(fun));
+        else if (!print_unit_capped)
+                inform(DECL_SOURCE_LOCATION(fun->decl), "other possible MPI "
+                       "deadlocks in this file not reported");
+
+        print_unit_capped = print_unit_capped
+                            || (max_unit != 0
+                                && print_unit_warnings >= max_unit);
 }
@@ -0,0 +1,162 @@
+/*
+ * Functions dealing with collective-free branch regions.
+ * Copyright (C) 2023-2025 Antoni Blanche
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include <gcc-plugin.h>
+#include <tree.h>
+#include <gimple.h>
+
+#include "region.h"
+#include "mpicoll.h"
+#include "phase.h"
+
+/*
+ * Number of basic blocks visited per basic block of the function while looking
+ * for regions. Past it, the remaining regions are not collapsed.
+ */
+#define REGION_WORK_FACTOR 4
+
+/*
+ * Puts in region the basic blocks reachable from entry without going through
+ * exit. Returns true if they form a region without MPI collective, that is if
+ * entry dominates all of them and none contains a MPI collective, false
+ * otherwise. The number of basic blocks visited is subtracted from work, and
+ * the search fails once work is exhausted.
+ */
+static bool region_find(const basic_block entry, const basic_block exit,
+                        auto_vec<basic_block> &region, bitmap visited,
+                        long &work)
+{
+        basic_block bb;
+        edge e;
+        edge_iterator ei;
+        unsigned int i;
+
+        region.truncate(0);
+        bitmap_clear(visited);
+
+        region.safe_push(entry);
+        bitmap_set_bit(visited, entry->index);
+
+        for (i = 0U; i < region.length(); ++i) {
+                bb = region[i];
+                work = work - 1;
+                PHASE_COUNT(COUNTER_BITMAP_OPS, EDGE_COUNT(bb->succs));
+
+                /* NULL aux is MPI_INIT */
+                if (work < 0
+                    || bb->aux != (void *) LAST_AND_UNUSED_MPI_COLLECTIVE_CODE
+                    || (bb != entry
+                        && !dominated_by_p(CDI_DOMINATORS, bb, entry)))
+                        return false;
+
+                FOR_EACH_EDGE(e, ei, bb->succs) {
+                        if (e->dest != exit
+                            && bitmap_set_bit(visited, e->dest->index))
+                                region.safe_push(e->dest);
+                }
+        }
+
+        return true;
+}
+
+/*
+ * Returns the representative of the basic block with index bb_index, and makes
+ * all the basic blocks on the way point to it.
+ */
+static int region_representative(int *const rep, const int bb_index)
+{
+        int res, i, next;
+
+        for (res = bb_index; rep[res] != res; res = rep[res])
+                ;
+
+        for (i = bb_index; rep[i] != res; i = next) {
+                next = rep[i];
+                rep[i] = res;
+        }
+
+        return res;
+}
+
+/*
+ * Collapses the regions of fun, from a branch to its immediate post-dominator,
+ * that contain no MPI collective. Returns the representative of each basic
+ * block, indexed by basic block index: the exit block of the outermost
+ * collapsed region containing the basic block, or the basic block itself if
+ * no collapsed region contains it. Representatives are never collapsed. MPI
+ * collective codes must be set in basic blocks’s aux field and the
+ * post-dominance information must be computed before calling this function.
+ *
+ * A region is entered at a branch, dominating all of its basic blocks, and
+ * left at the immediate post-dominator of the branch. Since none of its basic
+ * blocks holds a MPI collective, they are post-dominated by the same groups as
+ * the exit, and none of them is in a post-dominance frontier. Branches are
+ * visited in dominator tree preorder so that the outermost regions are found
+ * first.
+ *
+ * See mpicoll_mark_code() and calculate_dominance_info() for details.
+ */
+int *region_collapse(const function *const fun)
+{
+        int *rep = XNEWVEC(int, last_basic_block_for_fn(fun));
+        auto_vec<basic_block> stack, region;
+        basic_block bb, exit, son;
+        bitmap_head visited;
+        long work;
+        unsigned int i;
+
+        for (i = 0U; i < (unsigned int) last_basic_block_for_fn(fun); ++i)
+                rep[i] = i;
+
+        calculate_dominance_info(CDI_DOMINATORS);
+        bitmap_initialize(&visited, &phase_obstack);
+
+        work = (long) REGION_WORK_FACTOR * n_basic_blocks_for_fn(fun);
+        stack.safe_push(ENTRY_BLOCK_PTR_FOR_FN(fun));
+
+        while (!stack.is_empty() && work > 0) {
+                bb = stack.pop();
+
+                for (son = first_dom_son(CDI_DOMINATORS, bb); son != NULL;
+                     son = next_dom_son(CDI_DOMINATORS, son))
+                        stack.safe_push(son);
+
+                if (rep[bb->index] != bb->index
+                    || EDGE_COUNT(bb->succs) < 2)
+                        continue;
+
+                exit = get_immediate_dominator(CDI_POST_DOMINATORS, bb);
+
+                if (exit == NULL || exit == EXIT_BLOCK_PTR_FOR_FN(fun)
+                    || !region_find(bb, exit, region, &visited, work))
+                        continue;
+
+                for (i = 0U; i < region.length(); ++i)
+                        rep[region[i]->index] = exit->index;
+
+                PHASE_COUNT(COUNTER_COLLAPSED, region.length());
+        }
+
+        /* The exit of a region may lie in a region found later */
+        for (i = 0U; i < (unsigned int) last_basic_block_for_fn(fun); ++i)
+                region_representative(rep, i);
+
+        bitmap_clear(&visited);
+        free_dominance_info(CDI_DOMINATORS);
+
+        return rep;
+}
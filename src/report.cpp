@@ -0,0 +1,303 @@
+/*
+ * Functions dealing with machine-readable reports.
+ * Copyright (C) 2023-2025 Antoni Blanche
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include <gcc-plugin.h>
+#include <tree.h>
+#include <gimple.h>
+#include <gimple-iterator.h>
+#include <diagnostic-core.h>
+#include <pretty-print.h>
+#include <tree-pretty-print.h>
+
+#include <stdio.h>
+
+#include "report.h"
+#include "arguments.h"
+#include "mpicoll.h"
+#include "frontier.h"
+#include "simulate.h"
+
+/*
+ * Rule of the findings, and key of their fingerprint.
+ */
+#define REPORT_RULE "mpicoll/possible-deadlock"
+#define REPORT_FINGERPRINT "mpicollFinding/v1"
+
+/*
+ * Report file of the translation unit, or NULL.
+ */
+static FILE *report_file = NULL;
+static char *report_path = NULL;
+
+/*
+ * Returns hash updated with string, using 64-bit FNV-1a.
+ */
+static unsigned long long report_hash(unsigned long long hash,
+                                      const char *const string)
+{
+        const char *c;
+
+        for (c = string; *c != '\0'; ++c)
+                hash = (hash ^ (unsigned char) *c) * 1099511628211ULL;
+
+        return hash;
+}
+
+/*
+ * Returns the path of the file of the translation unit in dir, named after the
+ * main input file with suffix. A hash of the absolute path of the main input
+ * file is added so that homonyms in different directories do not clash.
+ */
+char *report_unit_path(const char *const dir, const char *const suffix)
+{
+        char *input, *res;
+        char hash[17];
+
+        if (IS_ABSOLUTE_PATH(main_input_filename))
+                input = xstrdup(main_input_filename);
+        else
+                input = concat(getpwd(), "/", main_input_filename, NULL);
+
+        snprintf(hash, sizeof(hash), "%08llx",
+                 report_hash(14695981039346656037ULL, input) & 0xffffffffULL);
+        res = concat(dir, "/", lbasename(main_input_filename), ".", hash,
+                     suffix, NULL);
+        free(input);
+
+        return res;
+}
+
+/*
+ * Creates the report file of the translation unit in the directory given by the
+ * report plugin argument, replacing the findings of a previous compilation.
+ */
+void report_start_unit(void *const event_data ATTRIBUTE_UNUSED,
+                       void *const data ATTRIBUTE_UNUSED)
+{
+        if (mpicoll_arguments.report == NULL || main_input_filename == NULL)
+                return;
+
+        report_path = report_unit_path(mpicoll_arguments.report,
+                                       REPORT_SUFFIX);
+        report_file = fopen(report_path, "w");
+
+        if (report_file == NULL)
+                error("cannot open report file %qs: %m", report_path);
+}
+
+/*
+ * Closes the report file of the translation unit.
+ */
+void report_finish_unit(void *const event_data ATTRIBUTE_UNUSED,
+                        void *const data ATTRIBUTE_UNUSED)
+{
+        if (report_file != NULL && fclose(report_file) != 0)
+                error("cannot write report file %qs: %m", report_path);
+
+        report_file = NULL;
+        free(report_path);
+        report_path = NULL;
+}
+
+/*
+ * Prints string to pp as a JSON string.
+ */
+static void report_string(pretty_printer *const pp, const char *const string)
+{
+        char escape[8];
+        const char *c;
+
+        pp_character(pp, '"');
+
+        for (c = string != NULL ? string : ""; *c != '\0'; ++c) {
+                switch (*c) {
+                case '"':
+                        pp_string(pp, "\\\"");
+                        break;
+                case '\\':
+                        pp_string(pp, "\\\\");
+                        break;
+                case '\n':
+                        pp_string(pp, "\\n");
+                        break;
+                case '\t':
+                        pp_string(pp, "\\t");
+                        break;
+                default:
+                        if ((unsigned char) *c < 0x20U) {
+                                snprintf(escape, sizeof(escape), "\\u%04x",
+                                         (unsigned char) *c);
+                                pp_string(pp, escape);
+                        } else {
+                                pp_character(pp, *c);
+                        }
+                }
+        }
+
+        pp_character(pp, '"');
+}
+
+/*
+ * Prints the SARIF physical location of loc to pp, and updates hash with it.
+ */
+static void report_location(pretty_printer *const pp, const location_t loc,
+                            unsigned long long *const hash)
+{
+        expanded_location x = expand_location(loc);
+        char position[32];
+
+        pp_string(pp, "\"physicalLocation\":{\"artifactLocation\":{\"uri\":");
+        report_string(pp, x.file);
+        pp_character(pp, '}');
+
+        if (x.line > 0) {
+                pp_printf(pp, ",\"region\":{\"startLine\":%d", x.line);
+
+                if (x.column > 0)
+                        pp_printf(pp, ",\"startColumn\":%d", x.column);
+
+                pp_character(pp, '}');
+        }
+
+        pp_character(pp, '}');
+
+        snprintf(position, sizeof(position), ":%d:%d;", x.line, x.column);
+        *hash = report_hash(report_hash(*hash, x.file != NULL ? x.file : ""),
+                            position);
+}
+
+/*
+ * Prints the SARIF location of the MPI collective in bb to pp, and updates hash
+ * with it.
+ */
+static void report_collective(pretty_printer *const pp, function *const fun,
+                              const basic_block bb,
+                              unsigned long long *const hash)
+{
+        gimple *stmt = mpicoll_stmt(bb);
+        const char *name;
+        char *comm = NULL;
+        tree arg;
+
+        name = IDENTIFIER_POINTER(DECL_NAME(gimple_call_fndecl(stmt)));
+        arg = mpicoll_comm(as_a<gcall *>(stmt));
+
+        if (arg != NULL_TREE)
+                comm = print_generic_expr_to_str(arg);
+
+        pp_character(pp, '{');
+        report_location(pp, gimple_location(stmt), hash);
+        pp_string(pp, ",\"logicalLocations\":[{\"fullyQualifiedName\":");
+        report_string(pp, function_name(fun));
+        pp_string(pp, ",\"kind\":\"function\"}],\"message\":{\"text\":");
+        report_string(pp, name);
+        pp_string(pp, "},\"properties\":{\"collective\":");
+        report_string(pp, name);
+
+        if (comm != NULL) {
+                pp_string(pp, ",\"communicator\":");
+                report_string(pp, comm);
+        }
+
+        pp_string(pp, "}}");
+
+        free(comm);
+}
+
+/*
+ * Writes a finding to the report file for each group in fun with a non-empty
+ * post-dominance frontier. Each finding is a line holding a SARIF result, whose
+ * locations are the MPI collectives of the group and whose related locations
+ * are the forks. Its fingerprint only depends on the function and on these
+ * locations, so that the findings of a function defined in a header are the
+ * same in every translation unit including it.
+ */
+void report_write(function *const fun, const bitmap groups, const bitmap pdf)
+{
+        unsigned long long hash;
+        pretty_printer pp;
+        basic_block bb;
+        gimple *stmt;
+        bitmap_iterator bi;
+        unsigned int bb_index;
+        char fingerprint[17];
+        int i, n;
+
+        if (report_file == NULL)
+                return;
+
+        FOR_EACH_BITMAP(groups, 0, i) {
+                if (bitmap_empty_p(&(pdf[i])) || simulate_proven_p(fun, i))
+                        continue;
+
+                hash = report_hash(14695981039346656037ULL,
+                                   function_name(fun));
+
+                pp_string(&pp, "{\"ruleId\":\"" REPORT_RULE "\","
+                          "\"level\":\"warning\",\"message\":{\"text\":"
+                          "\"possible MPI deadlock\"},\"locations\":[");
+                n = 0;
+
+                EXECUTE_IF_SET_IN_BITMAP(&(groups[i]), 0, bb_index, bi) {
+                        bb = BASIC_BLOCK_FOR_FN(fun, bb_index);
+
+                        if (mpicoll_stmt(bb) == NULL)
+                                continue;
+
+                        if (n != 0)
+                                pp_character(&pp, ',');
+
+                        report_collective(&pp, fun, bb, &hash);
+                        n = n + 1;
+                }
+
+                pp_string(&pp, "],\"relatedLocations\":[");
+                n = 0;
+
+                EXECUTE_IF_SET_IN_BITMAP(&(pdf[i]), 0, bb_index, bi) {
+                        bb = BASIC_BLOCK_FOR_FN(fun, bb_index);
+                        stmt = gsi_stmt(gsi_last_bb(bb));
+
+                        if (stmt == NULL)
+                                continue;
+
+                        if (n != 0)
+                                pp_character(&pp, ',');
+
+                        pp_printf(&pp, "{\"id\":%d,", n);
+                        report_location(&pp, gimple_location(stmt), &hash);
+                        pp_string(&pp, ",\"message\":{\"text\":\"fork here\"}}");
+                        n = n + 1;
+                }
+
+                snprintf(fingerprint, sizeof(fingerprint), "%016llx", hash);
+                pp_string(&pp, "],\"partialFingerprints\":{\""
+                          REPORT_FINGERPRINT "\":");
+                report_string(&pp, fingerprint);
+                pp_string(&pp, "},\"properties\":{\"translationUnit\":");
+                report_string(&pp, main_input_filename);
+                pp_string(&pp, ",\"function\":");
+                report_string(&pp, function_name(fun));
+                pp_printf(&pp, ",\"group\":%d}}\n", i);
+
+                fputs(pp_formatted_text(&pp), report_file);
+                pp_clear_output_area(&pp);
+        }
+
+        /* Findings stay in the file if the compiler crashes later */
+        fflush(report_file);
+}
@@ -0,0 +1,446 @@
+/*
+ * Functions dealing with nonblocking MPI collective requests.
+ * Copyright (C) 2023-2025 Antoni Blanche
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include <gcc-plugin.h>
+#include <tree.h>
+#include <gimple.h>
+#include <gimple-iterator.h>
+#include <diagnostic-core.h>
+
+#include "request.h"
+#include "mpicoll.h"
+#include "frontier.h"
+#include "taint.h"
+#include "phase.h"
+
+/*
+ * MPI functions completing requests, and the index of their request or array
+ * of requests argument. Functions completing only some of their requests, such
+ * as MPI_Waitany, are assumed to be called until all of them are completed.
+ */
+static const struct {
+        const char *name;
+        unsigned int arg;
+} REQUEST_COMPLETIONS[] = {
+        { "MPI_Wait", 0U },
+        { "MPI_Test", 0U },
+        { "MPI_Request_free", 0U },
+        { "MPI_Waitall", 1U },
+        { "MPI_Testall", 1U },
+        { "MPI_Waitany", 1U },
+        { "MPI_Testany", 1U },
+        { "MPI_Waitsome", 1U },
+        { "MPI_Testsome", 1U },
+};
+
+#define NB_COMPLETIONS \
+        (sizeof(REQUEST_COMPLETIONS) / sizeof(REQUEST_COMPLETIONS[0]))
+
+/*
+ * Requests of a function, one per local variable holding them.
+ */
+struct request {
+        tree decl;                      /* Local variable or array */
+        bitmap_head sites;              /* Basic blocks initiating it */
+        bitmap_head completions;        /* Basic blocks completing it */
+        bool escaped;                   /* Used outside of MPI calls */
+};
+
+/*
+ * Returns the local variable of fun holding the request pointed to by arg, or
+ * NULL_TREE if it is not the address of a local variable or of one of its
+ * elements.
+ */
+static tree request_decl(const function *const fun, const tree arg)
+{
+        tree base;
+
+        if (TREE_CODE(arg) != ADDR_EXPR)
+                return NULL_TREE;
+
+        base = get_base_address(TREE_OPERAND(arg, 0));
+
+        if (base == NULL_TREE || !VAR_P(base)
+            || !auto_var_in_fn_p(base, fun->decl))
+                return NULL_TREE;
+
+        return base;
+}
+
+/*
+ * Returns the index in requests of the request held by decl, or -1 if there
+ * is none.
+ */
+static int request_find(const auto_vec<request> &requests, const tree decl)
+{
+        unsigned int i;
+
+        for (i = 0U; i < requests.length(); ++i) {
+                if (requests[i].decl == decl)
+                        return i;
+        }
+
+        return -1;
+}
+
+/*
+ * Returns the request argument of stmt if it is a call to a MPI function
+ * completing requests, or NULL_TREE otherwise.
+ */
+static tree request_completion(const gimple *const stmt)
+{
+        tree fndecl;
+        unsigned int i;
+
+        if (!is_gimple_call(stmt))
+                return NULL_TREE;
+
+        fndecl = gimple_call_fndecl(stmt);
+
+        if (fndecl == NULL_TREE || DECL_NAME(fndecl) == NULL_TREE)
+                return NULL_TREE;
+
+        for (i = 0U; i < NB_COMPLETIONS; ++i) {
+                if (id_equal(DECL_NAME(fndecl), REQUEST_COMPLETIONS[i].name)
+                    && gimple_call_num_args(stmt) > REQUEST_COMPLETIONS[i].arg)
+                        return gimple_call_arg(stmt,
+                                               REQUEST_COMPLETIONS[i].arg);
+        }
+
+        return NULL_TREE;
+}
+
+/*
+ * Sets escaped for the requests whose variable is read by stmt. A request
+ * copied, compared, or whose address is taken may be completed elsewhere.
+ */
+static void request_escape(auto_vec<request> &requests,
+                           const gimple *const stmt)
+{
+        tree op, base;
+        unsigned int i;
+        int index;
+
+        for (i = 0U; i < gimple_num_ops(stmt); ++i) {
+                op = gimple_op(stmt, i);
+
+                /* Storing a request, such as MPI_REQUEST_NULL, is not a use */
+                if (op == NULL_TREE || (i == 0U && is_gimple_assign(stmt)))
+                        continue;
+
+                if (TREE_CODE(op) == ADDR_EXPR)
+                        op = TREE_OPERAND(op, 0);
+
+                base = get_base_address(op);
+
+                if (base == NULL_TREE || !DECL_P(base))
+                        continue;
+
+                index = request_find(requests, base);
+
+                if (index >= 0)
+                        requests[index].escaped = true;
+        }
+}
+
+/*
+ * Collects the requests of fun: the variables passed to its nonblocking MPI
+ * collectives and the basic blocks initiating and completing them. Returns the
+ * number of nonblocking MPI collectives, tracked or not.
+ */
+static int request_collect(function *const fun, auto_vec<request> &requests)
+{
+        gimple_stmt_iterator gsi;
+        request r;
+        gimple *stmt;
+        basic_block bb;
+        tree arg, decl;
+        int index, res = 0;
+
+        FOR_EACH_BB_FN(bb, fun) {
+                if (bb->aux == (void *) LAST_AND_UNUSED_MPI_COLLECTIVE_CODE
+                    || bb->aux == (void *) MPI_INIT)
+                        continue;
+
+                arg = mpicoll_request(as_a<gcall *>(mpicoll_stmt(bb)));
+
+                if (arg == NULL_TREE)
+                        continue;
+
+                res = res + 1;
+                decl = request_decl(fun, arg);
+
+                if (decl == NULL_TREE)
+                        continue;
+
+                index = request_find(requests, decl);
+
+                if (index < 0) {
+                        r.decl = decl;
+                        r.escaped = false;
+                        requests.safe_push(r);
+                        index = requests.length() - 1;
+                        bitmap_initialize(&(requests[index].sites),
+                                          &phase_obstack);
+                        bitmap_initialize(&(requests[index].completions),
+                                          &phase_obstack);
+                }
+
+                bitmap_set_bit(&(requests[index].sites), bb->index);
+        }
+
+        if (requests.is_empty())
+                return res;
+
+        FOR_EACH_BB_FN(bb, fun) {
+                for (gsi = gsi_start_bb(bb); !gsi_end_p(gsi); gsi_next(&gsi)) {
+                        stmt = gsi_stmt(gsi);
+
+                        if (is_gimple_call(stmt)
+                            && mpicoll_code(stmt)
+                               != LAST_AND_UNUSED_MPI_COLLECTIVE_CODE
+                            && mpicoll_request(as_a<gcall *>(stmt))
+                               != NULL_TREE)
+                                continue;
+
+                        arg = request_completion(stmt);
+
+                        if (arg == NULL_TREE) {
+                                request_escape(requests, stmt);
+                                continue;
+                        }
+
+                        index = request_find(requests,
+                                             request_decl(fun, arg));
+
+                        if (index >= 0)
+                                bitmap_set_bit(&(requests[index].completions),
+                                               bb->index);
+                }
+        }
+
+        return res;
+}
+
+/*
+ * Returns true if the request initiated by the nonblocking MPI collective in
+ * bb is completed later in bb, false otherwise.
+ */
+static bool request_completed_in_block(const function *const fun,
+                                       const basic_block bb, const tree decl)
+{
+        gimple_stmt_iterator gsi = gsi_for_stmt(mpicoll_stmt(bb));
+        tree arg;
+
+        for (gsi_next(&gsi); !gsi_end_p(gsi); gsi_next(&gsi)) {
+                arg = request_completion(gsi_stmt(gsi));
+
+                if (arg != NULL_TREE && request_decl(fun, arg) == decl)
+                        return true;
+        }
+
+        return false;
+}
+
+/*
+ * Puts in reached the basic blocks reachable from the initiations of r without
+ * completing it. Blocks completing r are reached but not gone through.
+ */
+static void request_reach(const function *const fun, const request &r,
+                          bitmap reached)
+{
+        auto_vec<basic_block> stack;
+        bitmap_iterator bi;
+        unsigned int bb_index;
+        basic_block bb;
+        edge e;
+        edge_iterator ei;
+
+        EXECUTE_IF_SET_IN_BITMAP(&(r.sites), 0, bb_index, bi) {
+                bb = BASIC_BLOCK_FOR_FN(fun, bb_index);
+
+                if (!request_completed_in_block(fun, bb, r.decl))
+                        stack.safe_push(bb);
+        }
+
+        while (!stack.is_empty()) {
+                bb = stack.pop();
+                PHASE_COUNT(COUNTER_BITMAP_OPS, EDGE_COUNT(bb->succs));
+
+                FOR_EACH_EDGE(e, ei, bb->succs) {
+                        if (bitmap_set_bit(reached, e->dest->index)
+                            && !bitmap_bit_p(&(r.completions),
+                                             e->dest->index))
+                                stack.safe_push(e->dest);
+                }
+        }
+}
+
+/*
+ * Prints a warning at the first initiation of r, with notes at its
+ * completions and at the forks in forks.
+ */
+static void request_warn(const function *const fun, const request &r,
+                         const auto_vec<basic_block> &forks)
+{
+        auto_diagnostic_group d;
+        bitmap_iterator bi;
+        unsigned int bb_index, i;
+        gimple_stmt_iterator gsi;
+        gimple *site;
+        tree arg;
+        bool warned;
+
+        site = mpicoll_stmt(BASIC_BLOCK_FOR_FN(fun,
+                            bitmap_first_set_bit(&(r.sites))));
+
+        if (bitmap_empty_p(&(r.completions)))
+                warned = warning_at(gimple_location(site), 0, "request of %qs "
+                                    "is never completed", IDENTIFIER_POINTER(
+                                    DECL_NAME(gimple_call_fndecl(site))));
+        else if (!forks.is_empty())
+                warned = warning_at(gimple_location(site), 0, "possible MPI "
+                                    "deadlock: request of %qs may not be "
+                                    "completed by all ranks",
+                                    IDENTIFIER_POINTER(DECL_NAME(
+                                    gimple_call_fndecl(site))));
+        else
+                warned = warning_at(gimple_location(site), 0, "request of %qs "
+                                    "may not be completed", IDENTIFIER_POINTER(
+                                    DECL_NAME(gimple_call_fndecl(site))));
+
+        if (!warned)
+                return;
+
+        EXECUTE_IF_SET_IN_BITMAP(&(r.completions), 0, bb_index, bi) {
+                for (gsi = gsi_start_bb(BASIC_BLOCK_FOR_FN(fun, bb_index));
+                     !gsi_end_p(gsi); gsi_next(&gsi)) {
+                        arg = request_completion(gsi_stmt(gsi));
+
+                        if (arg != NULL_TREE
+                            && request_decl(fun, arg) == r.decl)
+                                inform(gimple_location(gsi_stmt(gsi)),
+                                       "completed here");
+                }
+        }
+
+        for (i = 0U; i < forks.length(); ++i)
+                inform(gimple_location(last_stmt(forks[i])), "fork here");
+}
+
+/*
+ * Checks that the request of each nonblocking MPI collective in fun is
+ * completed by all ranks, and prints a warning otherwise. Requests are paired
+ * with the MPI_Wait, MPI_Test and similar calls taking the same local variable.
+ * MPI collective codes must be set in basic blocks’s aux field and the
+ * post-dominance information must be computed before calling this function.
+ *
+ * A request is completed if every path from its initiations reaches one of its
+ * completions. Paths missing them that diverge at a rank-tainted fork of the
+ * post-dominance frontier of its completions, computed as for groups of MPI
+ * collectives, may leave only some ranks waiting for it. Requests held in
+ * variables used outside of MPI calls may be completed elsewhere and are not
+ * checked.
+ */
+void request_check(function *const fun)
+{
+        auto_vec<request> requests;
+        auto_vec<basic_block> forks;
+        auto_vec<int> checked;
+        bitmap_head *completions, *pdf;
+        bitmap_head reached;
+        struct taint *taint = NULL;
+        bitmap_iterator bi;
+        unsigned int bb_index, i;
+        basic_block bb;
+        gimple *stmt;
+        int *rep;
+        int n;
+
+        if (request_collect(fun, requests) == 0 || requests.is_empty())
+                return;
+
+        /* Completion groups, terminated by an empty one */
+        completions = XNEWVEC(bitmap_head, requests.length() + 1U);
+        rep = XNEWVEC(int, last_basic_block_for_fn(fun));
+
+        for (n = 0; n < last_basic_block_for_fn(fun); ++n)
+                rep[n] = n;
+
+        for (i = 0U, n = 0; i < requests.length(); ++i) {
+                if (requests[i].escaped)
+                        continue;
+
+                if (!bitmap_empty_p(&(requests[i].completions))) {
+                        bitmap_initialize(&(completions[n++]), &phase_obstack);
+                        bitmap_copy(&(completions[n - 1]),
+                                    &(requests[i].completions));
+                }
+
+                checked.safe_push(i);
+        }
+
+        bitmap_initialize(&(completions[n]), &phase_obstack);
+        pdf = n > 0 ? frontier_compute_groups_iter_post_dominance(fun,
+                                                                  completions,
+                                                                  rep)
+                    : NULL;
+        bitmap_initialize(&reached, &phase_obstack);
+
+        for (i = 0U, n = 0; i < checked.length(); ++i) {
+                request &r = requests[checked[i]];
+
+                if (bitmap_empty_p(&(r.completions))) {
+                        request_warn(fun, r, forks);
+                        continue;
+                }
+
+                bitmap_clear(&reached);
+                forks.truncate(0);
+                request_reach(fun, r, &reached);
+
+                EXECUTE_IF_AND_IN_BITMAP(&reached, &(pdf[n]), 0, bb_index,
+                                         bi) {
+                        bb = BASIC_BLOCK_FOR_FN(fun, bb_index);
+                        stmt = last_stmt(bb);
+
+                        if (bitmap_bit_p(&(r.completions), bb_index)
+                            || stmt == NULL)
+                                continue;
+
+                        if (taint == NULL)
+                                taint = taint_compute(fun);
+
+                        if (taint_control_p(taint, stmt))
+                                forks.safe_push(bb);
+                }
+
+                if (!forks.is_empty()
+                    || bitmap_bit_p(&reached, EXIT_BLOCK))
+                        request_warn(fun, r, forks);
+
+                n = n + 1;
+        }
+
+        if (taint != NULL)
+                taint_free(taint);
+
+        bitmap_clear(&reached);
+        free(pdf);
+        free(rep);
+        free(completions);
+}
@@ -0,0 +1,1132 @@
+/*
+ * Functions dealing with the simulation of ranks.
+ * Copyright (C) 2023-2025 Antoni Blanche
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include <gcc-plugin.h>
+#include <tree.h>
+#include <gimple.h>
+#include <gimple-iterator.h>
+#include <tree-cfg.h>
+#include <diagnostic-core.h>
+
+#include <string.h>
+
+#include "simulate.h"
+#include "mpicoll.h"
+#include "frontier.h"
+#include "arguments.h"
+#include "budget.h"
+
+/*
+ * Number of ranks simulated at once, one per bit of a lane mask.
+ */
+#define SIMULATE_LANES 64
+
+/*
+ * Number of basic blocks run per lane mask before giving up.
+ */
+#define SIMULATE_MAX_STEPS 65536
+
+#define SIMULATE_LANE(lane) (HOST_WIDE_INT_1U << (lane))
+
+/*
+ * Iterates over the lanes set in mask, using rest as a scratch mask.
+ */
+#define FOR_EACH_LANE(mask, rest, lane) \
+        for ((rest) = (mask); \
+             (rest) != 0U && ((lane) = ctz_hwi((rest)), true); \
+             (rest) &= (rest) - 1U)
+
+/*
+ * Values of a tracked variable on the ranks of a lane mask. Values are only
+ * meaningful on lanes set in known.
+ */
+struct simulate_value {
+        unsigned HOST_WIDE_INT known;
+        HOST_WIDE_INT values[SIMULATE_LANES];
+};
+
+/*
+ * Outcome of the simulation for a group. A mismatch is the first pair of ranks
+ * found calling different MPI collectives, one of them at the group: blocks[i]
+ * is the basic block called by ranks[i], or -1 if that rank returns instead.
+ */
+struct simulate_verdict {
+        bool proven;            /* All ranks call the same MPI collectives */
+        int size;               /* Ranks of the mismatch, 0 if there is none */
+        int ranks[2];
+        int blocks[2];
+};
+
+/*
+ * State of the simulation of up to SIMULATE_LANES ranks of a communicator,
+ * running together through the CFG. All lanes pending at a basic block run it
+ * at once, in reverse postorder, so that lanes taking different branches meet
+ * again at their join.
+ */
+struct simulate_run {
+        function *fun;
+        hash_map<tree, int> *slots;     /* Slot of each tracked variable */
+        struct simulate_value *state;   /* Value of each slot */
+        const int *order;               /* Reverse postorder of fun */
+        const int *position;            /* Position of each basic block in it */
+        int n;                          /* Number of basic blocks in order */
+        int cursor;                     /* Next position to look at */
+        int size;                       /* Communicator size */
+        int base;                       /* Rank of lane 0 */
+        unsigned HOST_WIDE_INT *pending; /* Lanes waiting at each block */
+        unsigned HOST_WIDE_INT done;    /* Lanes that returned */
+        unsigned HOST_WIDE_INT lost;    /* Lanes that cannot be simulated */
+        edge arrival[SIMULATE_LANES];   /* Last edge taken by each lane */
+        vec<int> *traces;               /* MPI collectives of each rank */
+        bool *returned;                 /* Whether each rank returned */
+};
+
+/*
+ * Function of the last simulation, and its outcome per group.
+ */
+static const function *simulate_fun = NULL;
+static auto_vec<struct simulate_verdict> simulate_verdicts;
+
+/*
+ * Names of the functions setting the rank and the size of a communicator.
+ */
+static const char *const SIMULATE_RANK_NAMES[] = {
+        "MPI_Comm_rank",
+        "PMPI_Comm_rank",
+};
+
+static const char *const SIMULATE_SIZE_NAMES[] = {
+        "MPI_Comm_size",
+        "PMPI_Comm_size",
+};
+
+/*
+ * Returns true if the name of fndecl is one of the n names, false otherwise.
+ */
+static bool simulate_named_p(const_tree fndecl, const char *const *const names,
+                             const size_t n)
+{
+        size_t i;
+
+        if (fndecl == NULL_TREE || DECL_NAME(fndecl) == NULL_TREE)
+                return false;
+
+        for (i = 0U; i < n; ++i) {
+                if (id_equal(DECL_NAME(fndecl), names[i]))
+                        return true;
+        }
+
+        return false;
+}
+
+/*
+ * Returns true if stmt is a call to MPI_Comm_rank or MPI_Comm_size, false
+ * otherwise. Sets rank to true for MPI_Comm_rank.
+ */
+static bool simulate_comm_call_p(const gimple *const stmt, bool *const rank)
+{
+        const_tree fndecl;
+
+        if (!is_gimple_call(stmt) || gimple_call_num_args(stmt) != 2U)
+                return false;
+
+        fndecl = gimple_call_fndecl(stmt);
+        *rank = simulate_named_p(fndecl, SIMULATE_RANK_NAMES,
+                                 ARRAY_SIZE(SIMULATE_RANK_NAMES));
+
+        return *rank || simulate_named_p(fndecl, SIMULATE_SIZE_NAMES,
+                                         ARRAY_SIZE(SIMULATE_SIZE_NAMES));
+}
+
+/*
+ * Adds to the set data the variable whose address is taken at *tp, if any.
+ */
+static tree simulate_find_address(tree *const tp, int *const walk_subtrees,
+                                  void *const data)
+{
+        hash_set<tree> *const escaped = (hash_set<tree> *) data;
+        tree base;
+
+        (void) walk_subtrees;
+
+        if (TREE_CODE(*tp) != ADDR_EXPR)
+                return NULL_TREE;
+
+        base = get_base_address(TREE_OPERAND(*tp, 0));
+
+        if (base != NULL_TREE && DECL_P(base))
+                escaped->add(base);
+
+        return NULL_TREE;
+}
+
+/*
+ * Adds to escaped the variables of fun whose address is taken, except by the
+ * calls to MPI_Comm_rank and MPI_Comm_size storing the rank or the size in
+ * them.
+ */
+static void simulate_find_escaped(function *const fun,
+                                  hash_set<tree> *const escaped)
+{
+        gimple_stmt_iterator gsi;
+        gphi_iterator psi;
+        basic_block bb;
+        gimple *stmt;
+        unsigned int i;
+        bool rank;
+
+        FOR_EACH_BB_FN(bb, fun) {
+                for (psi = gsi_start_phis(bb); !gsi_end_p(psi);
+                     gsi_next(&psi)) {
+                        for (i = 0U; i < gimple_phi_num_args(psi.phi()); ++i)
+                                walk_tree(gimple_phi_arg_def_ptr(psi.phi(), i),
+                                          simulate_find_address, escaped,
+                                          NULL);
+                }
+
+                for (gsi = gsi_start_bb(bb); !gsi_end_p(gsi); gsi_next(&gsi)) {
+                        stmt = gsi_stmt(gsi);
+
+                        for (i = 0U; i < gimple_num_ops(stmt); ++i) {
+                                if (gimple_op(stmt, i) == NULL_TREE
+                                    || (simulate_comm_call_p(stmt, &rank)
+                                        && gimple_op(stmt, i)
+                                           == gimple_call_arg(stmt, 1)))
+                                        continue;
+
+                                walk_tree(gimple_op_ptr(stmt, i),
+                                          simulate_find_address, escaped, NULL);
+                        }
+                }
+        }
+}
+
+/*
+ * Returns true if the value of t can be simulated, false otherwise. Tracked
+ * variables are integers of at most HOST_BITS_PER_WIDE_INT bits, either SSA
+ * names or local variables and parameters whose address does not escape.
+ */
+static bool simulate_tracked_p(const_tree t, hash_set<tree> *const escaped)
+{
+        if (t == NULL_TREE
+            || (TREE_CODE(t) != SSA_NAME && TREE_CODE(t) != VAR_DECL
+                && TREE_CODE(t) != PARM_DECL)
+            || !INTEGRAL_TYPE_P(TREE_TYPE(t))
+            || TYPE_PRECISION(TREE_TYPE(t)) > HOST_BITS_PER_WIDE_INT)
+                return false;
+
+        switch (TREE_CODE(t)) {
+        case SSA_NAME:
+                return !virtual_operand_p(t);
+        case VAR_DECL:
+                if (is_global_var(t))
+                        return false;
+                /* Fall through */
+        case PARM_DECL:
+                return !escaped->contains(const_cast<tree>(t));
+        default:
+                return false;
+        }
+}
+
+/*
+ * Adds t to slots if it is tracked and has no slot yet.
+ */
+static void simulate_add_slot(tree t, hash_set<tree> *const escaped,
+                              hash_map<tree, int> *const slots)
+{
+        if (simulate_tracked_p(t, escaped) && slots->get(t) == NULL)
+                slots->put(t, (int) slots->elements());
+}
+
+/*
+ * Gives a slot to each tracked variable of fun. Returns the number of slots.
+ */
+static int simulate_find_slots(function *const fun,
+                               hash_map<tree, int> *const slots)
+{
+        hash_set<tree> escaped;
+        gimple_stmt_iterator gsi;
+        gphi_iterator psi;
+        basic_block bb;
+        gimple *stmt;
+        tree arg;
+        unsigned int i;
+        bool rank;
+
+        simulate_find_escaped(fun, &escaped);
+
+        FOR_EACH_BB_FN(bb, fun) {
+                for (psi = gsi_start_phis(bb); !gsi_end_p(psi);
+                     gsi_next(&psi)) {
+                        simulate_add_slot(gimple_phi_result(psi.phi()),
+                                          &escaped, slots);
+
+                        for (i = 0U; i < gimple_phi_num_args(psi.phi()); ++i)
+                                simulate_add_slot(gimple_phi_arg_def(psi.phi(),
+                                                  i), &escaped, slots);
+                }
+
+                for (gsi = gsi_start_bb(bb); !gsi_end_p(gsi); gsi_next(&gsi)) {
+                        stmt = gsi_stmt(gsi);
+
+                        for (i = 0U; i < gimple_num_ops(stmt); ++i)
+                                simulate_add_slot(gimple_op(stmt, i), &escaped,
+                                                  slots);
+
+                        if (!simulate_comm_call_p(stmt, &rank))
+                                continue;
+
+                        arg = gimple_call_arg(stmt, 1);
+
+                        if (TREE_CODE(arg) == ADDR_EXPR)
+                                simulate_add_slot(TREE_OPERAND(arg, 0),
+                                                  &escaped, slots);
+                }
+        }
+
+        return (int) slots->elements();
+}
+
+/*
+ * Returns value truncated to the precision of type, and sign or zero extended
+ * according to its signedness.
+ */
+static HOST_WIDE_INT simulate_wrap(const HOST_WIDE_INT value, const_tree type)
+{
+        const unsigned int precision = TYPE_PRECISION(type);
+
+        if (precision >= HOST_BITS_PER_WIDE_INT)
+                return value;
+
+        return TYPE_UNSIGNED(type) ? (HOST_WIDE_INT) zext_hwi(value, precision)
+                                   : sext_hwi(value, precision);
+}
+
+/*
+ * Sets value to the value of the operand t on lane. Returns true if it is
+ * known, false otherwise.
+ */
+static bool simulate_operand(const struct simulate_run *const run, tree t,
+                             const int lane, HOST_WIDE_INT *const value)
+{
+        const int *slot;
+
+        if (TREE_CODE(t) == INTEGER_CST) {
+                if (!INTEGRAL_TYPE_P(TREE_TYPE(t)))
+                        return false;
+
+                *value = simulate_wrap(TREE_INT_CST_LOW(t), TREE_TYPE(t));
+
+                return true;
+        }
+
+        slot = run->slots->get(t);
+
+        if (slot == NULL
+            || (run->state[*slot].known & SIMULATE_LANE(lane)) == 0U)
+                return false;
+
+        *value = run->state[*slot].values[lane];
+
+        return true;
+}
+
+/*
+ * Sets res to the result of code applied to a and b, read with type. Returns
+ * true if the result is defined and code is supported, false otherwise.
+ */
+static bool simulate_compute(const enum tree_code code, const_tree type,
+                             const HOST_WIDE_INT a, const HOST_WIDE_INT b,
+                             HOST_WIDE_INT *const res)
+{
+        const unsigned HOST_WIDE_INT ua = a, ub = b;
+        const bool uns = TYPE_UNSIGNED(type);
+
+        switch (code) {
+        case INTEGER_CST:
+        case SSA_NAME:
+        case VAR_DECL:
+        case PARM_DECL:
+        case NOP_EXPR:
+        case CONVERT_EXPR:
+                *res = a;
+                break;
+        case NEGATE_EXPR:
+                *res = -ua;
+                break;
+        case BIT_NOT_EXPR:
+                *res = ~ua;
+                break;
+        case ABS_EXPR:
+                *res = uns || a >= 0 ? a : (HOST_WIDE_INT) -ua;
+                break;
+        case TRUTH_NOT_EXPR:
+                *res = a == 0;
+                break;
+        case PLUS_EXPR:
+                *res = ua + ub;
+                break;
+        case MINUS_EXPR:
+                *res = ua - ub;
+                break;
+        case MULT_EXPR:
+                *res = ua * ub;
+                break;
+        case TRUNC_DIV_EXPR:
+        case EXACT_DIV_EXPR:
+        case TRUNC_MOD_EXPR:
+                if (b == 0 || (!uns && a == HOST_WIDE_INT_MIN && b == -1))
+                        return false;
+
+                if (code == TRUNC_MOD_EXPR)
+                        *res = uns ? (HOST_WIDE_INT) (ua % ub) : a % b;
+                else
+                        *res = uns ? (HOST_WIDE_INT) (ua / ub) : a / b;
+                break;
+        case BIT_AND_EXPR:
+                *res = ua & ub;
+                break;
+        case BIT_IOR_EXPR:
+                *res = ua | ub;
+                break;
+        case BIT_XOR_EXPR:
+                *res = ua ^ ub;
+                break;
+        case LSHIFT_EXPR:
+        case RSHIFT_EXPR:
+                if (b < 0 || b >= (HOST_WIDE_INT) TYPE_PRECISION(type))
+                        return false;
+
+                if (code == LSHIFT_EXPR)
+                        *res = ua << b;
+                else
+                        *res = uns ? (HOST_WIDE_INT) (ua >> b) : a >> b;
+                break;
+        case MIN_EXPR:
+                *res = (uns ? ua < ub : a < b) ? a : b;
+                break;
+        case MAX_EXPR:
+                *res = (uns ? ua > ub : a > b) ? a : b;
+                break;
+        case LT_EXPR:
+                *res = uns ? ua < ub : a < b;
+                break;
+        case LE_EXPR:
+                *res = uns ? ua <= ub : a <= b;
+                break;
+        case GT_EXPR:
+                *res = uns ? ua > ub : a > b;
+                break;
+        case GE_EXPR:
+                *res = uns ? ua >= ub : a >= b;
+                break;
+        case EQ_EXPR:
+                *res = a == b;
+                break;
+        case NE_EXPR:
+                *res = a != b;
+                break;
+        case TRUTH_AND_EXPR:
+                *res = a != 0 && b != 0;
+                break;
+        case TRUTH_OR_EXPR:
+                *res = a != 0 || b != 0;
+                break;
+        case TRUTH_XOR_EXPR:
+                *res = (a != 0) != (b != 0);
+                break;
+        default:
+                return false;
+        }
+
+        return true;
+}
+
+/*
+ * Makes the value of t unknown on lanes, if t is tracked.
+ */
+static void simulate_forget(struct simulate_run *const run, tree t,
+                            const unsigned HOST_WIDE_INT lanes)
+{
+        const int *slot;
+
+        if (t == NULL_TREE || (slot = run->slots->get(t)) == NULL)
+                return;
+
+        run->state[*slot].known &= ~lanes;
+}
+
+/*
+ * Runs the assignment stmt on lanes. Assignments with 3 operands, from memory
+ * or from untracked variables make the left-hand side unknown.
+ */
+static void simulate_assign(struct simulate_run *const run,
+                            const gimple *const stmt,
+                            const unsigned HOST_WIDE_INT lanes)
+{
+        const tree lhs = gimple_assign_lhs(stmt);
+        const tree rhs1 = gimple_assign_rhs1(stmt);
+        const tree rhs2 = gimple_assign_rhs2(stmt);
+        const enum tree_code code = gimple_assign_rhs_code(stmt);
+        unsigned HOST_WIDE_INT known = 0U, rest;
+        struct simulate_value *value;
+        HOST_WIDE_INT a, b = 0, res;
+        const int *slot;
+        int lane;
+
+        if ((slot = run->slots->get(lhs)) == NULL)
+                return;
+
+        value = &(run->state[*slot]);
+
+        if (gimple_num_ops(stmt) > 3U) {
+                value->known &= ~lanes;
+                return;
+        }
+
+        /* The left-hand side may also be an operand */
+        FOR_EACH_LANE(lanes, rest, lane) {
+                if (!simulate_operand(run, rhs1, lane, &a)
+                    || (rhs2 != NULL_TREE
+                        && !simulate_operand(run, rhs2, lane, &b))
+                    || !simulate_compute(code, TREE_TYPE(rhs1), a, b, &res))
+                        continue;
+
+                value->values[lane] = simulate_wrap(res, TREE_TYPE(lhs));
+                known |= SIMULATE_LANE(lane);
+        }
+
+        value->known = (value->known & ~lanes) | known;
+}
+
+/*
+ * Runs the call stmt on lanes. MPI_Comm_rank and MPI_Comm_size on
+ * MPI_COMM_WORLD set the rank and the size, other calls make their result
+ * unknown.
+ */
+static void simulate_call(struct simulate_run *const run,
+                          const gimple *const stmt,
+                          const unsigned HOST_WIDE_INT lanes)
+{
+        unsigned HOST_WIDE_INT rest;
+        struct simulate_value *value;
+        const int *slot;
+        tree arg;
+        bool rank;
+        int lane;
+
+        simulate_forget(run, gimple_call_lhs(stmt), lanes);
+
+        if (!simulate_comm_call_p(stmt, &rank))
+                return;
+
+        arg = gimple_call_arg(stmt, 1);
+
+        if (TREE_CODE(arg) != ADDR_EXPR
+            || (slot = run->slots->get(TREE_OPERAND(arg, 0))) == NULL)
+                return;
+
+        value = &(run->state[*slot]);
+
+        /* The rank and the size on other communicators are unknown */
+        if (mpicoll_comm(as_a<const gcall *>(stmt)) == NULL_TREE
+            || !mpicoll_world_p(as_a<const gcall *>(stmt))) {
+                value->known &= ~lanes;
+                return;
+        }
+
+        FOR_EACH_LANE(lanes, rest, lane)
+                value->values[lane] = simulate_wrap(rank ? run->base + lane
+                                                         : run->size,
+                                                    TREE_TYPE(TREE_OPERAND(arg,
+                                                                           0)));
+
+        value->known |= lanes;
+}
+
+/*
+ * Runs the PHI nodes of bb on lanes, each lane reading the arguments of the
+ * edge it arrived from. All PHI nodes read their arguments before any of them
+ * is set.
+ */
+static void simulate_phis(struct simulate_run *const run, const basic_block bb,
+                          const unsigned HOST_WIDE_INT lanes)
+{
+        auto_vec<struct simulate_value> values;
+        auto_vec<int> slots;
+        struct simulate_value value;
+        unsigned HOST_WIDE_INT rest;
+        gphi_iterator psi;
+        const int *slot;
+        HOST_WIDE_INT a;
+        gphi *phi;
+        unsigned int i;
+        int lane;
+
+        for (psi = gsi_start_phis(bb); !gsi_end_p(psi); gsi_next(&psi)) {
+                phi = psi.phi();
+
+                if ((slot = run->slots->get(gimple_phi_result(phi))) == NULL)
+                        continue;
+
+                value.known = 0U;
+
+                FOR_EACH_LANE(lanes, rest, lane) {
+                        if (!simulate_operand(run, PHI_ARG_DEF_FROM_EDGE(phi,
+                                              run->arrival[lane]), lane, &a))
+                                continue;
+
+                        value.values[lane] = simulate_wrap(a,
+                                             TREE_TYPE(gimple_phi_result(phi)));
+                        value.known |= SIMULATE_LANE(lane);
+                }
+
+                values.safe_push(value);
+                slots.safe_push(*slot);
+        }
+
+        for (i = 0U; i < slots.length(); ++i) {
+                FOR_EACH_LANE(values[i].known, rest, lane)
+                        run->state[slots[i]].values[lane]
+                                = values[i].values[lane];
+
+                run->state[slots[i]].known = (run->state[slots[i]].known
+                                              & ~lanes) | values[i].known;
+        }
+}
+
+/*
+ * Sends lanes along e, to run its destination later.
+ */
+static void simulate_follow(struct simulate_run *const run, const edge e,
+                            const unsigned HOST_WIDE_INT lanes)
+{
+        unsigned HOST_WIDE_INT rest;
+        int lane;
+
+        if (lanes == 0U)
+                return;
+
+        run->pending[e->dest->index] |= lanes;
+
+        FOR_EACH_LANE(lanes, rest, lane)
+                run->arrival[lane] = e;
+
+        /* Backedges go back in the reverse postorder */
+        if (run->position[e->dest->index] < run->cursor)
+                run->cursor = run->position[e->dest->index];
+}
+
+/*
+ * Returns the edge out of bb taken by the switch stmt when its index is value.
+ */
+static edge simulate_case(function *const fun, const basic_block bb,
+                          const gswitch *const stmt, const HOST_WIDE_INT value)
+{
+        const_tree type = TREE_TYPE(gimple_switch_index(stmt));
+        tree label, low, high;
+        HOST_WIDE_INT lo, hi;
+        unsigned int i;
+        bool lt, gt;
+
+        for (i = 1U; i < gimple_switch_num_labels(stmt); ++i) {
+                label = gimple_switch_label(stmt, i);
+                low = CASE_LOW(label);
+                high = CASE_HIGH(label) != NULL_TREE ? CASE_HIGH(label) : low;
+                lo = simulate_wrap(TREE_INT_CST_LOW(low), type);
+                hi = simulate_wrap(TREE_INT_CST_LOW(high), type);
+
+                if (TYPE_UNSIGNED(type)) {
+                        lt = (unsigned HOST_WIDE_INT) value
+                             < (unsigned HOST_WIDE_INT) lo;
+                        gt = (unsigned HOST_WIDE_INT) value
+                             > (unsigned HOST_WIDE_INT) hi;
+                } else {
+                        lt = value < lo;
+                        gt = value > hi;
+                }
+
+                if (!lt && !gt)
+                        break;
+        }
+
+        if (i == gimple_switch_num_labels(stmt))
+                label = gimple_switch_default_label(stmt);
+
+        return find_edge(bb, label_to_block(fun, CASE_LABEL(label)));
+}
+
+/*
+ * Sends lanes out of bb along the edges they take. Lanes branching on unknown
+ * values, or leaving bb along an abnormal edge only, are lost.
+ */
+static void simulate_branch(struct simulate_run *const run,
+                            const basic_block bb,
+                            const unsigned HOST_WIDE_INT lanes)
+{
+        const gimple *const stmt = last_stmt(bb);
+        unsigned HOST_WIDE_INT known = 0U, taken = 0U, rest;
+        edge true_edge, false_edge, e, next = NULL;
+        const gswitch *switch_stmt;
+        tree type;
+        HOST_WIDE_INT a, b, res;
+        edge_iterator ei;
+        int lane;
+
+        if (stmt != NULL && gimple_code(stmt) == GIMPLE_COND) {
+                extract_true_false_edges_from_block(bb, &true_edge,
+                                                    &false_edge);
+                type = TREE_TYPE(gimple_cond_lhs(stmt));
+
+                FOR_EACH_LANE(lanes, rest, lane) {
+                        if (!simulate_operand(run, gimple_cond_lhs(stmt), lane,
+                                              &a)
+                            || !simulate_operand(run, gimple_cond_rhs(stmt),
+                                                 lane, &b)
+                            || !simulate_compute(gimple_cond_code(stmt), type,
+                                                 a, b, &res))
+                                continue;
+
+                        known |= SIMULATE_LANE(lane);
+                        taken |= res != 0 ? SIMULATE_LANE(lane) : 0U;
+                }
+
+                simulate_follow(run, true_edge, taken);
+                simulate_follow(run, false_edge, known & ~taken);
+                run->lost |= lanes & ~known;
+
+                return;
+        }
+
+        if (stmt != NULL && gimple_code(stmt) == GIMPLE_SWITCH) {
+                switch_stmt = as_a<const gswitch *>(stmt);
+
+                FOR_EACH_LANE(lanes, rest, lane) {
+                        if (!simulate_operand(run,
+                                              gimple_switch_index(switch_stmt),
+                                              lane, &a)
+                            || (e = simulate_case(run->fun, bb, switch_stmt,
+                                                  a)) == NULL) {
+                                run->lost |= SIMULATE_LANE(lane);
+                                continue;
+                        }
+
+                        simulate_follow(run, e, SIMULATE_LANE(lane));
+                }
+
+                return;
+        }
+
+        FOR_EACH_EDGE(e, ei, bb->succs) {
+                if ((e->flags & (EDGE_EH | EDGE_ABNORMAL | EDGE_FAKE)) != 0)
+                        continue;
+
+                /* Any other branch is on a value that is not simulated */
+                if (next != NULL) {
+                        run->lost |= lanes;
+                        return;
+                }
+
+                next = e;
+        }
+
+        if (next == NULL)
+                run->lost |= lanes;
+        else
+                simulate_follow(run, next, lanes);
+}
+
+/*
+ * Runs bb on lanes, recording its MPI collective in the trace of each rank.
+ */
+static void simulate_block(struct simulate_run *const run, const basic_block bb,
+                           const unsigned HOST_WIDE_INT lanes)
+{
+        unsigned HOST_WIDE_INT rest;
+        gimple_stmt_iterator gsi;
+        const gasm *asm_stmt;
+        gimple *stmt;
+        unsigned int i;
+        int lane;
+
+        if (bb == EXIT_BLOCK_PTR_FOR_FN(run->fun)) {
+                run->done |= lanes;
+                return;
+        }
+
+        simulate_phis(run, bb, lanes);
+
+        if (bb != ENTRY_BLOCK_PTR_FOR_FN(run->fun)
+            && (long) bb->aux != LAST_AND_UNUSED_MPI_COLLECTIVE_CODE) {
+                FOR_EACH_LANE(lanes, rest, lane)
+                        run->traces[run->base + lane].safe_push(bb->index);
+        }
+
+        for (gsi = gsi_start_bb(bb); !gsi_end_p(gsi); gsi_next(&gsi)) {
+                stmt = gsi_stmt(gsi);
+
+                switch (gimple_code(stmt)) {
+                case GIMPLE_ASSIGN:
+                        simulate_assign(run, stmt, lanes);
+                        break;
+                case GIMPLE_CALL:
+                        simulate_call(run, stmt, lanes);
+                        break;
+                case GIMPLE_ASM:
+                        asm_stmt = as_a<const gasm *>(stmt);
+
+                        for (i = 0U; i < gimple_asm_noutputs(asm_stmt); ++i)
+                                simulate_forget(run, TREE_VALUE(
+                                                gimple_asm_output_op(asm_stmt,
+                                                                     i)),
+                                                lanes);
+                        break;
+                default:
+                        break;
+                }
+        }
+
+        simulate_branch(run, bb, lanes);
+}
+
+/*
+ * Sets the initial values of the tracked variables: all of them are unknown,
+ * parameters included, until the rank and the size are read.
+ */
+static void simulate_start(struct simulate_run *const run)
+{
+        for (hash_map<tree, int>::iterator it = run->slots->begin();
+             it != run->slots->end(); ++it)
+                run->state[(*it).second].known = 0U;
+}
+
+/*
+ * Simulates the ranks run->base to run->base + SIMULATE_LANES - 1 of a
+ * communicator of run->size ranks, from the entry of fun to its exit. Returns
+ * true if all of them returned, false otherwise.
+ */
+static bool simulate_lanes(struct simulate_run *const run)
+{
+        const int width = MIN(run->size - run->base, SIMULATE_LANES);
+        const unsigned HOST_WIDE_INT all = width == SIMULATE_LANES
+                                           ? HOST_WIDE_INT_M1U
+                                           : SIMULATE_LANE(width) - 1U;
+        unsigned HOST_WIDE_INT lanes, rest;
+        basic_block bb;
+        int steps = 0;
+        int lane;
+
+        memset(run->pending, 0,
+               last_basic_block_for_fn(run->fun) * sizeof(*run->pending));
+        run->done = 0U;
+        run->lost = 0U;
+        run->cursor = 0;
+        simulate_start(run);
+        run->pending[ENTRY_BLOCK] = all;
+
+        for (;;) {
+                while (run->cursor < run->n
+                       && run->pending[run->order[run->cursor]] == 0U)
+                        run->cursor = run->cursor + 1;
+
+                if (run->cursor == run->n)
+                        break;
+
+                bb = BASIC_BLOCK_FOR_FN(run->fun, run->order[run->cursor]);
+                lanes = run->pending[bb->index];
+                run->pending[bb->index] = 0U;
+                run->cursor = run->cursor + 1;
+                steps = steps + 1;
+
+                if (steps > SIMULATE_MAX_STEPS || budget_time_exceeded_p()) {
+                        run->lost = all & ~run->done;
+                        break;
+                }
+
+                simulate_block(run, bb, lanes);
+        }
+
+        FOR_EACH_LANE(run->done & ~run->lost, rest, lane)
+                run->returned[run->base + lane] = true;
+
+        return (run->done & ~run->lost) == all;
+}
+
+/*
+ * Returns the MPI collective code of the basic block with index bb_index.
+ */
+static long simulate_code(function *const fun, const int bb_index)
+{
+        return (long) BASIC_BLOCK_FOR_FN(fun, bb_index)->aux;
+}
+
+/*
+ * Records a mismatch between the ranks 0 and rank of a communicator of size
+ * ranks, calling the basic blocks x and y, or -1 if they return, for the groups
+ * of x and y that do not have one yet.
+ */
+static void simulate_record(const int size, const int rank, const int x,
+                            const int y, const int *const group_of)
+{
+        const int blocks[2] = { x, y };
+        struct simulate_verdict *verdict;
+        int i;
+
+        for (i = 0; i < 2; ++i) {
+                if (blocks[i] < 0 || group_of[blocks[i]] < 0)
+                        continue;
+
+                verdict = &(simulate_verdicts[group_of[blocks[i]]]);
+
+                if (verdict->size != 0)
+                        continue;
+
+                verdict->size = size;
+                verdict->ranks[0] = 0;
+                verdict->ranks[1] = rank;
+                verdict->blocks[0] = x;
+                verdict->blocks[1] = y;
+        }
+}
+
+/*
+ * Compares the sequence of MPI collectives of each rank of a communicator of
+ * size ranks with the one of rank 0, and records the first difference found
+ * for each rank. Returns true if all sequences are the same, false otherwise.
+ * Sequences of ranks that did not return are only compared up to their end.
+ */
+static bool simulate_compare(struct simulate_run *const run, const int size,
+                             const int *const group_of)
+{
+        const vec<int> &first = run->traces[0];
+        unsigned int k, length;
+        bool same = true;
+        int x, y;
+        int rank;
+
+        for (rank = 1; rank < size; ++rank) {
+                const vec<int> &other = run->traces[rank];
+
+                length = MIN(first.length(), other.length());
+
+                for (k = 0U; k < length; ++k) {
+                        if (simulate_code(run->fun, first[k])
+                            != simulate_code(run->fun, other[k]))
+                                break;
+                }
+
+                if (k == first.length() && k == other.length())
+                        continue;
+
+                same = false;
+
+                /* A rank that did not return may call more MPI collectives */
+                if ((k == first.length() && !run->returned[0])
+                    || (k == other.length() && !run->returned[rank]))
+                        continue;
+
+                x = k < first.length() ? first[k] : -1;
+                y = k < other.length() ? other[k] : -1;
+                simulate_record(size, rank, x, y, group_of);
+        }
+
+        return same;
+}
+
+/*
+ * Simulates all ranks of a communicator of size ranks, SIMULATE_LANES at a
+ * time. Returns true if all of them returned after calling the same sequence of
+ * MPI collectives, false otherwise.
+ */
+static bool simulate_size(struct simulate_run *const run, const int size,
+                          const int *const group_of)
+{
+        bool complete = true, same;
+        int rank;
+
+        run->size = size;
+
+        for (rank = 0; rank < size; ++rank) {
+                run->traces[rank].truncate(0);
+                run->returned[rank] = false;
+        }
+
+        for (run->base = 0; run->base < size;
+             run->base = run->base + SIMULATE_LANES)
+                complete &= simulate_lanes(run);
+
+        same = simulate_compare(run, size, group_of);
+
+        return complete && same;
+}
+
+/*
+ * Simulates fun on every rank of communicators of 2 to n ranks, n being set by
+ * the simulate plugin argument, when at least one group has a non-empty
+ * post-dominance frontier in pdf. Only the rank and the size, read with
+ * MPI_Comm_rank and MPI_Comm_size on MPI_COMM_WORLD, and constants are
+ * propagated: ranks reaching a branch on another value are not simulated
+ * further. The sequences of MPI collectives of all ranks are then
+ * compared, to prove groups safe or find ranks calling different MPI
+ * collectives. MPI collective codes must be set in basic blocks’s aux field
+ * before calling this function.
+ *
+ * See mpicoll_mark_code() for details.
+ */
+void simulate_groups(function *const fun, const bitmap groups,
+                     const bitmap pdf)
+{
+        const int max = mpicoll_arguments.simulate;
+        const struct simulate_verdict none = { false, 0, { 0, 0 }, { -1, -1 } };
+        struct simulate_run run;
+        hash_map<tree, int> slots;
+        unsigned int bb_index;
+        bitmap_iterator bi;
+        bool flagged = false, proven = true;
+        int *group_of, *order, *position;
+        int i, size;
+
+        simulate_fun = fun;
+        simulate_verdicts.truncate(0);
+
+        FOR_EACH_BITMAP(groups, 0, i) {
+                simulate_verdicts.safe_push(none);
+                flagged |= !bitmap_empty_p(&(pdf[i]));
+        }
+
+        if (!flagged || max < 2)
+                return;
+
+        group_of = XNEWVEC(int, last_basic_block_for_fn(fun));
+        order = XNEWVEC(int, n_basic_blocks_for_fn(fun));
+        position = XNEWVEC(int, last_basic_block_for_fn(fun));
+
+        for (i = 0; i < last_basic_block_for_fn(fun); ++i) {
+                group_of[i] = -1;
+                position[i] = -1;
+        }
+
+        FOR_EACH_BITMAP(groups, 0, i) {
+                EXECUTE_IF_SET_IN_BITMAP(&(groups[i]), 0, bb_index, bi)
+                        group_of[bb_index] = i;
+        }
+
+        run.fun = fun;
+        run.slots = &slots;
+        run.state = XNEWVEC(struct simulate_value,
+                            MAX(simulate_find_slots(fun, &slots), 1));
+        run.order = order;
+        run.position = position;
+        run.n = frontier_reverse_postorder(fun, order);
+        run.pending = XNEWVEC(unsigned HOST_WIDE_INT,
+                              last_basic_block_for_fn(fun));
+        run.traces = XCNEWVEC(vec<int>, max);
+        run.returned = XNEWVEC(bool, max);
+
+        for (i = 0; i < run.n; ++i)
+                position[order[i]] = i;
+
+        for (size = 2; size <= max; ++size)
+                proven &= simulate_size(&run, size, group_of);
+
+        FOR_EACH_BITMAP(groups, 0, i)
+                simulate_verdicts[i].proven = proven
+                                              && !bitmap_empty_p(&(pdf[i]));
+
+        for (i = 0; i < max; ++i)
+                run.traces[i].release();
+
+        free(run.returned);
+        free(run.traces);
+        free(run.pending);
+        free(run.state);
+        free(position);
+        free(order);
+        free(group_of);
+}
+
+/*
+ * Returns true if the last simulation of fun proved that all ranks call the
+ * same sequence of MPI collectives, so that group cannot deadlock, false
+ * otherwise.
+ */
+bool simulate_proven_p(const function *const fun, const int group)
+{
+        return simulate_fun == fun && group >= 0
+               && (unsigned int) group < simulate_verdicts.length()
+               && simulate_verdicts[group].proven;
+}
+
+/*
+ * Prints a note at the basic block with index bb_index called by rank, or at
+ * the end of fun if bb_index is -1. The first note of a mismatch gives the
+ * number of ranks.
+ */
+static void simulate_note(function *const fun, const int bb_index,
+                          const int rank, const bool first, const int size)
+{
+        const char *name;
+        basic_block bb;
+
+        if (bb_index < 0) {
+                if (first)
+                        inform(fun->function_end_locus,
+                               "with %d ranks, rank %d returns here", size,
+                               rank);
+                else
+                        inform(fun->function_end_locus,
+                               "while rank %d returns here", rank);
+                return;
+        }
+
+        bb = BASIC_BLOCK_FOR_FN(fun, bb_index);
+        name = IDENTIFIER_POINTER(DECL_NAME(gimple_call_fndecl(
+                                  mpicoll_stmt(bb))));
+
+        if (first)
+                inform(mpicoll_location(bb),
+                       "with %d ranks, rank %d calls %qs here", size, rank,
+                       name);
+        else
+                inform(mpicoll_location(bb), "while rank %d calls %qs here",
+                       rank, name);
+}
+
+/*
+ * Prints notes at the MPI collectives called by the first pair of ranks found
+ * calling different MPI collectives at group by the last simulation of fun, if
+ * any.
+ */
+void simulate_explain(function *const fun, const int group)
+{
+        const struct simulate_verdict *verdict;
+
+        if (simulate_fun != fun || group < 0
+            || (unsigned int) group >= simulate_verdicts.length())
+                return;
+
+        verdict = &(simulate_verdicts[group]);
+
+        if (verdict->size == 0)
+                return;
+
+        simulate_note(fun, verdict->blocks[0], verdict->ranks[0], true,
+                      verdict->size);
+        simulate_note(fun, verdict->blocks[1], verdict->ranks[1], false,
+                      verdict->size);
+}
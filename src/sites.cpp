@@ -0,0 +1,130 @@
+/*
+ * Functions dealing with MPI collective site IDs.
+ * Copyright (C) 2023-2025 Antoni Blanche
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include <gcc-plugin.h>
+#include <diagnostic-core.h>
+#include <output.h>
+#include <dwarf2asm.h>
+
+#include <string.h>
+
+#include "sites.h"
+
+/*
+ * A site registered in the translation unit.
+ */
+struct site {
+        int code;
+        int line;
+        char *function;
+        char *file;
+};
+
+/*
+ * All sites registered in the translation unit, in index order.
+ */
+static auto_vec<struct site> sites; /* Global variable, yuck */
+
+/*
+ * Returns the tag of the translation unit, derived from its main input file
+ * name and distinct from MPICOLL_SITES_PMPI_TAG.
+ */
+static unsigned int sites_tag(void)
+{
+        static unsigned int tag = -1U;
+        unsigned int hash = 2166136261U;
+        const char *c;
+
+        if (tag != -1U)
+                return tag;
+
+        for (c = main_input_filename; c != NULL && *c != '\0'; ++c)
+                hash = (hash ^ (unsigned char) *c) * 16777619U;
+
+        tag = (hash ^ (hash >> MPICOLL_SITES_INDEX_BITS))
+              & (-1U >> MPICOLL_SITES_INDEX_BITS);
+
+        if (tag == MPICOLL_SITES_PMPI_TAG)
+                tag = tag - 1U;
+
+        return tag;
+}
+
+/*
+ * Returns a new site ID for the site with code at loc in fun.
+ */
+unsigned int sites_register(function *const fun, const location_t loc,
+                            const int code)
+{
+        struct site site;
+        const char *file = LOCATION_FILE(loc);
+
+        if (sites.length() == MPICOLL_SITES_MAX_INDEX + 1U)
+                error_at(loc, "too many MPI collective sites in translation "
+                         "unit (%u)", MPICOLL_SITES_MAX_INDEX + 1U);
+
+        site.code = code;
+        site.line = LOCATION_LINE(loc);
+        site.function = xstrdup(function_name(fun));
+        site.file = xstrdup(file != NULL ? file : "");
+
+        sites.safe_push(site);
+
+        return MPICOLL_SITES_ID(sites_tag(), (sites.length() - 1U)
+                                & MPICOLL_SITES_MAX_INDEX);
+}
+
+/*
+ * Emits the .mpicoll_sites section of the translation unit mapping each site
+ * ID to its function, file, line and code.
+ */
+void sites_emit(void *const event_data ATTRIBUTE_UNUSED,
+                void *const data ATTRIBUTE_UNUSED)
+{
+        struct site *site;
+        unsigned int size = 4U * 4U;
+        unsigned int i;
+
+        if (sites.is_empty() || asm_out_file == NULL)
+                return;
+
+        FOR_EACH_VEC_ELT(sites, i, site)
+                size = size + 2U * 4U + strlen(site->function) + 1U
+                       + strlen(site->file) + 1U;
+
+        switch_to_section(get_section(MPICOLL_SITES_SECTION, SECTION_DEBUG,
+                                      NULL));
+        assemble_align(MPICOLL_SITES_ALIGN * BITS_PER_UNIT);
+
+        dw2_asm_output_data(4, MPICOLL_SITES_MAGIC, "mpicoll sites magic");
+        dw2_asm_output_data(4, sites_tag(), "tag");
+        dw2_asm_output_data(4, sites.length(), "number of sites");
+        dw2_asm_output_data(4, size, "size");
+
+        FOR_EACH_VEC_ELT(sites, i, site) {
+                dw2_asm_output_data(4, (unsigned int) site->code, "code");
+                dw2_asm_output_data(4, site->line, "line");
+                dw2_asm_output_nstring(site->function, (size_t) -1, "function");
+                dw2_asm_output_nstring(site->file, (size_t) -1, "file");
+
+                free(site->function);
+                free(site->file);
+        }
+
+        assemble_align(MPICOLL_SITES_ALIGN * BITS_PER_UNIT);
+        sites.truncate(0);
+}
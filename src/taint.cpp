@@ -0,0 +1,312 @@
+/*
+ * Functions dealing with rank-tainted values.
+ * Copyright (C) 2023-2025 Antoni Blanche
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include <gcc-plugin.h>
+#include <tree.h>
+#include <gimple.h>
+#include <gimple-iterator.h>
+#include <cfgloop.h>
+
+#include "taint.h"
+#include "phase.h"
+
+/*
+ * Returns true if t is a local variable whose address is never taken, false
+ * otherwise.
+ */
+static bool taint_local_p(const_tree t)
+{
+        return TREE_CODE(t) == VAR_DECL && !is_global_var(t)
+               && !TREE_ADDRESSABLE(t);
+}
+
+/*
+ * Returns true if the operand t may be rank-tainted, false otherwise.
+ */
+bool taint_operand_p(const struct taint *const taint, const_tree t)
+{
+        if (t == NULL_TREE || CONSTANT_CLASS_P(t))
+                return false;
+
+        /* Default definitions are parameters or uninitialised values */
+        if (TREE_CODE(t) == SSA_NAME)
+                return SSA_NAME_IS_DEFAULT_DEF(t)
+                       || bitmap_bit_p(&(taint->names), SSA_NAME_VERSION(t));
+
+        if (taint_local_p(t))
+                return bitmap_bit_p(&(taint->decls), DECL_UID(t));
+
+        return true;
+}
+
+/*
+ * Marks t as rank-tainted. Returns true if t was not already rank-tainted,
+ * false otherwise.
+ */
+static bool taint_set(struct taint *const taint, const_tree t)
+{
+        if (TREE_CODE(t) == SSA_NAME)
+                return bitmap_set_bit(&(taint->names), SSA_NAME_VERSION(t));
+
+        if (taint_local_p(t))
+                return bitmap_set_bit(&(taint->decls), DECL_UID(t));
+
+        return false;
+}
+
+/*
+ * Returns true if the value defined by stmt may be rank-tainted, false
+ * otherwise.
+ */
+static bool taint_stmt_p(const struct taint *const taint,
+                         const gimple *const stmt)
+{
+        unsigned int i;
+
+        if (!is_gimple_assign(stmt))
+                return true;
+
+        for (i = 1U; i < gimple_num_ops(stmt); ++i) {
+                if (taint_operand_p(taint, gimple_op(stmt, i)))
+                        return true;
+        }
+
+        return false;
+}
+
+/*
+ * Marks the outputs of the inline assembly stmt as rank-tainted. Returns true
+ * if at least 1 output was not already rank-tainted, false otherwise.
+ */
+static bool taint_asm(struct taint *const taint, const gasm *const stmt)
+{
+        bool changed = false;
+        unsigned int i;
+
+        for (i = 0U; i < gimple_asm_noutputs(stmt); ++i)
+                changed |= taint_set(taint, TREE_VALUE(gimple_asm_output_op(
+                                     stmt, i)));
+
+        return changed;
+}
+
+/*
+ * Marks the results of the PHI nodes of bb as rank-tainted if one of their
+ * arguments is, or if ranks may reach bb from different predecessors: bb is
+ * divergent, or one of its predecessors is divergent or in forks. Returns true
+ * if at least 1 result was not already rank-tainted, false otherwise.
+ */
+static bool taint_phis(struct taint *const taint, const basic_block bb,
+                       const const_bitmap forks)
+{
+        bool merged = bitmap_bit_p(&(taint->blocks), bb->index);
+        bool changed = false;
+        gphi_iterator psi;
+        gphi *phi;
+        unsigned int i;
+        edge e;
+        edge_iterator ei;
+
+        FOR_EACH_EDGE(e, ei, bb->preds) {
+                if (bitmap_bit_p(&(taint->blocks), e->src->index)
+                    || bitmap_bit_p(forks, e->src->index))
+                        merged = true;
+        }
+
+        for (psi = gsi_start_phis(bb); !gsi_end_p(psi); gsi_next(&psi)) {
+                phi = psi.phi();
+
+                if (taint_operand_p(taint, gimple_phi_result(phi)))
+                        continue;
+
+                for (i = 0U; i < gimple_phi_num_args(phi); ++i) {
+                        if (merged || taint_operand_p(taint,
+                                                      gimple_phi_arg_def(phi,
+                                                                         i))) {
+                                changed |= taint_set(taint,
+                                                     gimple_phi_result(phi));
+                                break;
+                        }
+                }
+        }
+
+        return changed;
+}
+
+/*
+ * Marks the basic blocks of fun control dependent on bb as divergent: ranks
+ * reaching bb may not all reach them. A basic block is control dependent on bb
+ * if it post-dominates a successor of bb but not bb itself. If the
+ * post-dominance information is not computed, the behaviour is undefined.
+ */
+static void taint_diverge(const function *const fun,
+                          struct taint *const taint, const basic_block bb)
+{
+        basic_block ipdom = get_immediate_dominator(CDI_POST_DOMINATORS, bb);
+        basic_block runner;
+        edge e;
+        edge_iterator ei;
+
+        FOR_EACH_EDGE(e, ei, bb->succs) {
+                for (runner = e->dest;
+                     runner != NULL && runner != ipdom
+                     && runner != EXIT_BLOCK_PTR_FOR_FN(fun);
+                     runner = get_immediate_dominator(CDI_POST_DOMINATORS,
+                                                      runner))
+                        bitmap_set_bit(&(taint->blocks), runner->index);
+        }
+}
+
+/*
+ * Computes rank-tainted values in fun. A value defined in a divergent basic
+ * block is rank-tainted too, since only some ranks may define it, and so is a
+ * PHI node result merging paths that ranks may take differently. If the
+ * post-dominance information is not computed, the behaviour is undefined.
+ *
+ * See calculate_dominance_info() for details
+ *
+ * The Taint Propagation Algorithm:
+ * Changed <- true
+ * while (Changed)
+ *     Changed <- false
+ *     for all statements and PHI nodes, s, defining a value, v
+ *         if v is not tainted and (an operand of s is tainted, s is in a
+ *         divergent block, or s is a PHI node after a fork)
+ *             taint v
+ *             Changed <- true
+ *     for all blocks, b, ending with a tainted branch or divergent
+ *         if a block control dependent on b is not divergent
+ *             mark it divergent
+ *             Changed <- true
+ */
+struct taint *taint_compute(const function *const fun)
+{
+        struct taint *taint = XNEW(struct taint);
+        gimple_stmt_iterator gsi;
+        bitmap_head forks;
+        basic_block bb;
+        gimple *stmt;
+        tree lhs;
+        bool changed, divergent;
+
+        bitmap_initialize(&(taint->decls), &phase_obstack);
+        bitmap_initialize(&(taint->names), &phase_obstack);
+        bitmap_initialize(&(taint->blocks), &phase_obstack);
+        bitmap_initialize(&forks, &phase_obstack);
+
+        for (changed = true; changed;) {
+                changed = false;
+                PHASE_COUNT(COUNTER_ITERATIONS, 1);
+
+                FOR_EACH_BB_FN(bb, fun) {
+                        divergent = bitmap_bit_p(&(taint->blocks), bb->index);
+                        changed |= taint_phis(taint, bb, &forks);
+
+                        for (gsi = gsi_start_bb(bb); !gsi_end_p(gsi);
+                             gsi_next(&gsi)) {
+                                stmt = gsi_stmt(gsi);
+                                lhs = gimple_get_lhs(stmt);
+
+                                if (gimple_code(stmt) == GIMPLE_ASM)
+                                        changed |= taint_asm(taint,
+                                                   as_a<gasm *>(stmt));
+
+                                if (lhs != NULL_TREE
+                                    && !taint_operand_p(taint, lhs)
+                                    && (divergent
+                                        || taint_stmt_p(taint, stmt)))
+                                        changed |= taint_set(taint, lhs);
+                        }
+
+                        /* Control dependent blocks are only marked once */
+                        stmt = gsi_stmt(gsi_last_bb(bb));
+
+                        if (EDGE_COUNT(bb->succs) >= 2
+                            && !bitmap_bit_p(&forks, bb->index)
+                            && (divergent || (stmt != NULL
+                                && taint_control_p(taint, stmt)))) {
+                                bitmap_set_bit(&forks, bb->index);
+                                taint_diverge(fun, taint, bb);
+                                changed = true;
+                        }
+                }
+        }
+
+        bitmap_clear(&forks);
+
+        return taint;
+}
+
+/*
+ * Releases taint.
+ */
+void taint_free(struct taint *const taint)
+{
+        bitmap_clear(&(taint->decls));
+        bitmap_clear(&(taint->names));
+        bitmap_clear(&(taint->blocks));
+        free(taint);
+}
+
+/*
+ * Returns true if stmt is a control statement whose outcome may depend on a
+ * rank-tainted value, false otherwise.
+ */
+bool taint_control_p(const struct taint *const taint, const gimple *const stmt)
+{
+        switch (gimple_code(stmt)) {
+        case GIMPLE_COND:
+                return taint_operand_p(taint, gimple_cond_lhs(stmt))
+                       || taint_operand_p(taint, gimple_cond_rhs(stmt));
+        case GIMPLE_SWITCH:
+                return taint_operand_p(taint, gimple_switch_index(
+                                       as_a<const gswitch *>(stmt)));
+        case GIMPLE_GOTO:
+                return true;
+        default:
+                return false;
+        }
+}
+
+/*
+ * Returns true if every control statement in loop is not rank-tainted, false
+ * otherwise. All ranks entering a rank-uniform loop run the same number of
+ * iterations and call the same sequence of MPI collectives. A loop whose bound
+ * is written under a rank-tainted branch is not rank-uniform, since the bound
+ * is rank-tainted.
+ *
+ * See taint_compute() for details.
+ */
+bool taint_loop_uniform_p(const struct taint *const taint,
+                          const class loop *const loop)
+{
+        basic_block *body = get_loop_body(loop);
+        gimple *stmt;
+        bool res = true;
+        unsigned int i;
+
+        for (i = 0U; i < loop->num_nodes && res; ++i) {
+                stmt = gsi_stmt(gsi_last_bb(body[i]));
+
+                if (stmt != NULL && taint_control_p(taint, stmt))
+                        res = false;
+        }
+
+        free(body);
+
+        return res;
+}
@@ -0,0 +1,418 @@
+/*
+ * Functions dealing with the MPI thread level required by OpenMP constructs.
+ * Copyright (C) 2023-2025 Antoni Blanche
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include <gcc-plugin.h>
+#include <tree.h>
+#include <gimple.h>
+#include <gimple-iterator.h>
+#include <diagnostic-core.h>
+#include <tree-pass.h>
+
+#include <string.h>
+
+#include "threading.h"
+#include "mpicoll.h"
+#include "arguments.h"
+
+/*
+ * MPI thread levels, in the order of the MPI_THREAD_* constants of MPI
+ * implementations, from 0 to 3.
+ */
+enum threading_level {
+        THREADING_SINGLE,
+        THREADING_FUNNELED,
+        THREADING_SERIALIZED,
+        THREADING_MULTIPLE
+};
+
+/*
+ * Name of each MPI thread level.
+ */
+static const char *const THREADING_NAME[] = {
+        "MPI_THREAD_SINGLE",
+        "MPI_THREAD_FUNNELED",
+        "MPI_THREAD_SERIALIZED",
+        "MPI_THREAD_MULTIPLE",
+};
+
+/*
+ * Threads that may call a MPI collective: the thread calling the function,
+ * outside of parallel regions, the master thread, the thread executing a
+ * single construct without nowait clause, threads one at a time in a critical
+ * construct, or any thread.
+ */
+enum threading_guard {
+        GUARD_NONE,
+        GUARD_MASTER,
+        GUARD_SINGLE,
+        GUARD_CRITICAL,
+        GUARD_ANY
+};
+
+/*
+ * An OpenMP region: the directive starting it and the index of the region
+ * containing it, -1 if none.
+ */
+struct threading_region {
+        gimple *stmt;
+        int outer;
+};
+
+/*
+ * A call to MPI_Init_thread() with a constant required thread level.
+ */
+struct threading_init {
+        location_t location;
+        enum threading_level required;
+};
+
+/*
+ * Highest MPI thread level required by the functions checked in the
+ * translation unit, and calls to MPI_Init_thread() in them.
+ */
+static enum threading_level threading_unit_level = THREADING_SINGLE;
+static auto_vec<threading_init> threading_inits;
+
+/*
+ * Returns true if the clause with code is in clauses, false otherwise.
+ */
+static bool threading_clause_p(tree clauses, const enum omp_clause_code code)
+{
+        for (; clauses != NULL_TREE; clauses = OMP_CLAUSE_CHAIN(clauses)) {
+                if (OMP_CLAUSE_CODE(clauses) == code)
+                        return true;
+        }
+
+        return false;
+}
+
+/*
+ * Returns true if the masked construct stmt is executed by the master thread
+ * only, that is if it has no filter clause or a filter clause of 0, false
+ * otherwise.
+ */
+static bool threading_masked_master_p(const gimple *const stmt)
+{
+        tree clauses = gimple_omp_masked_clauses(stmt);
+
+        for (; clauses != NULL_TREE; clauses = OMP_CLAUSE_CHAIN(clauses)) {
+                if (OMP_CLAUSE_CODE(clauses) == OMP_CLAUSE_FILTER)
+                        return integer_zerop(OMP_CLAUSE_FILTER_EXPR(clauses));
+        }
+
+        return true;
+}
+
+/*
+ * Updates the region current, index in regions, with the OpenMP statement
+ * stmt and returns the new current region. Regions are delimited the same way
+ * as the OpenMP expansion does: each directive starts a region, closed by its
+ * GIMPLE_OMP_RETURN, except stand-alone directives.
+ */
+static int threading_enter(auto_vec<threading_region> &regions,
+                           gimple *const stmt, const int current)
+{
+        threading_region region;
+
+        switch (gimple_code(stmt)) {
+        case GIMPLE_OMP_RETURN:
+        case GIMPLE_OMP_ATOMIC_STORE:
+                return current >= 0 ? regions[current].outer : -1;
+        case GIMPLE_OMP_CONTINUE:
+        case GIMPLE_OMP_SECTIONS_SWITCH:
+                return current;
+        case GIMPLE_OMP_TARGET:
+                if (!is_gimple_omp_offloaded(stmt))
+                        return current;
+                break;
+        case GIMPLE_OMP_ORDERED:
+                if (threading_clause_p(gimple_omp_ordered_clauses(
+                                       as_a<gomp_ordered *>(stmt)),
+                                       OMP_CLAUSE_DEPEND))
+                        return current;
+                break;
+        case GIMPLE_OMP_TASK:
+                if (gimple_omp_task_taskwait_p(stmt))
+                        return current;
+                break;
+        default:
+                break;
+        }
+
+        region.stmt = stmt;
+        region.outer = current;
+        regions.safe_push(region);
+
+        return regions.length() - 1;
+}
+
+/*
+ * Returns the threads that may call a MPI collective in the region current,
+ * index in regions, and puts in name the name of its critical construct if
+ * any. Constructs restrict the threads of the innermost enclosing parallel
+ * region, except those outside a task, which may be executed by any thread. In
+ * nested parallel regions, only the master thread at each level is known to be
+ * a single thread.
+ */
+static enum threading_guard threading_guard(
+                const auto_vec<threading_region> &regions, int current,
+                tree *const name)
+{
+        enum threading_guard res = GUARD_NONE, here = GUARD_ANY;
+        bool task = false;
+        gimple *stmt;
+
+        *name = NULL_TREE;
+
+        for (; current >= 0; current = regions[current].outer) {
+                stmt = regions[current].stmt;
+
+                switch (gimple_code(stmt)) {
+                case GIMPLE_OMP_PARALLEL:
+                case GIMPLE_OMP_TEAMS:
+                case GIMPLE_OMP_TARGET:
+                        if (res == GUARD_NONE)
+                                res = here;
+                        else if (res != GUARD_MASTER || here != GUARD_MASTER)
+                                res = GUARD_ANY;
+
+                        here = GUARD_ANY;
+                        task = false;
+                        break;
+                case GIMPLE_OMP_TASK:
+                        task = true;
+                        break;
+                case GIMPLE_OMP_MASTER:
+                        if (!task)
+                                here = GUARD_MASTER;
+                        break;
+                case GIMPLE_OMP_MASKED:
+                        if (!task && threading_masked_master_p(stmt))
+                                here = GUARD_MASTER;
+                        break;
+                case GIMPLE_OMP_SINGLE:
+                        if (!task && here == GUARD_ANY
+                            && !threading_clause_p(gimple_omp_single_clauses(
+                                                   stmt), OMP_CLAUSE_NOWAIT))
+                                here = GUARD_SINGLE;
+                        break;
+                case GIMPLE_OMP_CRITICAL:
+                        if (!task && here == GUARD_ANY) {
+                                here = GUARD_CRITICAL;
+                                *name = gimple_omp_critical_name(
+                                        as_a<gomp_critical *>(stmt));
+                        }
+                        break;
+                default:
+                        break;
+                }
+        }
+
+        return res;
+}
+
+/*
+ * Records the call to MPI_Init_thread() stmt if its required thread level is
+ * constant.
+ */
+static void threading_record_init(gimple *const stmt)
+{
+        threading_init init;
+        tree fndecl, required;
+
+        if (!is_gimple_call(stmt) || gimple_call_num_args(stmt) < 3U)
+                return;
+
+        fndecl = gimple_call_fndecl(stmt);
+
+        if (fndecl == NULL_TREE
+            || strcmp(IDENTIFIER_POINTER(DECL_NAME(fndecl)),
+                      "MPI_Init_thread") != 0)
+                return;
+
+        required = gimple_call_arg(stmt, 2);
+
+        if (!tree_fits_shwi_p(required) || tree_to_shwi(required) < 0
+            || tree_to_shwi(required) > THREADING_MULTIPLE)
+                return;
+
+        init.location = gimple_location(stmt);
+        init.required = (enum threading_level) tree_to_shwi(required);
+        threading_inits.safe_push(init);
+}
+
+/*
+ * Computes the MPI thread level required by the MPI collectives of fun, from
+ * the OpenMP constructs enclosing them, and prints it in a note if a MPI
+ * collective is in a parallel region. MPI collective codes must be set in
+ * basic blocks’s aux field before calling this function.
+ *
+ * MPI collectives called by the master thread only require
+ * MPI_THREAD_FUNNELED. Those called in single constructs without nowait
+ * clause, which end with a barrier, or all in critical constructs of the same
+ * name, require MPI_THREAD_SERIALIZED, unless they may run concurrently with
+ * MPI collectives in other constructs. The function itself is assumed to be
+ * called outside of parallel regions.
+ *
+ * Once OpenMP constructs are expanded, parallel regions are outlined into
+ * other functions and the level cannot be computed anymore. An error is then
+ * emitted instead, once per translation unit.
+ */
+void threading_check(function *const fun)
+{
+        static bool expanded = false;
+
+        enum threading_level level = THREADING_SINGLE;
+        auto_diagnostic_group d;
+        auto_vec<threading_region> regions;
+        auto_vec<basic_block> stack;
+        auto_vec<location_t> concurrent;
+        auto_vec<int> outer;
+        location_t master = UNKNOWN_LOCATION, serialized = UNKNOWN_LOCATION;
+        bool any = false, single = false, critical = false, names = false;
+        tree name = NULL_TREE, critical_name = NULL_TREE;
+        enum threading_guard guard;
+        gimple_stmt_iterator gsi;
+        basic_block bb, son;
+        gimple *site, *stmt;
+        unsigned int i;
+        int current;
+
+        if (fun->curr_properties & PROP_gimple_eomp) {
+                if (!expanded)
+                        error("plugin argument %qs requires the MPI pass to "
+                              "run before OpenMP constructs are expanded, not "
+                              "after %qs", "thread-level",
+                              mpicoll_arguments.after);
+
+                expanded = true;
+                return;
+        }
+
+        calculate_dominance_info(CDI_DOMINATORS);
+
+        stack.safe_push(ENTRY_BLOCK_PTR_FOR_FN(fun));
+        outer.safe_push(-1);
+
+        /* Regions nest along the dominator tree */
+        while (!stack.is_empty()) {
+                bb = stack.pop();
+                current = outer.pop();
+
+                /* NULL aux is MPI_INIT, called before threads exist */
+                site = bb->aux != NULL && bb->aux != (void *)
+                                          LAST_AND_UNUSED_MPI_COLLECTIVE_CODE
+                       ? mpicoll_stmt(bb) : NULL;
+
+                for (gsi = gsi_start_bb(bb); !gsi_end_p(gsi); gsi_next(&gsi)) {
+                        stmt = gsi_stmt(gsi);
+
+                        if (is_gimple_omp(stmt)) {
+                                current = threading_enter(regions, stmt,
+                                                          current);
+                                continue;
+                        }
+
+                        threading_record_init(stmt);
+
+                        if (stmt != site)
+                                continue;
+
+                        guard = threading_guard(regions, current, &name);
+
+                        switch (guard) {
+                        case GUARD_NONE:
+                                break;
+                        case GUARD_MASTER:
+                                master = gimple_location(stmt);
+                                break;
+                        case GUARD_SINGLE:
+                                single = true;
+                                serialized = gimple_location(stmt);
+                                break;
+                        case GUARD_CRITICAL:
+                                names = names || (critical
+                                                  && name != critical_name);
+                                critical = true;
+                                critical_name = name;
+                                serialized = gimple_location(stmt);
+                                break;
+                        case GUARD_ANY:
+                                any = true;
+                                concurrent.safe_push(gimple_location(stmt));
+                                break;
+                        }
+                }
+
+                for (son = first_dom_son(CDI_DOMINATORS, bb); son != NULL;
+                     son = next_dom_son(CDI_DOMINATORS, son)) {
+                        stack.safe_push(son);
+                        outer.safe_push(current);
+                }
+        }
+
+        free_dominance_info(CDI_DOMINATORS);
+
+        if (any || names || (single && critical)
+            || (master != UNKNOWN_LOCATION && (single || critical)))
+                level = THREADING_MULTIPLE;
+        else if (single || critical)
+                level = THREADING_SERIALIZED;
+        else if (master != UNKNOWN_LOCATION)
+                level = THREADING_FUNNELED;
+
+        if (level > threading_unit_level)
+                threading_unit_level = level;
+
+        if (level == THREADING_SINGLE)
+                return;
+
+        inform(DECL_SOURCE_LOCATION(fun->decl), "MPI collectives in %qs "
+               "require %qs", function_name(fun), THREADING_NAME[level]);
+
+        for (i = 0U; i < concurrent.length(); ++i)
+                inform(concurrent[i], "MPI collective called by several "
+                       "threads at once here");
+
+        if (!any && level == THREADING_MULTIPLE)
+                inform(serialized, "MPI collective called concurrently with "
+                       "those of other OpenMP constructs here");
+}
+
+/*
+ * Prints a note at each call to MPI_Init_thread() requesting a higher thread
+ * level than required by the MPI collectives checked in the translation unit.
+ * This function is a PLUGIN_FINISH_UNIT callback.
+ */
+void threading_finish_unit(void *const event_data ATTRIBUTE_UNUSED,
+                           void *const data ATTRIBUTE_UNUSED)
+{
+        unsigned int i;
+
+        for (i = 0U; i < threading_inits.length(); ++i) {
+                if (threading_inits[i].required <= threading_unit_level)
+                        continue;
+
+                inform(threading_inits[i].location, "%qs requested but the "
+                       "MPI collectives checked in this file only require %qs",
+                       THREADING_NAME[threading_inits[i].required],
+                       THREADING_NAME[threading_unit_level]);
+        }
+
+        threading_inits.truncate(0);
+        threading_unit_level = THREADING_SINGLE;
+}
@@ -0,0 +1,51 @@
+#include <stdlib.h>
+#include <stdio.h>
+
+#include <mpi.h>
+
+#pragma mpicoll check mpi_half
+#pragma mpicoll check mpi_call
+
+/* Only MPI_COMM_WORLD collectives are checked, so this one must not abort */
+void mpi_half(int rank)
+{
+        double value = rank, sum = 0.0;
+        MPI_Comm half;
+
+        MPI_Comm_split(MPI_COMM_WORLD, rank % 2, rank, &half);
+
+        if (rank % 2 == 0)
+                MPI_Allreduce(&value, &sum, 1, MPI_DOUBLE, MPI_SUM, half);
+
+        MPI_Barrier(MPI_COMM_WORLD);
+        MPI_Comm_free(&half);
+}
+
+void mpi_call(int rank)
+{
+        double value = rank, sum = 0.0;
+
+        MPI_Barrier(MPI_COMM_WORLD);
+
+        if (rank % 2 == 0)
+                MPI_Reduce(&value, &sum, 1, MPI_DOUBLE, MPI_SUM, 0,
+                           MPI_COMM_WORLD);
+
+        printf("Rank %d: %f\n", rank, sum);
+        MPI_Barrier(MPI_COMM_WORLD);
+}
+
+int main(int argc, char *argv[])
+{
+        int rank;
+
+        MPI_Init(&argc, &argv);
+
+        MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+        mpi_half(rank);
+        mpi_call(rank);
+
+        MPI_Finalize();
+
+        return EXIT_SUCCESS;
+}
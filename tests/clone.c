@@ -0,0 +1,37 @@
+#include <stdlib.h>
+#include <stdio.h>
+
+#include <mpi.h>
+
+#pragma mpicoll check mpi_call
+
+static void __attribute__((noinline)) mpi_call(int rank, int root, int count)
+{
+        int i;
+
+        if (rank == root)
+                MPI_Barrier(MPI_COMM_WORLD);
+
+        for (i = 0; i < count; ++i)
+                MPI_Barrier(MPI_COMM_WORLD);
+
+        printf("Rank %d done\n", rank);
+}
+
+int main(int argc, char *argv[])
+{
+        int rank, size;
+
+        MPI_Init(&argc, &argv);
+
+        MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+        MPI_Comm_size(MPI_COMM_WORLD, &size);
+
+        mpi_call(rank, 0, 10);
+        mpi_call(rank, 1, 10);
+        mpi_call(rank, 0, size);
+
+        MPI_Finalize();
+
+        return EXIT_SUCCESS;
+}
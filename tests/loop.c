@@ -0,0 +1,60 @@
+#include <stdlib.h>
+#include <stdio.h>
+
+#include <mpi.h>
+
+#pragma mpicoll check (mpi_call, mpi_offset, mpi_bound)
+
+void mpi_call(int rank)
+{
+        int i;
+
+        if (rank == 0)
+                MPI_Barrier(MPI_COMM_WORLD);
+
+        for (i = 0; i < 1000; ++i)
+                MPI_Barrier(MPI_COMM_WORLD);
+
+        for (i = 0; i < rank; ++i)
+                MPI_Barrier(MPI_COMM_WORLD);
+
+        printf("Rank %d done\n", rank);
+}
+
+void mpi_offset(int rank)
+{
+        int i;
+
+        for (i = rank; i < rank + 10; ++i)
+                MPI_Barrier(MPI_COMM_WORLD);
+}
+
+/* The bound is written under a fork, so this loop must be warned about */
+void mpi_bound(int rank)
+{
+        int i, n;
+
+        n = 10;
+
+        if (rank == 0)
+                n = 20;
+
+        for (i = 0; i < n; ++i)
+                MPI_Barrier(MPI_COMM_WORLD);
+}
+
+int main(int argc, char *argv[])
+{
+        int rank;
+
+        MPI_Init(&argc, &argv);
+
+        MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+        mpi_call(rank);
+        mpi_offset(rank);
+        mpi_bound(rank);
+
+        MPI_Finalize();
+
+        return EXIT_SUCCESS;
+}
@@ -0,0 +1,63 @@
+#include <stdlib.h>
+#include <stdio.h>
+
+#include <mpi.h>
+
+#pragma mpicoll check (main, funneled, serialized, multiple)
+
+void funneled(double *v, int n)
+{
+        double s = 0.0;
+        int i;
+
+        #pragma omp parallel
+        {
+                #pragma omp for reduction(+:s)
+                for (i = 0; i < n; ++i)
+                        s = s + v[i];
+
+                #pragma omp master
+                MPI_Allreduce(MPI_IN_PLACE, &s, 1, MPI_DOUBLE, MPI_SUM,
+                              MPI_COMM_WORLD);
+        }
+
+        v[0] = s;
+}
+
+void serialized(double *v, int n)
+{
+        #pragma omp parallel
+        {
+                #pragma omp single
+                MPI_Bcast(v, n, MPI_DOUBLE, 0, MPI_COMM_WORLD);
+
+                #pragma omp single
+                MPI_Barrier(MPI_COMM_WORLD);
+        }
+}
+
+void multiple(double *v, int n)
+{
+        #pragma omp parallel
+        MPI_Bcast(v, n, MPI_DOUBLE, 0, MPI_COMM_WORLD);
+}
+
+int main(int argc, char *argv[])
+{
+        double v[4] = { 1.0, 2.0, 3.0, 4.0 };
+        int provided;
+
+        MPI_Init_thread(&argc, &argv, MPI_THREAD_MULTIPLE, &provided);
+
+        funneled(v, 4);
+        serialized(v, 4);
+
+        if (argc > 2)
+                multiple(v, 4);
+
+        printf("%f\n", v[0]);
+
+        MPI_Finalize();
+
+        return EXIT_SUCCESS;
+}
@@ -0,0 +1,36 @@
+#include <stdlib.h>
+#include <stdio.h>
+
+#include <mpi.h>
+
+void mpi_call(int rank, MPI_Comm comm)
+{
+        double value = rank, sum = 0.0;
+        int i;
+
+        for (i = 0; i < 100; ++i) {
+                if (i == 42 && rank == 1)
+                        MPI_Bcast(&value, 0, MPI_DOUBLE, 0, comm);
+
+                MPI_Allreduce(&value, &sum, 1, MPI_DOUBLE, MPI_SUM, comm);
+        }
+
+        printf("Rank %d: %f\n", rank, sum);
+}
+
+int main(int argc, char *argv[])
+{
+        MPI_Comm half;
+        int rank;
+
+        MPI_Init(&argc, &argv);
+
+        MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+        MPI_Comm_split(MPI_COMM_WORLD, rank / 2, rank, &half);
+        mpi_call(rank, half);
+
+        MPI_Comm_free(&half);
+        MPI_Finalize();
+
+        return EXIT_SUCCESS;
+}
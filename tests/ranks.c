@@ -0,0 +1,47 @@
+#include <stdlib.h>
+#include <stdio.h>
+
+#include <mpi.h>
+
+#pragma mpicoll check mpi_paths
+
+/* 2^32 paths lead to the first MPI_Barrier */
+#define STEP(i) if (data[i] > 0) data[i] -= 1; else data[i] += 1;
+#define STEP4(i) STEP(i) STEP((i) + 1) STEP((i) + 2) STEP((i) + 3)
+#define STEP16(i) STEP4(i) STEP4((i) + 4) STEP4((i) + 8) STEP4((i) + 12)
+
+void mpi_paths(int rank, int *data)
+{
+        int i;
+
+        STEP16(0)
+        STEP16(16)
+
+        MPI_Barrier(MPI_COMM_WORLD);
+
+        if (rank == 0)
+                MPI_Barrier(MPI_COMM_WORLD);
+
+        for (i = 0; i < 32; ++i) {
+                STEP(i)
+        }
+
+        MPI_Allreduce(MPI_IN_PLACE, data, 32, MPI_INT, MPI_SUM,
+                      MPI_COMM_WORLD);
+}
+
+int main(int argc, char *argv[])
+{
+        int data[32] = { 0 };
+        int rank;
+
+        MPI_Init(&argc, &argv);
+        MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+
+        mpi_paths(rank, data);
+        printf("Rank %d done\n", rank);
+
+        MPI_Finalize();
+
+        return EXIT_SUCCESS;
+}
@@ -0,0 +1,49 @@
+#include <stdlib.h>
+#include <stdio.h>
+
+#include <mpi.h>
+
+#pragma mpicoll check (overlap, leak)
+
+void overlap(double *v, double *s, int n)
+{
+        MPI_Request request;
+        int i;
+
+        MPI_Iallreduce(v, s, n, MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD, &request);
+
+        for (i = 0; i < n; ++i)
+                v[i] = v[i] * 2.0;
+
+        MPI_Wait(&request, MPI_STATUS_IGNORE);
+}
+
+void leak(int rank)
+{
+        MPI_Request request;
+
+        MPI_Ibarrier(MPI_COMM_WORLD, &request);
+
+        if (rank == 0)
+                MPI_Wait(&request, MPI_STATUS_IGNORE);
+}
+
+int main(int argc, char *argv[])
+{
+        double v[4] = { 1.0, 2.0, 3.0, 4.0 }, s[4];
+        int rank;
+
+        MPI_Init(&argc, &argv);
+
+        MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+        overlap(v, s, 4);
+
+        if (argc > 2)
+                leak(rank);
+
+        printf("Rank %d done\n", rank);
+
+        MPI_Finalize();
+
+        return EXIT_SUCCESS;
+}
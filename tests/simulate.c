@@ -0,0 +1,77 @@
+#include <stdlib.h>
+#include <stdio.h>
+
+#include <mpi.h>
+
+#pragma mpicoll check (mpi_negative, mpi_last, mpi_parity, mpi_count)
+#pragma mpicoll check mpi_param
+
+void mpi_negative(void)
+{
+        int rank;
+
+        MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+
+        if (rank < 0)
+                MPI_Barrier(MPI_COMM_WORLD);
+}
+
+void mpi_last(void)
+{
+        int rank, size;
+
+        MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+        MPI_Comm_size(MPI_COMM_WORLD, &size);
+
+        if (rank == size)
+                MPI_Barrier(MPI_COMM_WORLD);
+}
+
+void mpi_parity(void)
+{
+        int rank, value;
+
+        MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+        value = rank;
+
+        if (rank % 2 == 0)
+                MPI_Barrier(MPI_COMM_WORLD);
+        else
+                MPI_Allreduce(MPI_IN_PLACE, &value, 1, MPI_INT, MPI_SUM,
+                              MPI_COMM_WORLD);
+}
+
+void mpi_count(int count)
+{
+        int rank;
+
+        MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+
+        if (rank < count)
+                MPI_Barrier(MPI_COMM_WORLD);
+}
+
+/* A parameter is never taken for the rank, so this warning is kept */
+void mpi_param(int rank)
+{
+        if (rank < 0)
+                MPI_Barrier(MPI_COMM_WORLD);
+}
+
+int main(int argc, char *argv[])
+{
+        int rank;
+
+        MPI_Init(&argc, &argv);
+
+        MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+
+        mpi_negative();
+        mpi_last();
+        mpi_param(rank);
+        printf("Rank %d done\n", rank);
+
+        MPI_Finalize();
+
+        return EXIT_SUCCESS;
+}
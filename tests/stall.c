@@ -0,0 +1,50 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <time.h>
+
+#include <mpi.h>
+
+#pragma mpicoll check mpi_call
+
+/* Computes for about seconds without calling MPI */
+static double compute(double seconds)
+{
+        struct timespec start, now;
+        double res = 0.0;
+
+        clock_gettime(CLOCK_MONOTONIC, &start);
+
+        do {
+                res = res + 1.0;
+                clock_gettime(CLOCK_MONOTONIC, &now);
+        } while (now.tv_sec - start.tv_sec
+                 + (now.tv_nsec - start.tv_nsec) * 1e-9 < seconds);
+
+        return res;
+}
+
+/* All ranks compute past MPICOLL_STALL_TIMEOUT=1, which must not abort */
+void mpi_call(int rank)
+{
+        double value = rank, sum = 0.0;
+
+        MPI_Barrier(MPI_COMM_WORLD);
+        value = value + compute(3.0);
+        MPI_Allreduce(&value, &sum, 1, MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD);
+
+        printf("Rank %d: %f\n", rank, sum);
+}
+
+int main(int argc, char *argv[])
+{
+        int provided, rank;
+
+        MPI_Init_thread(&argc, &argv, MPI_THREAD_MULTIPLE, &provided);
+
+        MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+        mpi_call(rank);
+
+        MPI_Finalize();
+
+        return EXIT_SUCCESS;
+}
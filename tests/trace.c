@@ -0,0 +1,63 @@
+#include <stdlib.h>
+#include <stdio.h>
+
+#include <mpi.h>
+
+#pragma mpicoll check mpi_call
+
+void mpi_call(int rank, MPI_Comm comm)
+{
+        double value = rank, sum = 0.0;
+        int i;
+
+        for (i = 0; i < 100; ++i) {
+                MPI_Barrier(comm);
+
+                if (i == 42 && rank == 0)
+                        continue;
+
+                MPI_Reduce(&value, &sum, 1, MPI_DOUBLE, MPI_SUM, 0, comm);
+        }
+
+        printf("Rank %d: %f\n", rank, sum);
+}
+
+#pragma mpicoll check mpi_copy
+
+/* Calls on a duplicate must not be matched with calls on comm */
+void mpi_copy(int rank, MPI_Comm comm)
+{
+        MPI_Comm copy;
+        int i;
+
+        MPI_Comm_dup(comm, &copy);
+
+        for (i = 0; i < 10; ++i)
+                MPI_Bcast(&rank, 1, MPI_INT, 0, copy);
+
+        /* The same MPI collective from two sites must not diverge */
+        if (rank == 0)
+                MPI_Barrier(copy);
+        else
+                MPI_Barrier(copy);
+
+        MPI_Comm_free(&copy);
+}
+
+int main(int argc, char *argv[])
+{
+        MPI_Comm half;
+        int rank;
+
+        MPI_Init(&argc, &argv);
+
+        MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+        MPI_Comm_split(MPI_COMM_WORLD, rank % 2, rank, &half);
+        mpi_copy(rank, half);
+        mpi_call(rank, half);
+
+        MPI_Comm_free(&half);
+        MPI_Finalize();
+
+        return EXIT_SUCCESS;
+}
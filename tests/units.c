@@ -0,0 +1,40 @@
+#include <stdlib.h>
+#include <stdio.h>
+
+#include <mpi.h>
+
+#pragma mpicoll check mpi_call
+
+/* Defined in tests/units_lib.c, whose sites must keep their own file */
+void mpi_lib(int rank);
+#ifdef UNITS_CLASH
+void mpi_other(int rank);
+#endif
+
+void mpi_call(int rank)
+{
+        double value = rank, sum = 0.0;
+
+        MPI_Barrier(MPI_COMM_WORLD);
+        mpi_lib(rank);
+#ifdef UNITS_CLASH
+        mpi_other(rank);
+#endif
+        MPI_Allreduce(&value, &sum, 1, MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD);
+
+        printf("Rank %d: %f\n", rank, sum);
+}
+
+int main(int argc, char *argv[])
+{
+        int rank;
+
+        MPI_Init(&argc, &argv);
+
+        MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+        mpi_call(rank);
+
+        MPI_Finalize();
+
+        return EXIT_SUCCESS;
+}
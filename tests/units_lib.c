@@ -0,0 +1,25 @@
+#include <mpi.h>
+
+/* Compiled again with -DUNITS_OTHER, the two units share a site tag */
+#ifndef UNITS_OTHER
+#pragma mpicoll check mpi_lib
+
+/* The mismatch must be reported in tests/units_lib.c, not tests/units.c */
+void mpi_lib(int rank)
+{
+        double value = rank, max = 0.0;
+
+        if (rank == 0)
+                MPI_Reduce(&value, &max, 1, MPI_DOUBLE, MPI_MAX, 0,
+                           MPI_COMM_WORLD);
+        else
+                MPI_Barrier(MPI_COMM_WORLD);
+}
+#else
+#pragma mpicoll check mpi_other
+
+void mpi_other(int rank)
+{
+        MPI_Barrier(MPI_COMM_WORLD);
+}
+#endif
@@ -0,0 +1,431 @@
+/*
+ * Per-site counters reader, sampling the counters files of the ranks of a node
+ * and printing the sites costing the most.
+ * Copyright (C) 2023-2025 Antoni Blanche
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <sys/stat.h>
+
+#include "mpicoll_counters.h"
+#include "sitemap.h"
+
+/*
+ * Name of each MPI collective. The last code is used by function exits.
+ */
+#define DEF_MPI_COLLECTIVES(CODE, NAME) NAME,
+static const char *const MPI_COLLECTIVE_NAME[] = {
+#include "MPI_collectives.def"
+        "return"
+};
+#undef DEF_MPI_COLLECTIVES
+
+#define NB_CODES (int) (sizeof(MPI_COLLECTIVE_NAME) / sizeof(char *))
+
+/*
+ * Counters of a site summed over the ranks.
+ */
+struct total {
+        uint32_t site;
+        uint32_t ranks;         /* Number of ranks that reached the site */
+        uint64_t calls;
+        uint64_t checks;
+        uint64_t time;          /* Nanoseconds, summed over the ranks */
+        uint64_t max_time;      /* Nanoseconds of the slowest rank */
+};
+
+/*
+ * Totals of the current and of the previous sample, sorted by site.
+ */
+static struct total *totals = NULL;
+static size_t nb_totals = 0;
+static struct total *previous = NULL;
+static size_t nb_previous = 0;
+
+/*
+ * Number of files read and of site visits they dropped in the current sample.
+ */
+static unsigned int nb_files = 0;
+static uint64_t dropped = 0;
+
+/*
+ * Program the site IDs are looked up in, if any.
+ */
+static const char *program = NULL;
+
+/*
+ * Prints the site with ID site.
+ */
+static void print_site(const uint32_t site)
+{
+        struct sitemap_site s;
+
+        if (program == NULL || !sitemap_lookup_file(program, site, &s)) {
+                printf("site %#x", site);
+                return;
+        }
+
+        if (s.code == MPICOLL_SITES_LOOP)
+                printf("loop");
+        else if (s.code >= 0 && s.code < NB_CODES)
+                printf("%s", MPI_COLLECTIVE_NAME[s.code]);
+        else
+                printf("site %#x", site);
+
+        printf(" in %s() at %s:%d", s.function, s.file, s.line);
+}
+
+/*
+ * Returns the total of site in the n totals sorted by site, or NULL if there is
+ * none.
+ */
+static struct total *find_total(struct total *const all, const size_t n,
+                                const uint32_t site)
+{
+        size_t low = 0, high = n, middle;
+
+        while (low < high) {
+                middle = low + (high - low) / 2;
+
+                if (all[middle].site == site)
+                        return &(all[middle]);
+
+                if (all[middle].site < site)
+                        low = middle + 1;
+                else
+                        high = middle;
+        }
+
+        return NULL;
+}
+
+/*
+ * Compares totals by site.
+ */
+static int compare_sites(const void *const a, const void *const b)
+{
+        const struct total *x = a, *y = b;
+
+        return (x->site > y->site) - (x->site < y->site);
+}
+
+/*
+ * Compares totals by decreasing time, then by decreasing number of calls.
+ */
+static int compare_costs(const void *const a, const void *const b)
+{
+        const struct total *x = a, *y = b;
+
+        if (x->time != y->time)
+                return x->time < y->time ? 1 : -1;
+
+        return (x->calls < y->calls) - (x->calls > y->calls);
+}
+
+/*
+ * Appends slot to the totals of the current sample, one per rank and site, to
+ * be summed by sum_totals(). Returns 1 on success, 0 otherwise.
+ */
+static int add_slot(const struct mpicoll_counters_slot *const slot)
+{
+        struct total *res;
+
+        if (nb_totals % 1024 == 0) {
+                res = realloc(totals, (nb_totals + 1024) * sizeof(*res));
+
+                if (res == NULL)
+                        return 0;
+
+                totals = res;
+        }
+
+        totals[nb_totals].site = slot->site;
+        totals[nb_totals].ranks = slot->calls != 0;
+        totals[nb_totals].calls = slot->calls;
+        totals[nb_totals].checks = slot->checks;
+        totals[nb_totals].time = slot->time;
+        totals[nb_totals].max_time = slot->time;
+        nb_totals = nb_totals + 1;
+
+        return 1;
+}
+
+/*
+ * Sums the totals of the current sample with the same site, leaving them sorted
+ * by site.
+ */
+static void sum_totals(void)
+{
+        size_t i, n = 0;
+
+        qsort(totals, nb_totals, sizeof(*totals), &compare_sites);
+
+        for (i = 0; i < nb_totals; ++i) {
+                if (n != 0 && totals[n - 1].site == totals[i].site) {
+                        totals[n - 1].ranks += totals[i].ranks;
+                        totals[n - 1].calls += totals[i].calls;
+                        totals[n - 1].checks += totals[i].checks;
+                        totals[n - 1].time += totals[i].time;
+
+                        if (totals[i].max_time > totals[n - 1].max_time)
+                                totals[n - 1].max_time = totals[i].max_time;
+                } else {
+                        totals[n++] = totals[i];
+                }
+        }
+
+        nb_totals = n;
+}
+
+/*
+ * Reads the counters file at path into the current sample. Returns 1 on
+ * success, 0 otherwise.
+ */
+static int read_counters(const char *const path)
+{
+        struct mpicoll_counters_header header;
+        struct mpicoll_counters_slot slot;
+        uint64_t i;
+        FILE *file;
+
+        file = fopen(path, "rb");
+
+        if (file == NULL) {
+                perror(path);
+                return 0;
+        }
+
+        if (fread(&header, sizeof(header), 1, file) != 1
+            || header.magic != MPICOLL_COUNTERS_MAGIC || header.capacity == 0
+            || (header.capacity & (header.capacity - 1)) != 0
+            || header.rank >= header.size) {
+                fprintf(stderr, "%s: not a counters file\n", path);
+                fclose(file);
+                return 0;
+        }
+
+        /* Slots are read as they are written, each field being whole */
+        for (i = 0; i < header.capacity; ++i) {
+                if (fread(&slot, sizeof(slot), 1, file) != 1)
+                        break;
+
+                if (slot.used && !add_slot(&slot)) {
+                        fprintf(stderr, "%s: out of memory\n", path);
+                        fclose(file);
+                        return 0;
+                }
+        }
+
+        fclose(file);
+
+        nb_files = nb_files + 1;
+        dropped = dropped + header.dropped;
+
+        return 1;
+}
+
+/*
+ * Reads the counters files in the directory at path into the current sample.
+ * Returns 1 on success, 0 otherwise.
+ */
+static int read_directory(const char *const path)
+{
+        const size_t length = strlen(MPICOLL_COUNTERS_FILE);
+        struct dirent *entry;
+        char name[4096];
+        DIR *dir;
+        int res = 1;
+
+        dir = opendir(path);
+
+        if (dir == NULL) {
+                perror(path);
+                return 0;
+        }
+
+        while (res && (entry = readdir(dir)) != NULL) {
+                if (strncmp(entry->d_name, MPICOLL_COUNTERS_FILE, length) != 0
+                    || entry->d_name[length] != '.')
+                        continue;
+
+                snprintf(name, sizeof(name), "%s/%s", path, entry->d_name);
+                res = read_counters(name);
+        }
+
+        closedir(dir);
+
+        return res;
+}
+
+/*
+ * Reads the counters files and directories in paths into a new sample, keeping
+ * the current one as the previous sample. Returns 1 on success, 0 otherwise.
+ */
+static int read_sample(char *const *const paths, const int n)
+{
+        struct stat st;
+        int i;
+
+        free(previous);
+        previous = totals;
+        nb_previous = nb_totals;
+        totals = NULL;
+        nb_totals = 0;
+        nb_files = 0;
+        dropped = 0;
+
+        for (i = 0; i < n; ++i) {
+                if (stat(paths[i], &st) == 0 && S_ISDIR(st.st_mode)) {
+                        if (!read_directory(paths[i]))
+                                return 0;
+                } else if (!read_counters(paths[i])) {
+                        return 0;
+                }
+        }
+
+        sum_totals();
+
+        return 1;
+}
+
+/*
+ * Subtracts the counters of the previous sample from the current one, so that
+ * only the work done in between is left. The number of ranks and the time of
+ * the slowest rank still cover the whole run.
+ */
+static void subtract_previous(void)
+{
+        struct total *last;
+        size_t i;
+
+        for (i = 0; i < nb_totals; ++i) {
+                last = find_total(previous, nb_previous, totals[i].site);
+
+                if (last == NULL)
+                        continue;
+
+                totals[i].calls = totals[i].calls - last->calls;
+                totals[i].checks = totals[i].checks - last->checks;
+                totals[i].time = totals[i].time - last->time;
+        }
+}
+
+/*
+ * Prints the top sites of the current sample by time, all of them if top is 0.
+ */
+static void print_sample(const size_t top)
+{
+        size_t i;
+
+        qsort(totals, nb_totals, sizeof(*totals), &compare_costs);
+
+        printf("%u ranks, %zu sites", nb_files, nb_totals);
+
+        if (dropped != 0)
+                printf(", %llu site visits dropped", (unsigned long long)
+                       dropped);
+
+        printf("\n%12s %12s %12s %12s %6s  %s\n", "calls", "checks",
+               "time (ms)", "max (ms)", "ranks", "site");
+
+        for (i = 0; i < nb_totals && (top == 0 || i < top); ++i) {
+                printf("%12llu %12llu %12.3f %12.3f %6u  ",
+                       (unsigned long long) totals[i].calls,
+                       (unsigned long long) totals[i].checks,
+                       totals[i].time / 1e6, totals[i].max_time / 1e6,
+                       totals[i].ranks);
+                print_site(totals[i].site);
+                printf("\n");
+        }
+
+        /* Totals are kept sorted by site for the next sample */
+        qsort(totals, nb_totals, sizeof(*totals), &compare_sites);
+        fflush(stdout);
+}
+
+/*
+ * Prints usage.
+ */
+static void usage(const char *const name)
+{
+        fprintf(stderr, "Usage: %s [-e <program>] [-i <seconds>] [-n <count>] "
+                "[-t <top>] <counters file or directory>...\n", name);
+}
+
+int main(int argc, char *argv[])
+{
+        double interval = 0.0;
+        long count = 0, top = 20, i;
+        int opt;
+
+        while ((opt = getopt(argc, argv, "e:i:n:t:h")) != -1) {
+                switch (opt) {
+                case 'e':
+                        program = optarg;
+                        break;
+                case 'i':
+                        interval = atof(optarg);
+                        break;
+                case 'n':
+                        count = atol(optarg);
+                        break;
+                case 't':
+                        top = atol(optarg);
+                        break;
+                case 'h':
+                        usage(argv[0]);
+                        return EXIT_SUCCESS;
+                default:
+                        usage(argv[0]);
+                        return EXIT_FAILURE;
+                }
+        }
+
+        if (optind == argc || interval < 0.0 || count < 0 || top < 0) {
+                usage(argv[0]);
+                return EXIT_FAILURE;
+        }
+
+        /* Sites sharing an ID cannot be told apart */
+        if (program != NULL && !sitemap_check_file(program))
+                return EXIT_FAILURE;
+
+        /* Without an interval, a single sample of the totals is printed */
+        if (interval == 0.0)
+                count = 1;
+
+        for (i = 0; count == 0 || i < count; ++i) {
+                if (i != 0) {
+                        usleep((useconds_t) (interval * 1e6));
+                        printf("\n");
+                }
+
+                if (!read_sample(argv + optind, argc - optind))
+                        return EXIT_FAILURE;
+
+                subtract_previous();
+                print_sample((size_t) top);
+        }
+
+        free(previous);
+        free(totals);
+
+        return EXIT_SUCCESS;
+}
@@ -0,0 +1,420 @@
+/*
+ * Perfect hash table generator of the MPI collective spellings.
+ * Copyright (C) 2023-2025 Antoni Blanche
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <ctype.h>
+
+#include "mpicoll_hash.h"
+
+/*
+ * Code of each MPI collective.
+ */
+#define DEF_MPI_COLLECTIVES(CODE, NAME) CODE,
+enum mpi_collective_code {
+#include "MPI_collectives.def"
+        LAST_AND_UNUSED_MPI_COLLECTIVE_CODE
+};
+#undef DEF_MPI_COLLECTIVES
+
+/*
+ * A MPI function name and the code of the MPI collective it is recognized as.
+ */
+struct spelling {
+        const char *name;
+        int code;
+};
+
+/*
+ * MPI collectives, then aliases.
+ */
+#define DEF_MPI_COLLECTIVES(CODE, NAME) { NAME, CODE },
+#define DEF_MPI_ALIASES(CODE, NAME) { NAME, CODE },
+static const struct spelling NAMES[] = {
+#include "MPI_collectives.def"
+};
+#undef DEF_MPI_ALIASES
+#undef DEF_MPI_COLLECTIVES
+
+#define NB_NAMES (int) (sizeof(NAMES) / sizeof(struct spelling))
+
+/*
+ * Suffixes of the C bindings: plain and large count.
+ */
+static const char *const C_SUFFIXES[] = { "", "_c" };
+
+/*
+ * Suffixes of the mpi_f08 specific procedures: plain, TS 29113, and their large
+ * count versions.
+ */
+static const char *const F08_SUFFIXES[] = { "_f08", "_f08ts", "_c_f08",
+                                            "_c_f08ts" };
+
+/*
+ * Number of tries for the displacement of a bucket before giving up.
+ */
+#define MAX_TRIES (1 << 24)
+
+/*
+ * All spellings generated.
+ */
+static struct spelling *spellings = NULL;
+static int nb_spellings = 0;
+static int capacity = 0;
+
+/*
+ * Adds the spelling made of prefix, base and suffix, converted to lower case
+ * if lower is positive or to upper case if it is negative, for code.
+ */
+static void add(const char *const prefix, const char *const base,
+                const char *const suffix, const int lower, const int code)
+{
+        size_t len = strlen(prefix) + strlen(base) + strlen(suffix);
+        char *name;
+        size_t i;
+
+        if (nb_spellings == capacity) {
+                capacity = capacity == 0 ? 1024 : 2 * capacity;
+                spellings = realloc(spellings, capacity * sizeof(*spellings));
+
+                if (spellings == NULL) {
+                        perror("realloc");
+                        exit(EXIT_FAILURE);
+                }
+        }
+
+        name = malloc(len + 1);
+
+        if (name == NULL) {
+                perror("malloc");
+                exit(EXIT_FAILURE);
+        }
+
+        snprintf(name, len + 1, "%s%s%s", prefix, base, suffix);
+
+        for (i = 0; i < len; ++i) {
+                if (lower > 0)
+                        name[i] = tolower((unsigned char) name[i]);
+                else if (lower < 0)
+                        name[i] = toupper((unsigned char) name[i]);
+        }
+
+        spellings[nb_spellings].name = name;
+        spellings[nb_spellings].code = code;
+        nb_spellings = nb_spellings + 1;
+}
+
+/*
+ * Adds every spelling of the C name of the MPI function s:
+ *
+ *   C and PMPI bindings:   MPI_Allreduce, MPI_Allreduce_c, PMPI_Allreduce
+ *   Fortran bindings:      mpi_allreduce, mpi_allreduce_, mpi_allreduce__,
+ *                          MPI_ALLREDUCE, MPI_ALLREDUCE_, pmpi_allreduce_
+ *   mpi_f08 procedures:    MPI_Allreduce_f08, mpi_allreduce_f08,
+ *                          mpi_allreduce_f08_, PMPI_Allreduce_f08ts
+ */
+static void add_spellings(const struct spelling *const s)
+{
+        static const char *const prefixes[] = { "MPI_", "PMPI_" };
+        const char *base = s->name + strlen("MPI_");
+        char suffix[16];
+        size_t i, j;
+
+        for (i = 0; i < sizeof(prefixes) / sizeof(char *); ++i) {
+                for (j = 0; j < sizeof(C_SUFFIXES) / sizeof(char *); ++j)
+                        add(prefixes[i], base, C_SUFFIXES[j], 0, s->code);
+
+                add(prefixes[i], base, "", 1, s->code);
+                add(prefixes[i], base, "_", 1, s->code);
+                add(prefixes[i], base, "__", 1, s->code);
+                add(prefixes[i], base, "", -1, s->code);
+                add(prefixes[i], base, "_", -1, s->code);
+
+                for (j = 0; j < sizeof(F08_SUFFIXES) / sizeof(char *); ++j) {
+                        add(prefixes[i], base, F08_SUFFIXES[j], 0, s->code);
+                        add(prefixes[i], base, F08_SUFFIXES[j], 1, s->code);
+
+                        snprintf(suffix, sizeof(suffix), "%s_",
+                                 F08_SUFFIXES[j]);
+                        add(prefixes[i], base, suffix, 1, s->code);
+                }
+        }
+}
+
+/*
+ * Compares spellings by name.
+ */
+static int compare_names(const void *const a, const void *const b)
+{
+        const struct spelling *x = a, *y = b;
+
+        return strcmp(x->name, y->name);
+}
+
+/*
+ * Removes duplicate spellings. Returns 0 if a spelling is given to two
+ * different MPI collectives, 1 otherwise.
+ */
+static int unique(void)
+{
+        int i, n = 0;
+
+        qsort(spellings, nb_spellings, sizeof(*spellings), &compare_names);
+
+        for (i = 0; i < nb_spellings; ++i) {
+                if (n > 0 && strcmp(spellings[n - 1].name,
+                                    spellings[i].name) == 0) {
+                        if (spellings[n - 1].code != spellings[i].code) {
+                                fprintf(stderr, "%s: ambiguous spelling\n",
+                                        spellings[i].name);
+                                return 0;
+                        }
+
+                        continue;
+                }
+
+                spellings[n++] = spellings[i];
+        }
+
+        nb_spellings = n;
+
+        return 1;
+}
+
+/*
+ * Returns the smallest power of 2 greater than or equal to n.
+ */
+static unsigned int power_of_2(const unsigned int n)
+{
+        unsigned int res = 1U;
+
+        while (res < n)
+                res = res << 1;
+
+        return res;
+}
+
+/*
+ * Bucket of spellings, with the same hash with seed 0.
+ */
+struct bucket {
+        int index;              /* Index of the bucket */
+        int size;               /* Number of spellings */
+        int *members;           /* Indices of the spellings */
+};
+
+/*
+ * Compares buckets by decreasing size.
+ */
+static int compare_buckets(const void *const a, const void *const b)
+{
+        const struct bucket *x = a, *y = b;
+
+        return y->size - x->size;
+}
+
+/*
+ * Builds the perfect hash table of size slots and nb_buckets buckets with the
+ * hash and displace method: buckets are placed from the largest, each with the
+ * first seed sending all its spellings to distinct empty slots, and buckets of
+ * a single spelling take the next empty slot directly. Fills displacements and
+ * slots with the index of its spelling, or -1. Returns 1 on success, 0
+ * otherwise.
+ */
+static int build(const unsigned int size, const unsigned int nb_buckets,
+                 int *const displacements, int *const slots)
+{
+        struct bucket *buckets = calloc(nb_buckets, sizeof(*buckets));
+        int *members = malloc(nb_spellings * sizeof(*members));
+        int *tried = malloc(size * sizeof(*tried));
+        unsigned int b, free_slot = 0U, slot;
+        int i, j, seed, attempt = 0, ok = 1;
+
+        if (buckets == NULL || members == NULL || tried == NULL) {
+                perror("malloc");
+                exit(EXIT_FAILURE);
+        }
+
+        for (b = 0U; b < nb_buckets; ++b)
+                buckets[b].index = b;
+
+        for (i = 0; i < nb_spellings; ++i)
+                buckets[mpicoll_hash(spellings[i].name, 0U)
+                        & (nb_buckets - 1U)].size += 1;
+
+        for (b = 0U, j = 0; b < nb_buckets; ++b) {
+                buckets[b].members = members + j;
+                j = j + buckets[b].size;
+                buckets[b].size = 0;
+        }
+
+        for (i = 0; i < nb_spellings; ++i) {
+                b = mpicoll_hash(spellings[i].name, 0U) & (nb_buckets - 1U);
+                buckets[b].members[buckets[b].size++] = i;
+        }
+
+        qsort(buckets, nb_buckets, sizeof(*buckets), &compare_buckets);
+
+        for (slot = 0U; slot < size; ++slot) {
+                slots[slot] = -1;
+                tried[slot] = 0;
+        }
+
+        for (b = 0U; b < nb_buckets && ok; ++b) {
+                displacements[buckets[b].index] = 0;
+
+                if (buckets[b].size == 0)
+                        continue;
+
+                if (buckets[b].size == 1) {
+                        while (slots[free_slot] >= 0)
+                                free_slot = free_slot + 1U;
+
+                        slots[free_slot] = buckets[b].members[0];
+                        displacements[buckets[b].index] = -(int) free_slot - 1;
+                        continue;
+                }
+
+                /* tried holds the last attempt that took each slot */
+                for (seed = 1; seed < MAX_TRIES; ++seed) {
+                        attempt = attempt + 1;
+
+                        for (j = 0; j < buckets[b].size; ++j) {
+                                slot = mpicoll_hash(spellings[
+                                       buckets[b].members[j]].name, seed)
+                                       & (size - 1U);
+
+                                if (slots[slot] >= 0 || tried[slot] == attempt)
+                                        break;
+
+                                tried[slot] = attempt;
+                        }
+
+                        if (j == buckets[b].size)
+                                break;
+                }
+
+                if (seed == MAX_TRIES) {
+                        ok = 0;
+                        break;
+                }
+
+                for (j = 0; j < buckets[b].size; ++j)
+                        slots[mpicoll_hash(spellings[buckets[b].members[j]]
+                                           .name, seed) & (size - 1U)]
+                                = buckets[b].members[j];
+
+                displacements[buckets[b].index] = seed;
+        }
+
+        free(tried);
+        free(members);
+        free(buckets);
+
+        return ok;
+}
+
+/*
+ * Writes the table of size slots and nb_buckets buckets to file.
+ */
+static void write_table(FILE *const file, const unsigned int size,
+                        const unsigned int nb_buckets,
+                        const int *const displacements, const int *const slots)
+{
+        unsigned int i;
+
+        fprintf(file, "/* Generated by utils/gentable.c from "
+                "MPI_collectives.def, do not edit */\n");
+        fprintf(file, "#ifndef MPICOLL_TABLE_H\n#define MPICOLL_TABLE_H\n\n");
+        fprintf(file, "#define MPICOLL_TABLE_SIZE %uU\n", size);
+        fprintf(file, "#define MPICOLL_TABLE_BUCKETS %uU\n\n", nb_buckets);
+
+        fprintf(file, "static const int MPICOLL_TABLE_DISPLACEMENTS[] = {\n");
+
+        for (i = 0U; i < nb_buckets; ++i)
+                fprintf(file, "        %d,\n", displacements[i]);
+
+        fprintf(file, "};\n\n");
+        fprintf(file, "static const struct mpicoll_table_entry "
+                "MPICOLL_TABLE[] = {\n");
+
+        for (i = 0U; i < size; ++i) {
+                if (slots[i] < 0)
+                        fprintf(file, "        { NULL, -1 },\n");
+                else
+                        fprintf(file, "        { \"%s\", %d },\n",
+                                spellings[slots[i]].name,
+                                spellings[slots[i]].code);
+        }
+
+        fprintf(file, "};\n\n#endif /* mpicoll_table.h */\n");
+}
+
+int main(int argc, char *argv[])
+{
+        unsigned int size, nb_buckets;
+        int *displacements, *slots;
+        FILE *file;
+        int i;
+
+        if (argc != 2) {
+                fprintf(stderr, "Usage: %s <output header>\n", argv[0]);
+                return EXIT_FAILURE;
+        }
+
+        for (i = 0; i < NB_NAMES; ++i)
+                add_spellings(&(NAMES[i]));
+
+        if (!unique())
+                return EXIT_FAILURE;
+
+        size = power_of_2(nb_spellings);
+        nb_buckets = power_of_2((nb_spellings + 3) / 4);
+        displacements = malloc(nb_buckets * sizeof(*displacements));
+        slots = malloc(size * sizeof(*slots));
+
+        if (displacements == NULL || slots == NULL) {
+                perror("malloc");
+                return EXIT_FAILURE;
+        }
+
+        if (!build(size, nb_buckets, displacements, slots)) {
+                fprintf(stderr, "%s: no perfect hash found\n", argv[0]);
+                return EXIT_FAILURE;
+        }
+
+        file = fopen(argv[1], "w");
+
+        if (file == NULL) {
+                perror(argv[1]);
+                return EXIT_FAILURE;
+        }
+
+        write_table(file, size, nb_buckets, displacements, slots);
+
+        if (fclose(file) != 0) {
+                perror(argv[1]);
+                remove(argv[1]);
+                return EXIT_FAILURE;
+        }
+
+        free(slots);
+        free(displacements);
+
+        return EXIT_SUCCESS;
+}
@@ -1,9 +1,17 @@
 #!/bin/sh
 #
+# Renders each graph of the dump files given as arguments, or of the .dot files
+# of the current directory, to SVG. Graphs after the first one of a file are
+# numbered, as in loop.c.1234abcd.mpicoll.dot.2.svg.
 
-for i in $(ls *.dot)
+if [ $# -eq 0 ]
+then
+    set -- *.dot
+fi
+
+for i in "$@"
 do
-    dot -Tsvg "${i}" > "$(basename ${i} '.dot').svg"
+    dot -Tsvg -O "${i}"
 done
 
 exit 0
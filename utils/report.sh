@@ -0,0 +1,81 @@
+#!/bin/sh
+#
+# Merges report files written with -fplugin-arg-libmpiplugin-report=<dir> into
+# a single report, either as JSON lines or as a SARIF log.
+#
+# Usage: report.sh [-f jsonl|sarif] [-o <output>] <report file or directory>...
+#
+# Directories are searched for report files. Findings with the same fingerprint,
+# such as those of inline functions of headers analysed in several translation
+# units, are kept once. The number of findings and duplicates is printed on the
+# standard error.
+
+format=sarif
+output=-
+suffix=.mpicoll.jsonl
+
+usage() {
+    echo "Usage: $0 [-f jsonl|sarif] [-o <output>] <report file or directory>..." >&2
+    exit 1
+}
+
+while getopts "f:o:h" opt
+do
+    case "${opt}" in
+        f) format="${OPTARG}" ;;
+        o) output="${OPTARG}" ;;
+        *) usage ;;
+    esac
+done
+
+shift $((OPTIND - 1))
+
+case "${format}" in
+    jsonl|sarif) ;;
+    *)           echo "$0: unknown format ${format}" >&2
+                 exit 1 ;;
+esac
+
+if [ $# -eq 0 ]
+then
+    usage
+fi
+
+if [ "${output}" != "-" ]
+then
+    exec > "${output}" || exit 1
+fi
+
+find "$@" -type f -name "*${suffix}" -exec cat {} + \
+| awk -v format="${format}" '
+    BEGIN {
+        if (format == "sarif") {
+            printf("{\"version\":\"2.1.0\",")
+            printf("\"$schema\":\"https://json.schemastore.org/sarif-2.1.0.json\",")
+            printf("\"runs\":[{\"tool\":{\"driver\":{\"name\":\"mpicoll\",")
+            printf("\"rules\":[{\"id\":\"mpicoll/possible-deadlock\",")
+            printf("\"shortDescription\":{\"text\":")
+            printf("\"MPI collectives that may not be called by all ranks\"}}]}},")
+            printf("\"results\":[")
+        }
+    }
+    match($0, /"mpicollFinding\/v1":"[0-9a-f]+"/) {
+        key = substr($0, RSTART, RLENGTH)
+        if (key in seen) {
+            duplicates += 1
+            next
+        }
+        seen[key] = 1
+        if (format == "sarif" && findings > 0)
+            printf(",")
+        if (format == "sarif")
+            printf("\n%s", $0)
+        else
+            print
+        findings += 1
+    }
+    END {
+        if (format == "sarif")
+            printf("\n]}]}\n")
+        printf("%d findings, %d duplicates\n", findings, duplicates) > "/dev/stderr"
+    }'
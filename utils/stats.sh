@@ -0,0 +1,80 @@
+#!/bin/sh
+#
+# Prints the functions most expensive to analyse from statistics files written
+# with -fplugin-arg-libmpiplugin-stats=<file>.
+#
+# Usage: stats.sh [-n <count>] [-s time|memory|blocks] <stats file>...
+#
+# Records of the same function in the same file, such as inline functions of
+# headers analysed in several translation units, are merged: times are summed
+# and the largest memory is kept.
+
+count=20
+sort_key=time
+
+while getopts "n:s:h" opt
+do
+    case "${opt}" in
+        n) count="${OPTARG}" ;;
+        s) sort_key="${OPTARG}" ;;
+        *) echo "Usage: $0 [-n <count>] [-s time|memory|blocks] <stats file>..." >&2
+           exit 1 ;;
+    esac
+done
+
+shift $((OPTIND - 1))
+
+case "${sort_key}" in
+    time)   column=3 ;;
+    memory) column=4 ;;
+    blocks) column=5 ;;
+    *)      echo "$0: unknown sort key ${sort_key}" >&2
+            exit 1 ;;
+esac
+
+if [ $# -eq 0 ]
+then
+    echo "Usage: $0 [-n <count>] [-s time|memory|blocks] <stats file>..." >&2
+    exit 1
+fi
+
+# Phase names, as timevar names in include/phases.def
+phases=$(sed -n 's/^DEF_MPICOLL_PHASE([^,]*, "mpicoll \(.*\)")$/\1/p' \
+             "$(dirname "$0")/../include/phases.def" | tr '\n' '\t')
+
+printf "%10s %10s %6s %8s %6s  %-16s %s\n" "time (ms)" "memory (B)" "count" \
+       "blocks" "groups" "slowest phase" "function"
+
+awk -F '\t' -v phases="${phases}" '
+    BEGIN { split(phases, names, "\t") }
+    $1 != "mpicoll2" { next }
+    {
+        key = $2 "\t" $3
+        time[key] += $(NF - 1)
+        count[key] += 1
+        if ($NF > memory[key])
+            memory[key] = $NF
+        blocks[key] = $4
+        groups[key] = $7
+        for (i = 8; i < NF - 1; ++i)
+            phase[key, i - 7] += $i
+        nb_phases = NF - 9
+    }
+    END {
+        for (key in time) {
+            slowest = 1
+            for (i = 2; i <= nb_phases; ++i)
+                if (phase[key, i] > phase[key, slowest])
+                    slowest = i
+            split(key, fields, "\t")
+            printf("%s\t%s\t%.3f\t%d\t%d\t%d\t%d\t%s\n", fields[1], fields[2],
+                   time[key] / 1000, memory[key], blocks[key], count[key],
+                   groups[key], names[slowest])
+        }
+    }' "$@" \
+| sort -t "$(printf '\t')" -k "${column},${column}" -g -r \
+| head -n "${count}" \
+| awk -F '\t' '{ printf("%10s %10s %6s %8s %6s  %-16s %s() in %s\n", $3, $4,
+                        $6, $5, $7, $8, $2, $1) }'
+
+exit 0
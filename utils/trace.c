@@ -0,0 +1,396 @@
+/*
+ * MPI collective trace reader, finding the first point where ranks diverge.
+ * Copyright (C) 2023-2025 Antoni Blanche
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include <unistd.h>
+
+#include "mpicoll_trace.h"
+#include "sitemap.h"
+
+/*
+ * Name of each MPI collective.
+ */
+#define DEF_MPI_COLLECTIVES(CODE, NAME) NAME,
+static const char *const MPI_COLLECTIVE_NAME[] = {
+#include "MPI_collectives.def"
+};
+#undef DEF_MPI_COLLECTIVES
+
+#define NB_CODES (int) (sizeof(MPI_COLLECTIVE_NAME) / sizeof(char *))
+
+/*
+ * A record of a rank.
+ */
+struct entry {
+        uint32_t rank;
+        struct mpicoll_trace_record record;
+};
+
+/*
+ * All records read, and the number of ranks.
+ */
+static struct entry *entries = NULL;
+static size_t nb_entries = 0;
+static uint32_t nb_ranks = 0;
+
+/*
+ * Program the site IDs are looked up in, if any.
+ */
+static const char *program = NULL;
+
+/*
+ * Prints the MPI collective of record and its site.
+ */
+static void print_site(const struct mpicoll_trace_record *const record)
+{
+        struct sitemap_site s;
+
+        if (record->code >= 0 && record->code < NB_CODES)
+                printf("%s", MPI_COLLECTIVE_NAME[record->code]);
+        else
+                printf("code %d", record->code);
+
+        if (program == NULL || !sitemap_lookup_file(program, record->site,
+                                                    &s))
+                printf(" at site %#x", record->site);
+        else
+                printf(" in %s() at %s:%d", s.function, s.file, s.line);
+}
+
+/*
+ * Prints the communicator with key.
+ */
+static void print_comm(const uint64_t key)
+{
+        if (key >> 32 == 0)
+                printf("intercommunicator led by rank %d", (int32_t) key);
+        else
+                printf("communicator %u led by rank %d",
+                       (unsigned int) (key >> 32), (int32_t) key);
+}
+
+/*
+ * Reads the records of the trace file at path. Returns 1 on success, 0
+ * otherwise.
+ */
+static int read_trace(const char *const path)
+{
+        struct mpicoll_trace_header header;
+        struct mpicoll_trace_record *records;
+        struct entry *res;
+        uint64_t first, i;
+        FILE *file;
+
+        file = fopen(path, "rb");
+
+        if (file == NULL) {
+                perror(path);
+                return 0;
+        }
+
+        if (fread(&header, sizeof(header), 1, file) != 1
+            || header.magic != MPICOLL_TRACE_MAGIC || header.capacity == 0
+            || (header.capacity & (header.capacity - 1)) != 0
+            || header.rank >= header.size) {
+                fprintf(stderr, "%s: not a MPI collective trace\n", path);
+                fclose(file);
+                return 0;
+        }
+
+        records = calloc(header.capacity, sizeof(*records));
+        res = realloc(entries, (nb_entries + header.capacity) * sizeof(*res));
+
+        if (records == NULL || res == NULL) {
+                fprintf(stderr, "%s: out of memory\n", path);
+                free(records);
+                fclose(file);
+                return 0;
+        }
+
+        entries = res;
+
+        /* A rank killed while growing the file leaves it short */
+        fread(records, sizeof(*records), header.capacity, file);
+        fclose(file);
+
+        first = header.head > header.capacity ? header.head - header.capacity
+                                              : 0;
+
+        for (i = 0; i < header.capacity; ++i) {
+                if (records[i].seq == 0 || records[i].seq - 1 < first
+                    || ((records[i].seq - 1) & (header.capacity - 1)) != i)
+                        continue;
+
+                entries[nb_entries].rank = header.rank;
+                entries[nb_entries].record = records[i];
+                nb_entries = nb_entries + 1;
+        }
+
+        if (header.size > nb_ranks)
+                nb_ranks = header.size;
+
+        free(records);
+
+        return 1;
+}
+
+/*
+ * Compares entries by communicator, call number, then rank.
+ */
+static int compare_calls(const void *const a, const void *const b)
+{
+        const struct entry *x = a, *y = b;
+
+        if (x->record.comm != y->record.comm)
+                return x->record.comm < y->record.comm ? -1 : 1;
+
+        if (x->record.count != y->record.count)
+                return x->record.count < y->record.count ? -1 : 1;
+
+        if (x->rank != y->rank)
+                return x->rank < y->rank ? -1 : 1;
+
+        return 0;
+}
+
+/*
+ * Prints the last MPI collective recorded by each rank.
+ */
+static void print_last(void)
+{
+        struct entry **last;
+        size_t i;
+        uint32_t r;
+
+        last = calloc(nb_ranks, sizeof(*last));
+
+        if (last == NULL)
+                return;
+
+        for (i = 0; i < nb_entries; ++i) {
+                r = entries[i].rank;
+
+                if (last[r] == NULL || last[r]->record.seq
+                                       < entries[i].record.seq)
+                        last[r] = &(entries[i]);
+        }
+
+        for (r = 0; r < nb_ranks; ++r) {
+                printf("rank %u: ", r);
+
+                if (last[r] == NULL) {
+                        printf("no MPI collective recorded\n");
+                        continue;
+                }
+
+                printf("last called ");
+                print_site(&(last[r]->record));
+                printf(", call %u on ", last[r]->record.count);
+                print_comm(last[r]->record.comm);
+                printf("\n");
+        }
+
+        free(last);
+}
+
+/*
+ * Fills counts with the last call number of each rank in the entries from
+ * begin to end, all on the same communicator, or -1 if a rank did not call any
+ * MPI collective on it. Entries must be sorted by compare_calls().
+ */
+static void last_counts(const size_t begin, const size_t end,
+                        long long *const counts)
+{
+        size_t i;
+        uint32_t r;
+
+        for (r = 0; r < nb_ranks; ++r)
+                counts[r] = -1;
+
+        for (i = begin; i < end; ++i)
+                counts[entries[i].rank] = entries[i].record.count;
+}
+
+/*
+ * Compares call numbers.
+ */
+static int compare_counts(const void *const a, const void *const b)
+{
+        const long long *x = a, *y = b;
+
+        return (*x > *y) - (*x < *y);
+}
+
+/*
+ * Prints the earliest call where ranks diverge, either because they called
+ * different MPI collectives or because some ranks of the communicator stopped
+ * right before it. Intercommunicators are skipped. Returns 1 if a divergence
+ * is found, 0 otherwise.
+ */
+static int print_divergence(void)
+{
+        size_t i, j, k, end, begin = 0, first = 0, last = 0;
+        uint64_t time, first_time = UINT64_MAX;
+        long long *counts;
+        uint32_t r, nb_stops;
+        int diverge;
+
+        qsort(entries, nb_entries, sizeof(*entries), &compare_calls);
+        counts = malloc(nb_ranks * sizeof(*counts));
+
+        if (counts == NULL)
+                return 0;
+
+        for (i = 0; i < nb_entries; i = end) {
+                for (end = i; end < nb_entries && entries[end].record.comm
+                                                  == entries[i].record.comm;
+                     ++end)
+                        ;
+
+                /* Calls on intercommunicators cannot be told apart */
+                if (entries[i].record.comm >> 32 == 0)
+                        continue;
+
+                /* Ranks stop right before the call following their last one */
+                last_counts(i, end, counts);
+
+                for (r = 0, nb_stops = 0; r < nb_ranks; ++r) {
+                        if (counts[r] >= 0)
+                                counts[nb_stops++] = counts[r] + 1;
+                }
+
+                qsort(counts, nb_stops, sizeof(*counts), &compare_counts);
+
+                for (j = i, r = 0; j < end; j = k) {
+                        time = entries[j].record.time;
+                        diverge = 0;
+
+                        for (k = j + 1; k < end && entries[k].record.count
+                                                   == entries[j].record.count;
+                             ++k) {
+                                /* Sites may differ for the same call */
+                                if (entries[k].record.code
+                                    != entries[j].record.code)
+                                        diverge = 1;
+
+                                if (entries[k].record.time < time)
+                                        time = entries[k].record.time;
+                        }
+
+                        while (r < nb_stops
+                               && counts[r] < entries[j].record.count)
+                                r = r + 1;
+
+                        if (r < nb_stops
+                            && counts[r] == entries[j].record.count)
+                                diverge = 1;
+
+                        if (diverge && time < first_time) {
+                                first_time = time;
+                                begin = i;
+                                first = j;
+                                last = k;
+                        }
+                }
+        }
+
+        if (first_time == UINT64_MAX) {
+                free(counts);
+                return 0;
+        }
+
+        printf("ranks diverge at call %u on ", entries[first].record.count);
+        print_comm(entries[first].record.comm);
+        printf(":\n");
+
+        for (k = first; k < last; ++k) {
+                printf("  rank %u: ", entries[k].rank);
+                print_site(&(entries[k].record));
+                printf("\n");
+        }
+
+        for (end = begin; end < nb_entries && entries[end].record.comm
+                                              == entries[begin].record.comm;
+             ++end)
+                ;
+
+        last_counts(begin, end, counts);
+
+        for (r = 0; r < nb_ranks; ++r) {
+                if (counts[r] >= 0
+                    && counts[r] + 1 == entries[first].record.count)
+                        printf("  rank %u: did not call it\n", r);
+        }
+
+        free(counts);
+
+        return 1;
+}
+
+/*
+ * Prints usage.
+ */
+static void usage(const char *const name)
+{
+        fprintf(stderr, "Usage: %s [-e <program>] <trace file>...\n", name);
+}
+
+int main(int argc, char *argv[])
+{
+        int opt;
+        int i;
+
+        while ((opt = getopt(argc, argv, "e:h")) != -1) {
+                switch (opt) {
+                case 'e':
+                        program = optarg;
+                        break;
+                case 'h':
+                        usage(argv[0]);
+                        return EXIT_SUCCESS;
+                default:
+                        usage(argv[0]);
+                        return EXIT_FAILURE;
+                }
+        }
+
+        if (optind == argc) {
+                usage(argv[0]);
+                return EXIT_FAILURE;
+        }
+
+        /* Sites sharing an ID cannot be told apart */
+        if (program != NULL && !sitemap_check_file(program))
+                return EXIT_FAILURE;
+
+        for (i = optind; i < argc; ++i) {
+                if (!read_trace(argv[i]))
+                        return EXIT_FAILURE;
+        }
+
+        print_last();
+
+        if (!print_divergence())
+                printf("no divergence found\n");
+
+        free(entries);
+
+        return EXIT_SUCCESS;
+}